@@ -94,6 +94,7 @@ PYBRICKS_PYBRICKS_SRC_C = $(addprefix pybricks/,\
 	pybricks.c \
 	robotics/pb_module_robotics.c \
 	robotics/pb_type_drivebase.c \
+	robotics/pb_type_motiongroup.c \
 	robotics/pb_type_spikebase.c \
 	tools/pb_module_tools.c \
 	tools/pb_type_stopwatch.c \
@@ -172,6 +173,7 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	drv/reset/reset_stm32.c \
 	drv/resistor_ladder/resistor_ladder.c \
 	drv/sound/sound_stm32_hal_dac.c \
+	drv/sysfs.c \
 	drv/uart/uart_stm32f0.c \
 	drv/uart/uart_stm32f4_ll_irq.c \
 	drv/uart/uart_stm32l4_ll_dma.c \
@@ -196,6 +198,7 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	src/light/light_matrix.c \
 	src/logger.c \
 	src/main.c \
+	src/motion_group.c \
 	src/motor_process.c \
 	src/motor/servo_settings.c \
 	src/observer.c \
@@ -204,6 +207,7 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	src/protocol/nus.c \
 	src/protocol/pybricks.c \
 	src/servo.c \
+	src/sysid.c \
 	src/tacho.c \
 	src/task.c \
 	src/trajectory.c \
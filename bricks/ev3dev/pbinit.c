@@ -39,7 +39,6 @@ static pthread_t task_caller_thread;
 static void *task_caller(void *arg) {
     struct timespec ts;
     ts.tv_sec = 0;
-    ts.tv_nsec = PBIO_CONFIG_CONTROL_LOOP_TIME_MS * 1000000;
 
     while (!stopping_thread) {
         MP_THREAD_GIL_ENTER();
@@ -47,6 +46,13 @@ static void *task_caller(void *arg) {
         }
         MP_THREAD_GIL_EXIT();
 
+        // Poll at least once per control loop iteration, also if the loop
+        // time is shorter than usual.
+        uint32_t loop_time = pbio_control_settings_get_loop_time();
+        if (loop_time > PBIO_CONFIG_CONTROL_LOOP_TIME_MS) {
+            loop_time = PBIO_CONFIG_CONTROL_LOOP_TIME_MS;
+        }
+        ts.tv_nsec = loop_time * 1000000;
         clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, NULL);
         etimer_request_poll();
     }
@@ -18,6 +18,7 @@
 #include <pbsys/program_stop.h>
 #include <pbsys/status.h>
 
+#include "../../lib/pbio/drv/clock/clock_virtual.h"
 #include "../../lib/pbio/drv/virtual.h"
 
 #include "py/mpconfig.h"
@@ -145,6 +146,10 @@ void pb_virtualhub_poll(void) {
     // CPython runtime here in case MicroPython is running in a tight loop,
     // e.g. `while True: pass`.
     pb_assert(pbdrv_virtual_platform_poll());
+
+    // Simulated time has to move on even in a tight loop, otherwise loops
+    // that wait for the time to change would never end.
+    pbdrv_clock_virtual_advance();
 }
 
 // MICROPY_EVENT_POLL_HOOK
@@ -179,6 +184,15 @@ start:
         goto start;
     }
 
+    // There is nothing left to do at the current simulated time, so skip
+    // ahead instead of sleeping. This polls the timers, so there will be
+    // new events to handle.
+    if (pbdrv_clock_virtual_is_simulated()) {
+        pthread_sigmask(SIG_SETMASK, &origmask, NULL);
+        pbdrv_clock_virtual_advance();
+        goto start;
+    }
+
     struct timespec timeout = {
         .tv_sec = 0,
         .tv_nsec = 1000000,
@@ -194,9 +208,7 @@ start:
 }
 
 uint64_t pb_virtualhub_time_ns(void) {
-    uint64_t value;
-    pb_assert(pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value));
-    return value;
+    return pbdrv_clock_virtual_get_ns();
 }
 
 mp_uint_t pb_virtualhub_ticks_us(void) {
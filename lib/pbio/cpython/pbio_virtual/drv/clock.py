@@ -16,6 +16,14 @@ class VirtualClock:
     or ``pbdrv_clock_get_100us()`` is called.
     """
 
+    simulated: bool = False
+    """
+    When ``True``, time is kept by the C code instead of being read from
+    :attr:`nanoseconds` each time. See :class:`SimulatedClock`.
+
+    This value is read once when ``pbdrv_clock_init()`` is called.
+    """
+
     _thread_id: int
     _signum: int
 
@@ -125,3 +133,58 @@ class CountingClock(VirtualClock):
             self.nanoseconds += self._step_ns
 
         self.interrupt()
+
+
+class SimulatedClock(VirtualClock):
+    """
+    Clock implementation for deterministic simulations.
+
+    The time is only read once at startup and is then kept by the C code. It
+    advances by exactly *step* microseconds each time the runtime polls for
+    events and timers are serviced synchronously, so no signals are used and
+    no time is spent sleeping. Running the same program twice gives the same
+    results, regardless of how fast the computer is.
+
+    The :attr:`nanoseconds` attribute is kept up to date so that simulation
+    models can read it.
+    """
+
+    simulated = True
+
+    def __init__(self, start: int = 0, step: int = 1000) -> None:
+        """
+        Args:
+            start:
+                The starting time in microseconds.
+            step:
+                The number of microseconds to increase the clock time by each
+                time the clock is advanced.
+        """
+        super().__init__()
+        # convert microseconds to nanoseconds
+        self.nanoseconds = start * 1000
+        self.step_nanoseconds = step * 1000
+        self._advance_callbacks = []
+
+    def subscribe_advance(self, callback) -> None:
+        """
+        Subscribes to time advance events.
+
+        Args:
+            callback:
+                A function that will be called with the new clock time in
+                nanoseconds each time :meth:`on_advance` is called.
+        """
+        self._advance_callbacks.append(callback)
+
+    def on_advance(self, nanoseconds: int) -> None:
+        """
+        Called when the C code advances the simulated time.
+
+        Args:
+            nanoseconds: The new clock time in nanoseconds.
+        """
+        self.nanoseconds = nanoseconds
+
+        for callback in self._advance_callbacks:
+            callback(nanoseconds)
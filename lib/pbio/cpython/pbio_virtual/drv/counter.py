@@ -1,24 +1,23 @@
 # SPDX-License-Identifier: MIT
 # Copyright (c) 2022 The Pybricks Authors
 
+import ctypes
 
-class VirtualCounter:
-    rotations: int = 0
-    """
-    Provides the rotations returned by ``pbdrv_counter_virtual_cpython_get_angle()``.
 
-    CPython code should write to this attribute to simulate the current value
-    and the PBIO driver will read this attribute.
+class pbdrv_counter_virtual_cpython_state_t(ctypes.Structure):
     """
+    State that is shared with ``counter_virtual_cpython.c``.
 
-    millidegrees: int = 0
+    This must match the C struct of the same name.
     """
-    Provides the millidegrees returned by ``pbdrv_counter_virtual_cpython_get_angle()``.
 
-    CPython code should write to this attribute to simulate the current value
-    and the PBIO driver will read this attribute.
-    """
+    _fields_ = [
+        ("rotations", ctypes.c_int32),
+        ("millidegrees", ctypes.c_int32),
+    ]
+
 
+class VirtualCounter:
     millidegrees_abs: int = 0
     """
     Provides the absolute angle returned by ``pbdrv_counter_virtual_cpython_get_abs_angle()``.
@@ -33,3 +32,50 @@ class VirtualCounter:
         def millidegrees_abs(self):
             raise PbioError(PbioErrorCode.NOT_SUPPORTED)
     """
+
+    def __init__(self) -> None:
+        self._state = pbdrv_counter_virtual_cpython_state_t()
+
+    @property
+    def rotations(self) -> int:
+        """
+        Provides the rotations returned by ``pbdrv_counter_virtual_cpython_get_angle()``.
+
+        CPython code should write to this attribute to simulate the current value.
+        The PBIO driver reads it directly from memory, without calling CPython.
+        """
+        return self._state.rotations
+
+    @rotations.setter
+    def rotations(self, value: int) -> None:
+        self._state.rotations = value
+
+    @property
+    def millidegrees(self) -> int:
+        """
+        Provides the millidegrees returned by ``pbdrv_counter_virtual_cpython_get_angle()``.
+
+        CPython code should write to this attribute to simulate the current value.
+        The PBIO driver reads it directly from memory, without calling CPython.
+        """
+        return self._state.millidegrees
+
+    @millidegrees.setter
+    def millidegrees(self, value: int) -> None:
+        self._state.millidegrees = value
+
+    @property
+    def state(self) -> int:
+        """
+        Gets the address of the ``pbdrv_counter_virtual_cpython_state_t`` structure.
+
+        This property is read once when ``pbdrv_counter_virtual_cpython_init()``
+        is called. Counters that compute :attr:`rotations` and :attr:`millidegrees`
+        on demand must return 0 instead, so the PBIO driver reads the attributes
+        each time.
+
+        The structure may only be written from callbacks that are called by
+        PBIO, such as poll events, since the PBIO driver reads it without
+        holding the GIL.
+        """
+        return ctypes.addressof(self._state)
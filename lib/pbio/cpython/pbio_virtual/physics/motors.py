@@ -2,7 +2,7 @@
 # Copyright (c) 2022 The Pybricks Authors
 
 from numpy import array
-from math import degrees
+from math import degrees, pi
 
 from .simulation import SimulationModel
 
@@ -46,3 +46,14 @@ class SimpleMotor(SimulationModel):
 
         # Return the state derivative.
         return array([alpha_dot, alpha_dotdot])
+
+    def linear_model(self, u):
+        # The model is linear for each duty cycle, including coast.
+        (duty,) = u
+        damping = self.c0 / 4 if duty == self.COAST_DUTY else self.c0
+        gain = 0.0 if duty == self.COAST_DUTY else self.c1
+
+        A = array([[0, 1], [0, -damping]])
+        B = array([[0], [gain]])
+        C = array([[180000 / pi, 0]])
+        return A, B, C
@@ -1,7 +1,7 @@
 # SPDX-License-Identifier: MIT
 # Copyright (c) 2022 The Pybricks Authors
 
-from numpy import array, zeros, concatenate
+from numpy import arange, array, concatenate, eye, searchsorted, zeros
 from abc import ABC, abstractmethod
 
 
@@ -10,6 +10,10 @@ class SimulationModel(ABC):
 
     This class provides generic simulation code. Each subclass must provide
     its own equations of motion by overriding the state change function.
+
+    Subclasses that are linear for a given input may also override
+    :meth:`linear_model`. Then the simulation is evaluated with a few matrix
+    products per segment instead of one Python function call per time step.
     """
 
     # These tuples should be used to name all the relevant signals.
@@ -20,6 +24,10 @@ class SimulationModel(ABC):
     # Simulation time step (expressed in seconds).
     DT = 0.0001
 
+    # Number of most recent samples that are kept for interpolation. Older
+    # samples are discarded so that long simulations use constant memory.
+    HISTORY_SIZE = 10000
+
     def __init__(self, t0=0, x0=None):
         """Initializes the system with initial conditions.
 
@@ -33,14 +41,61 @@ class SimulationModel(ABC):
         self.m = len(self.INPUTS)
         self.p = len(self.OUTPUTS)
 
-        # Empty buffers to hold results, starting with the initial time/state.
-        self.times = array([t0])
-        self.states = zeros((self.n, 1)) if x0 is None else x0.reshape(self.n, 1)
-        self.outputs = self.output(t0, x0).reshape(self.p, 1)
-
-        # Empty buffers to hold externally set input data.
-        self.input_values = zeros((self.m, 1))
-        self.input_times = array([t0])
+        x0 = zeros(self.n) if x0 is None else x0.reshape(self.n)
+
+        # Preallocated buffers to hold results. Twice the history size is
+        # allocated so that old samples only need to be discarded once every
+        # HISTORY_SIZE samples.
+        capacity = 2 * self.HISTORY_SIZE
+        self._times = zeros(capacity)
+        self._states = zeros((self.n, capacity))
+        self._outputs = zeros((self.p, capacity))
+        self._size = 0
+
+        # Start with the initial time/state.
+        self._append(array([t0]), x0.reshape(self.n, 1), self.output(t0, x0).reshape(self.p, 1))
+
+        # Externally set input, used until something else is set.
+        self.input_time = t0
+        self.input_value = zeros(self.m)
+
+        # Discrete time step matrices for each linear model, see _powers().
+        self._linear_cache = {}
+
+    @property
+    def times(self):
+        """Time of each recent sample (array: samples)."""
+        return self._times[: self._size]
+
+    @property
+    def states(self):
+        """State vector at each recent sample (array: n x samples)."""
+        return self._states[:, : self._size]
+
+    @property
+    def outputs(self):
+        """Output vector at each recent sample (array: p x samples)."""
+        return self._outputs[:, : self._size]
+
+    def _append(self, times, states, outputs):
+        """Adds up to HISTORY_SIZE samples to the history, discarding old ones
+        if needed."""
+        count = times.size
+
+        if self._size + count > self._times.size:
+            # Keep only the samples needed for interpolation.
+            keep = min(self._size, max(self.HISTORY_SIZE - count, 1))
+            start = self._size - keep
+            self._times[:keep] = self._times[start : self._size]
+            self._states[:, :keep] = self._states[:, start : self._size]
+            self._outputs[:, :keep] = self._outputs[:, start : self._size]
+            self._size = keep
+
+        end = self._size + count
+        self._times[self._size : end] = times
+        self._states[:, self._size : end] = states
+        self._outputs[:, self._size : end] = outputs
+        self._size = end
 
     def actuate(self, t, u):
         """Sets the actuation state of the system. This will be used by
@@ -50,8 +105,8 @@ class SimulationModel(ABC):
             t (float): Current time.
             u (array): Control signal vector.
         """
-        self.input_times = concatenate((self.input_times, array([t])))
-        self.input_values = concatenate((self.input_values, u.reshape(self.m, 1)), axis=1)
+        self.input_time = t
+        self.input_value = u.reshape(self.m)
 
     def simulate(self, time_end):
         """Simulates the system until time_end, subject to the ongoing input.
@@ -61,34 +116,37 @@ class SimulationModel(ABC):
 
         Arguments:
             te (float): End time.
-
-        Returns:
-            tuple: Time (array: 1 x samples) and
-                   state vector at all time samples (n x samples).
         """
 
-        # Time samples for this segment
-        t0 = self.times[-1]
-        nsamples = int((time_end - t0) / self.DT) + 1
-        times = array([t0 + i * self.DT for i in range(nsamples)])
-
         # Continue using last input.
-        u = self.input_values[:, -1]
-
-        # Create empty state vector samples
-        states = zeros((self.n, nsamples))
-        outputs = zeros((self.p, nsamples))
-
-        # Start at current state
-        state = self.states[:, -1]
-
-        # Evaluate RK4 integration for all time steps
-        for i, t in enumerate(times):
-
-            # Save the state and output
-            states[:, i] = state
-            outputs[:, i] = self.output(t, state)
-
+        u = self.input_value
+        model = self.linear_model(u)
+
+        # Simulate long segments in chunks of at most HISTORY_SIZE samples, so
+        # memory use does not depend on how far ahead the simulation goes.
+        nsamples = int((time_end - self._times[self._size - 1]) / self.DT)
+        while nsamples > 0:
+            count = min(nsamples, self.HISTORY_SIZE)
+            nsamples -= count
+
+            # Time samples for this chunk, starting at the last known sample.
+            t0 = self._times[self._size - 1]
+            times = t0 + arange(1, count + 1) * self.DT
+            state = self._states[:, self._size - 1]
+
+            if model is None:
+                states, outputs = self._simulate_rk4(times, state, u)
+            else:
+                states, outputs = self._simulate_linear(model, count, state, u)
+
+            self._append(times, states, outputs)
+
+    def _simulate_rk4(self, times, state, u):
+        """Evaluates RK4 integration one time step at a time."""
+        states = zeros((self.n, times.size))
+        outputs = zeros((self.p, times.size))
+
+        for i, t in enumerate(times - self.DT):
             # Single RK4 step to evaluate the next state.
             k1 = self.state_change(t, state, u)
             k2 = self.state_change(t + self.DT / 2, state + self.DT * k1 / 2, u)
@@ -96,10 +154,59 @@ class SimulationModel(ABC):
             k4 = self.state_change(t + self.DT, state + self.DT * k3, u)
             state = state + self.DT / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
 
-        # Concatenate results
-        self.times = concatenate((self.times, times))
-        self.states = concatenate((self.states, states), axis=1)
-        self.outputs = concatenate((self.outputs, outputs), axis=1)
+            # Save the state and output
+            states[:, i] = state
+            outputs[:, i] = self.output(t + self.DT, state)
+
+        return states, outputs
+
+    def _powers(self, A, B, count):
+        """Gets the first count + 1 powers of the discrete step matrix, where
+        count is at most HISTORY_SIZE.
+
+        The input is constant during a segment, so it is added to the state
+        vector. Then each time step is a multiplication by the same matrix:
+
+            [x(k+1)]   [Ad Bd] [x(k)]
+            [u     ] = [0  I ] [u   ]
+
+        where Ad and Bd give the same result as one RK4 step of the linear
+        system dx/dt = A x + B u.
+        """
+        key = (A.tobytes(), B.tobytes())
+        powers = self._linear_cache.get(key)
+
+        if powers is None:
+            # Expand the RK4 step for a linear system.
+            h = self.DT
+            hA = h * A
+            hA2 = hA @ hA
+            hA3 = hA2 @ hA
+            Ad = eye(self.n) + hA + hA2 / 2 + hA3 / 6 + hA3 @ hA / 24
+            Bd = h * (eye(self.n) + hA / 2 + hA2 / 6 + hA3 / 24) @ B
+
+            step = eye(self.n + self.m)
+            step[: self.n, : self.n] = Ad
+            step[: self.n, self.n :] = Bd
+            powers = array([eye(self.n + self.m), step])
+
+        # Extend the table by doubling, so it rarely needs to grow, but never
+        # beyond the longest chunk that is simulated at once.
+        while powers.shape[0] <= count:
+            powers = concatenate((powers, powers[1:] @ powers[-1]))[: self.HISTORY_SIZE + 1]
+
+        self._linear_cache[key] = powers
+        return powers
+
+    def _simulate_linear(self, model, nsamples, state, u):
+        """Evaluates all time steps of a linear model at once."""
+        A, B, C = model
+        powers = self._powers(A, B, nsamples)
+
+        # Evaluate each step from the initial state, as one stacked product.
+        z0 = concatenate((state, u))
+        states = (powers[1 : nsamples + 1] @ z0)[:, : self.n].T
+        return states, C @ states
 
     @abstractmethod
     def state_change(self, t, x, u):
@@ -130,6 +237,26 @@ class SimulationModel(ABC):
         """
         return zeros(self.p)
 
+    def linear_model(self, u):
+        """Gets the linear, time-invariant equivalent of the system.
+
+        This may be overridden if the equations of motion and the output are
+        linear while the input is constant, such that:
+
+            dx/dt = A x + B u
+            y = C x
+
+        and they match :meth:`state_change` and :meth:`output`.
+
+        Arguments:
+            u (array): Current control signal.
+
+        Returns:
+            tuple: Matrices A (n x n), B (n x m), and C (p x n), or None if
+                   the system has to be simulated with :meth:`state_change`.
+        """
+        return None
+
     def get_output_at_time(self, time, tolerance):
         """Gets the system output at a particular time.
 
@@ -142,15 +269,21 @@ class SimulationModel(ABC):
         Returns:
             array: The output vector.
         """
+        times = self.times
+
         # If time is in the past, interpolate from available results.
-        if time < self.times[-1]:
+        if time < times[-1]:
 
             # Find first index larger than given time, which always exists.
-            i = next(i for i, t in enumerate(self.times) if t > time)
+            i = searchsorted(times, time, side="right")
+
+            # Anything older than the history gets the oldest sample.
+            if i == 0:
+                return self._outputs[:, 0]
 
             # Interpolate output in time
-            ratio = (time - self.times[i - 1]) / (self.times[i] - self.times[i - 1])
-            return self.outputs[:, i - 1] + ratio * (self.outputs[:, i] - self.outputs[:, i - 1])
+            ratio = (time - times[i - 1]) / (times[i] - times[i - 1])
+            return self._outputs[:, i - 1] + ratio * (self._outputs[:, i] - self._outputs[:, i - 1])
 
         # Return latest available data.
-        return self.outputs[:, -1]
+        return self._outputs[:, self._size - 1]
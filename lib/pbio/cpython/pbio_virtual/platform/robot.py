@@ -4,7 +4,8 @@
 from ..drv.button import VirtualButtons
 from ..drv.battery import VirtualBattery
 from ..drv.led import VirtualLed
-from ..drv.clock import CountingClock
+from ..drv.clock import SimulatedClock
+from ..drv.counter import VirtualCounter as SharedVirtualCounter
 from ..drv.ioport import (
     VirtualIOPort,
     PortId,
@@ -60,10 +61,14 @@ class VirtualMotorDriver:
         self.coasting = False
 
 
-class VirtualCounter:
+class VirtualCounter(SharedVirtualCounter):
     """
     Virtual counter driver implementation, with optionally a (simulated)
     dc motor with rotation sensors attached to it.
+
+    The angle only changes when the simulated time advances, so it is
+    computed once per step with :meth:`update` and shared with the PBIO
+    driver through memory.
     """
 
     def get_counter_data(self):
@@ -89,23 +94,22 @@ class VirtualCounter:
         return int(rotations), int(millidegrees), int(abs_angle)
 
     def __init__(self, sim_motor, clock):
+        super().__init__()
+
         # Store references to motor and clock
         self.sim_motor = sim_motor
         self.clock = clock
+        self.update()
 
-    @property
-    def rotations(self):
-        """
-        Provides rotations for ``pbdrv_counter_virtual_cpython_get_angle()``.
+    def update(self, *args):
         """
-        return self.get_counter_data()[0]
+        Computes the angle at the current time and shares it with the PBIO
+        driver.
 
-    @property
-    def millidegrees(self):
-        """
-        Provides rotations for ``pbdrv_counter_virtual_cpython_get_angle()``.
+        This method has unused *args so that it can be passed directly to
+        :meth:`SimulatedClock.subscribe_advance`.
         """
-        return self.get_counter_data()[1]
+        self.rotations, self.millidegrees, _ = self.get_counter_data()
 
     @property
     def millidegrees_abs(self):
@@ -128,15 +132,16 @@ class Platform:
     }
 
     def on_poll(self, *args):
-        # Push clock forward by one tick on each poll.
-        self.clock[-1].tick()
+        # The simulated clock is advanced by the C code, so there is nothing
+        # to do here.
+        pass
 
     def __init__(self):
 
         # Initialize devices internal to the hub.
         self.battery = {-1: VirtualBattery()}
         self.button = {-1: VirtualButtons()}
-        self.clock = {-1: CountingClock(start=0, fuzz=0)}
+        self.clock = {-1: SimulatedClock(start=0)}
         self.led = {0: VirtualLed()}
 
         # Initialize all ports
@@ -145,6 +150,10 @@ class Platform:
         self.motor_driver = {}
         self.sim_motor = {}
 
+        # Random initial motor angles, but the same ones on every run so that
+        # simulations are repeatable.
+        rng = random.Random(0)
+
         for i, (port_id, type_id) in enumerate(self.PORTS.items()):
             # Initialize IO Port.
             self.ioport[port_id] = VirtualIOPort(port_id)
@@ -162,7 +171,7 @@ class Platform:
                 initial_time = self.clock[-1].microseconds / 1000000
 
                 # Random initial motor angle with zero speed.
-                initial_angle = random.randint(-180, 179)
+                initial_angle = rng.randint(-180, 179)
                 initial_speed = 0
                 initial_state = numpy.array(
                     [
@@ -176,4 +185,6 @@ class Platform:
 
             # Initialize counter and motor drivers with the given motor.
             self.counter[i] = VirtualCounter(self.sim_motor[i], self.clock[-1])
+            if self.sim_motor[i] is not None:
+                self.clock[-1].subscribe_advance(self.counter[i].update)
             self.motor_driver[i] = VirtualMotorDriver(self.sim_motor[i])
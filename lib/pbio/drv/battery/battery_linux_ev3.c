@@ -18,20 +18,17 @@
 #include <pbdrv/battery.h>
 #include <pbio/error.h>
 
-static FILE *f_voltage;
-static FILE *f_current;
+#include "../sysfs.h"
+
+// Voltage and current are read on every control loop iteration, so they are
+// read with raw file descriptors.
+static int fd_voltage = -1;
+static int fd_current = -1;
 static FILE *f_technology;
 
 void pbdrv_battery_init(void) {
-    f_voltage = fopen("/sys/class/power_supply/lego-ev3-battery/voltage_now", "r");
-    if (f_voltage) {
-        setbuf(f_voltage, NULL);
-    }
-
-    f_current = fopen("/sys/class/power_supply/lego-ev3-battery/current_now", "r");
-    if (f_current) {
-        setbuf(f_current, NULL);
-    }
+    pbdrv_sysfs_open("/sys/class/power_supply/lego-ev3-battery/voltage_now", &fd_voltage);
+    pbdrv_sysfs_open("/sys/class/power_supply/lego-ev3-battery/current_now", &fd_current);
 
     f_technology = fopen("/sys/class/power_supply/lego-ev3-battery/technology", "r");
     if (f_technology) {
@@ -42,16 +39,13 @@ void pbdrv_battery_init(void) {
 pbio_error_t pbdrv_battery_get_voltage_now(uint16_t *value) {
     int32_t microvolt;
 
-    if (f_voltage == NULL) {
+    if (fd_voltage == -1) {
         return PBIO_ERROR_NO_DEV;
     }
 
-    if (fseek(f_voltage, 0, SEEK_SET) == -1) {
-        return PBIO_ERROR_IO;
-    }
-
-    if (fscanf(f_voltage, "%d", &microvolt) == EOF) {
-        return PBIO_ERROR_IO;
+    pbio_error_t err = pbdrv_sysfs_read_i32(fd_voltage, &microvolt);
+    if (err != PBIO_SUCCESS) {
+        return err;
     }
 
     *value = microvolt / 1000;
@@ -62,16 +56,13 @@ pbio_error_t pbdrv_battery_get_voltage_now(uint16_t *value) {
 pbio_error_t pbdrv_battery_get_current_now(uint16_t *value) {
     int32_t microamp;
 
-    if (f_current == NULL) {
+    if (fd_current == -1) {
         return PBIO_ERROR_NO_DEV;
     }
 
-    if (fseek(f_current, 0, SEEK_SET) == -1) {
-        return PBIO_ERROR_IO;
-    }
-
-    if (fscanf(f_current, "%d", &microamp) == EOF) {
-        return PBIO_ERROR_IO;
+    pbio_error_t err = pbdrv_sysfs_read_i32(fd_current, &microamp);
+    if (err != PBIO_SUCCESS) {
+        return err;
     }
 
     *value = microamp / 1000;
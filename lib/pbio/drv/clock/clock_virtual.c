@@ -7,6 +7,7 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +18,7 @@
 #include <pbio/error.h>
 
 #include "../virtual.h"
+#include "clock_virtual.h"
 
 #define NSEC_PER_MSEC       1000000
 #define NSEC_PER_100USEC    100000
@@ -24,13 +26,52 @@
 
 #define TIMER_SIGNAL        SIGRTMIN
 
+// In simulated mode, the time is kept here instead of being read from the
+// platform, and it only changes when pbdrv_clock_virtual_advance() is called.
+static bool simulated;
+static uint64_t simulated_ns;
+static uint64_t simulated_step_ns;
+
 static void handle_signal(int sig) {
     etimer_request_poll();
 }
 
+static void pbdrv_clock_virtual_init_simulated(void) {
+    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &simulated_ns);
+
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
+        exit(1);
+    }
+
+    err = pbdrv_virtual_get_u64("clock", -1, "step_nanoseconds", &simulated_step_ns);
+
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
+        exit(1);
+    }
+
+    simulated = true;
+}
+
 void pbdrv_clock_init(void) {
     int ret;
 
+    uint8_t is_simulated;
+    pbio_error_t err = pbdrv_virtual_get_u8("clock", -1, "simulated", &is_simulated);
+
+    if (err != PBIO_SUCCESS) {
+        fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
+        exit(1);
+    }
+
+    // Simulated time does not need a timer signal. Instead, timers are
+    // polled synchronously each time the clock is advanced.
+    if (is_simulated) {
+        pbdrv_clock_virtual_init_simulated();
+        return;
+    }
+
     struct sigaction sa = {
         .sa_handler = handle_signal,
     };
@@ -50,7 +91,7 @@ void pbdrv_clock_init(void) {
     }
 
     ssize_t thread_id;
-    pbio_error_t err = pbdrv_virtual_get_thread_ident(&thread_id);
+    err = pbdrv_virtual_get_thread_ident(&thread_id);
 
     if (err != PBIO_SUCCESS) {
         fprintf(stderr, "fatal error: pbdrv_clock_init failed\n");
@@ -65,40 +106,74 @@ void pbdrv_clock_init(void) {
     }
 }
 
-uint32_t pbdrv_clock_get_ms(void) {
+/**
+ * Gets the current clock time in nanoseconds.
+ *
+ * @return                  The time.
+ */
+uint64_t pbdrv_clock_virtual_get_ns(void) {
+    if (simulated) {
+        return simulated_ns;
+    }
+
     uint64_t value;
     pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
 
     if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_ms failed\n");
+        fprintf(stderr, "fatal error: pbdrv_clock_virtual_get_ns failed\n");
         exit(1);
     }
 
-    return value / NSEC_PER_MSEC;
+    return value;
 }
 
-uint32_t pbdrv_clock_get_100us(void) {
-    uint64_t value;
-    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
+/**
+ * Tests if the clock runs in simulated time.
+ *
+ * @return                  True if simulated, false if the platform provides the time.
+ */
+bool pbdrv_clock_virtual_is_simulated(void) {
+    return simulated;
+}
 
-    if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_us failed\n");
-        exit(1);
+/**
+ * Advances simulated time by one step and polls timers that have expired.
+ *
+ * Expired timers are handled the next time pending events are processed,
+ * so time never moves on while there is still something to do at the
+ * current time. This makes simulations run as fast as possible and gives
+ * the same results on every run.
+ *
+ * Does nothing if the clock is not simulated.
+ */
+void pbdrv_clock_virtual_advance(void) {
+    if (!simulated) {
+        return;
     }
 
-    return value / NSEC_PER_100USEC;
-}
+    simulated_ns += simulated_step_ns;
 
-uint32_t pbdrv_clock_get_us(void) {
-    uint64_t value;
-    pbio_error_t err = pbdrv_virtual_get_u64("clock", -1, "nanoseconds", &value);
+    // Let the platform know, e.g. to keep physics simulations in sync.
+    pbio_error_t err = pbdrv_virtual_call_method("clock", -1, "on_advance", "(K)", (unsigned long long)simulated_ns);
 
     if (err != PBIO_SUCCESS) {
-        fprintf(stderr, "fatal error: pbdrv_clock_get_us failed\n");
+        fprintf(stderr, "fatal error: pbdrv_clock_virtual_advance failed\n");
         exit(1);
     }
 
-    return value / NSEC_PER_USEC;
+    etimer_request_poll();
+}
+
+uint32_t pbdrv_clock_get_ms(void) {
+    return pbdrv_clock_virtual_get_ns() / NSEC_PER_MSEC;
+}
+
+uint32_t pbdrv_clock_get_100us(void) {
+    return pbdrv_clock_virtual_get_ns() / NSEC_PER_100USEC;
+}
+
+uint32_t pbdrv_clock_get_us(void) {
+    return pbdrv_clock_virtual_get_ns() / NSEC_PER_USEC;
 }
 
 #endif // PBDRV_CONFIG_CLOCK_VIRTUAL
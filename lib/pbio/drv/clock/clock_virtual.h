@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _INTERNAL_PBDRV_CLOCK_VIRTUAL_H_
+#define _INTERNAL_PBDRV_CLOCK_VIRTUAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_CLOCK_VIRTUAL
+
+uint64_t pbdrv_clock_virtual_get_ns(void);
+bool pbdrv_clock_virtual_is_simulated(void);
+void pbdrv_clock_virtual_advance(void);
+
+#endif // PBDRV_CONFIG_CLOCK_VIRTUAL
+
+#endif // _INTERNAL_PBDRV_CLOCK_VIRTUAL_H_
@@ -13,6 +13,7 @@
 typedef struct {
     pbio_error_t (*get_angle)(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees);
     pbio_error_t (*get_abs_angle)(pbdrv_counter_dev_t *dev, int32_t *millidegrees);
+    pbio_error_t (*get_edge_time)(pbdrv_counter_dev_t *dev, uint32_t *time_us);
 } pbdrv_counter_funcs_t;
 
 struct _pbdrv_counter_dev_t {
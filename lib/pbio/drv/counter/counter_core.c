@@ -82,4 +82,29 @@ pbio_error_t pbdrv_counter_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *mill
     return dev->funcs->get_abs_angle(dev, millidegrees);
 }
 
+/**
+ * Gets the time of the most recent change of the count, if the counter
+ * supports it.
+ *
+ * Counters that count encoder edges in an interrupt can record when each
+ * edge happened. This is much more precise than the time at which the count
+ * is read, which makes it possible to measure slow speeds accurately.
+ *
+ * @param [in]  dev            Pointer to the counter device
+ * @param [out] time_us        Returns the time of the last edge on success,
+ *                             on the same clock as pbdrv_clock_get_us().
+ * @return                     ::PBIO_SUCCESS on success, ::PBIO_ERROR_NO_DEV
+ *                             if the counter has not been initialized,
+ *                             ::PBIO_ERROR_NOT_SUPPORTED if this counter does
+ *                             not record edge times or the counter driver is
+ *                             disabled.
+ */
+pbio_error_t pbdrv_counter_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us) {
+    if (!dev->funcs->get_edge_time) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    return dev->funcs->get_edge_time(dev, time_us);
+}
+
 #endif // PBDRV_CONFIG_COUNTER
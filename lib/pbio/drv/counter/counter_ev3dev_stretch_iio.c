@@ -4,18 +4,35 @@
 // ev3dev-stretch PRU/IIO Quadrature Encoder Counter driver
 //
 // This driver uses the PRU quadrature encoder found in ev3dev-stretch.
+//
+// If PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER is enabled, the driver
+// also enables the IIO buffer of the device, filled by an hrtimer trigger.
+// Then the counts of all ports are read from the IIO character device in one
+// read() per control loop iteration. The sysfs attribute of each port is only
+// read if the buffer could not be enabled or has no recent sample. Each sample
+// is timestamped, which gives the time of the latest edge of each port. The
+// buffer and the trigger are disabled again when the program exits.
 
 #include <pbdrv/config.h>
 
 #if PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO
 
 #include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
 
 #include <libudev.h>
 
+#include <pbdrv/clock.h>
 #include <pbio/util.h>
+#include "../sysfs.h"
 #include "counter.h"
 
 #define DEBUG 0
@@ -27,25 +44,320 @@
 
 typedef struct {
     pbdrv_counter_dev_t *dev;
-    FILE *count;
+    int count;
 } private_data_t;
 
 static private_data_t private_data[PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV];
 
-static pbio_error_t pbdrv_counter_ev3dev_stretch_iio_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees) {
+#if PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER
+
+// Name of the hrtimer trigger that fills the buffer.
+#define TRIGGER_NAME "pbio-counter"
+
+// Directory that creates the trigger through configfs.
+#define TRIGGER_DIR "/sys/kernel/config/iio/triggers/hrtimer/" TRIGGER_NAME
+
+// Rate at which the trigger fills the buffer. This is faster than the control
+// loop, so there is a new sample at every iteration.
+#define TRIGGER_FREQUENCY "1000"
+
+// Time (us) between two samples of the trigger.
+#define TRIGGER_PERIOD_US (1000)
+
+// Age (us) after which the most recent sample is too old to be used. This
+// allows for some jitter of the trigger.
+#define SAMPLE_AGE_MAX_US (2 * TRIGGER_PERIOD_US)
+
+// One sample in the IIO buffer, with all count channels and the timestamp
+// enabled. Channels are ordered by scan index and aligned to their own size,
+// which matches the layout of this struct.
+typedef struct {
+    int32_t count[PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV];
+    // Time (ns) at which the sample was taken.
+    int64_t timestamp __attribute__((aligned(8)));
+} scan_t;
+
+static struct {
+    // The IIO character device or -1 if buffered mode is not available.
+    int fd;
+    // Whether a recent sample was received.
+    bool valid;
+    // Counts of the most recent sample.
+    int32_t count[PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV];
+    // Time (us) of the most recent sample.
+    uint32_t sample_time;
+    // Time (us) of the first sample with the current count of each port.
+    uint32_t edge_time[PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV];
+    // Which counts have been returned since the last read of the buffer.
+    bool used[PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV];
+    // Time (us) of the last read of the buffer.
+    uint32_t read_time;
+    // Sysfs path of the device, used to disable the buffer at exit.
+    char syspath[256];
+} buffer = {
+    .fd = -1,
+};
+
+// Reads all pending samples from the buffer, keeping the counts of the most
+// recent one and the time at which each count changed.
+static void pbdrv_counter_ev3dev_stretch_iio_read_buffer(void) {
+    scan_t scans[8];
+
+    buffer.read_time = pbdrv_clock_get_us();
+
+    for (;;) {
+        ssize_t size = read(buffer.fd, scans, sizeof(scans));
+
+        // Nothing left (EAGAIN) or an error. Either way, keep the previous
+        // sample if it is still recent, as checked below.
+        if (size < (ssize_t)sizeof(scan_t)) {
+            break;
+        }
+
+        for (size_t s = 0; s < size / sizeof(scan_t); s++) {
+            for (size_t i = 0; i < PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV; i++) {
+                if (!buffer.valid || scans[s].count[i] != buffer.count[i]) {
+                    buffer.count[i] = scans[s].count[i];
+                    buffer.edge_time[i] = scans[s].timestamp / 1000;
+                }
+            }
+            buffer.sample_time = scans[s].timestamp / 1000;
+            buffer.valid = true;
+        }
+
+        if (size < (ssize_t)sizeof(scans)) {
+            break;
+        }
+    }
+
+    // While the buffer is not read, for example before the first motor is
+    // used, it fills up and the kernel drops the new samples. Then even the
+    // newest sample may be old, so use sysfs until new samples arrive.
+    if (buffer.valid && (int32_t)(buffer.read_time - buffer.sample_time) > SAMPLE_AGE_MAX_US) {
+        buffer.valid = false;
+    }
+
+    memset(buffer.used, 0, sizeof(buffer.used));
+}
+
+// Gets the count from the buffer, reading it once per control loop iteration
+// for all ports.
+static bool pbdrv_counter_ev3dev_stretch_iio_get_buffered_count(size_t index, int32_t *count) {
+    if (buffer.fd == -1) {
+        return false;
+    }
+
+    // If this count was already used, a new control loop iteration started.
+    // No new sample arrives within one trigger period, so reading the angle
+    // again right away (e.g. around reading the edge time) does not count.
+    if (!buffer.valid || (buffer.used[index] &&
+                          pbdrv_clock_get_us() - buffer.read_time >= TRIGGER_PERIOD_US)) {
+        pbdrv_counter_ev3dev_stretch_iio_read_buffer();
+    }
+
+    if (!buffer.valid) {
+        return false;
+    }
+
+    buffer.used[index] = true;
+    *count = buffer.count[index];
+    return true;
+}
+
+static pbio_error_t pbdrv_counter_ev3dev_stretch_iio_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us) {
     private_data_t *priv = dev->priv;
 
-    if (!priv->count) {
-        return PBIO_ERROR_NO_DEV;
+    if (buffer.fd == -1 || !buffer.valid) {
+        return PBIO_ERROR_NOT_SUPPORTED;
     }
 
-    if (fseek(priv->count, 0, SEEK_SET) == -1) {
-        return PBIO_ERROR_IO;
+    // The edge happened at most one trigger period before this time.
+    *time_us = buffer.edge_time[priv - private_data];
+    return PBIO_SUCCESS;
+}
+
+// Disables the buffer and removes the trigger, so the device is left as it
+// was found when the program exits.
+static void pbdrv_counter_ev3dev_stretch_iio_disable_buffer(void) {
+    char path[512];
+
+    if (buffer.fd != -1) {
+        close(buffer.fd);
+        buffer.fd = -1;
     }
 
+    snprintf(path, sizeof(path), "%s/buffer/enable", buffer.syspath);
+    pbdrv_sysfs_write(path, "0");
+
+    // Any name that isn't a trigger detaches the current one.
+    snprintf(path, sizeof(path), "%s/trigger/current_trigger", buffer.syspath);
+    pbdrv_sysfs_write(path, "\n");
+
+    rmdir(TRIGGER_DIR);
+}
+
+// Creates an hrtimer trigger and makes it trigger the device. Returns false
+// if the kernel does not support this.
+static bool pbdrv_counter_ev3dev_stretch_iio_set_trigger(struct udev *udev, const char *syspath) {
+    char path[256];
+    bool ok = false;
+
+    // The trigger may already exist from a previous run.
+    if (mkdir(TRIGGER_DIR, 0755) == -1 && errno != EEXIST) {
+        dbg_err("failed to create hrtimer trigger");
+        return false;
+    }
+
+    struct udev_enumerate *enumerate = udev_enumerate_new(udev);
+    if (!enumerate) {
+        dbg_err("failed to get udev context");
+        return false;
+    }
+
+    if (udev_enumerate_add_match_subsystem(enumerate, "iio") < 0 ||
+        udev_enumerate_add_match_sysattr(enumerate, "name", TRIGGER_NAME) < 0 ||
+        udev_enumerate_scan_devices(enumerate) < 0) {
+        dbg_err("failed to find hrtimer trigger");
+        goto free_enumerate;
+    }
+
+    struct udev_list_entry *entry = udev_enumerate_get_list_entry(enumerate);
+    if (!entry) {
+        dbg_err("failed to find hrtimer trigger");
+        goto free_enumerate;
+    }
+
+    snprintf(path, sizeof(path), "%s/sampling_frequency", udev_list_entry_get_name(entry));
+    if (pbdrv_sysfs_write(path, TRIGGER_FREQUENCY) != PBIO_SUCCESS) {
+        dbg_err("failed to set trigger frequency");
+        goto free_enumerate;
+    }
+
+    snprintf(path, sizeof(path), "%s/trigger/current_trigger", syspath);
+    if (pbdrv_sysfs_write(path, TRIGGER_NAME) != PBIO_SUCCESS) {
+        dbg_err("failed to set trigger");
+        goto free_enumerate;
+    }
+
+    ok = true;
+
+free_enumerate:
+    udev_enumerate_unref(enumerate);
+    return ok;
+}
+
+// Checks that a scan element has the given type.
+static bool pbdrv_counter_ev3dev_stretch_iio_check_type(const char *path, const char *expected) {
+    char type[16];
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        dbg_err("failed to open scan element type");
+        return false;
+    }
+    bool ok = fscanf(f, "%15s", type) == 1 && strcmp(type, expected) == 0;
+    fclose(f);
+    if (!ok) {
+        dbg_err("unexpected scan element type");
+    }
+    return ok;
+}
+
+// Enables the IIO buffer with all count channels and the timestamp.
+static void pbdrv_counter_ev3dev_stretch_iio_enable_buffer(struct udev *udev, const char *syspath) {
+    char path[256];
+
+    // Channels and trigger can only be changed while the buffer is disabled.
+    snprintf(path, sizeof(path), "%s/buffer/enable", syspath);
+    if (pbdrv_sysfs_write(path, "0") != PBIO_SUCCESS) {
+        dbg_err("device does not have a buffer");
+        return;
+    }
+
+    // Without a trigger, the buffer is never filled.
+    if (!pbdrv_counter_ev3dev_stretch_iio_set_trigger(udev, syspath)) {
+        return;
+    }
+
+    // From here on, undo the changes to the device when the program exits.
+    snprintf(buffer.syspath, sizeof(buffer.syspath), "%s", syspath);
+    atexit(pbdrv_counter_ev3dev_stretch_iio_disable_buffer);
+
+    for (size_t i = 0; i < PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV; i++) {
+        // Only signed 32-bit little endian counts match scan_t.
+        snprintf(path, sizeof(path), "%s/scan_elements/in_count%d_type", syspath, (int)i);
+        if (!pbdrv_counter_ev3dev_stretch_iio_check_type(path, "le:s32/32>>0")) {
+            return;
+        }
+
+        snprintf(path, sizeof(path), "%s/scan_elements/in_count%d_en", syspath, (int)i);
+        if (pbdrv_sysfs_write(path, "1") != PBIO_SUCCESS) {
+            dbg_err("failed to enable count channel");
+            return;
+        }
+    }
+
+    // The timestamp gives the time of each edge. It must be enabled for the
+    // samples to match scan_t.
+    snprintf(path, sizeof(path), "%s/scan_elements/in_timestamp_type", syspath);
+    if (!pbdrv_counter_ev3dev_stretch_iio_check_type(path, "le:s64/64>>0")) {
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s/scan_elements/in_timestamp_en", syspath);
+    if (pbdrv_sysfs_write(path, "1") != PBIO_SUCCESS) {
+        dbg_err("failed to enable timestamp channel");
+        return;
+    }
+
+    // Timestamps must use the same clock as pbdrv_clock_get_us(), both for
+    // edge times and to tell whether a sample is recent.
+    snprintf(path, sizeof(path), "%s/current_timestamp_clock", syspath);
+    if (pbdrv_sysfs_write(path, "monotonic_raw") != PBIO_SUCCESS) {
+        dbg_err("failed to set timestamp clock");
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s/buffer/enable", syspath);
+    if (pbdrv_sysfs_write(path, "1") != PBIO_SUCCESS) {
+        dbg_err("failed to enable buffer");
+        return;
+    }
+
+    struct udev_device *device = udev_device_new_from_syspath(udev, syspath);
+    if (!device) {
+        dbg_err("failed to get udev device");
+        return;
+    }
+
+    const char *devnode = udev_device_get_devnode(device);
+    if (devnode) {
+        buffer.fd = open(devnode, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (buffer.fd == -1) {
+            dbg_err("failed to open buffer");
+        }
+    }
+
+    udev_device_unref(device);
+}
+
+#else // PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER
+
+static bool pbdrv_counter_ev3dev_stretch_iio_get_buffered_count(size_t index, int32_t *count) {
+    return false;
+}
+
+#endif // PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER
+
+static pbio_error_t pbdrv_counter_ev3dev_stretch_iio_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees) {
+    private_data_t *priv = dev->priv;
+
     int32_t count;
-    if (fscanf(priv->count, "%d", &count) == EOF) {
-        return PBIO_ERROR_IO;
+    if (!pbdrv_counter_ev3dev_stretch_iio_get_buffered_count(priv - private_data, &count)) {
+        pbio_error_t err = pbdrv_sysfs_read_i32(priv->count, &count);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
     }
 
     // ev3dev stretch provides 720 counts per rotation.
@@ -57,6 +369,9 @@ static pbio_error_t pbdrv_counter_ev3dev_stretch_iio_get_angle(pbdrv_counter_dev
 
 static const pbdrv_counter_funcs_t pbdrv_counter_ev3dev_stretch_iio_funcs = {
     .get_angle = pbdrv_counter_ev3dev_stretch_iio_get_angle,
+    #if PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER
+    .get_edge_time = pbdrv_counter_ev3dev_stretch_iio_get_edge_time,
+    #endif
 };
 
 void pbdrv_counter_ev3dev_stretch_iio_init(pbdrv_counter_dev_t *devs) {
@@ -103,14 +418,11 @@ void pbdrv_counter_ev3dev_stretch_iio_init(pbdrv_counter_dev_t *devs) {
         private_data_t *priv = &private_data[i];
 
         snprintf(buf, sizeof(buf), "%s/in_count%d_raw", udev_list_entry_get_name(entry), (int)i);
-        priv->count = fopen(buf, "r");
-        if (!priv->count) {
+        if (pbdrv_sysfs_open(buf, &priv->count) != PBIO_SUCCESS) {
             dbg_err("failed to open count attribute");
             continue;
         }
 
-        setbuf(priv->count, NULL);
-
         // FIXME: assuming that these are the only counter devices
         // counter_id should be passed from platform data instead
         _Static_assert(PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV == PBDRV_CONFIG_COUNTER_NUM_DEV,
@@ -120,6 +432,10 @@ void pbdrv_counter_ev3dev_stretch_iio_init(pbdrv_counter_dev_t *devs) {
         priv->dev->priv = priv;
     }
 
+    #if PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER
+    pbdrv_counter_ev3dev_stretch_iio_enable_buffer(udev, udev_list_entry_get_name(entry));
+    #endif
+
 free_enumerate:
     udev_enumerate_unref(enumerate);
 free_udev:
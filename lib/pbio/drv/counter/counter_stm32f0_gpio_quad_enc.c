@@ -17,6 +17,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <pbdrv/clock.h>
 #include <pbdrv/gpio.h>
 #include <pbio/util.h>
 
@@ -27,6 +28,7 @@
 typedef struct {
     pbdrv_counter_dev_t *dev;
     int32_t count;
+    uint32_t edge_time;
 } private_data_t;
 
 static private_data_t private_data[PBDRV_CONFIG_COUNTER_STM32F0_GPIO_QUAD_ENC_NUM_DEV];
@@ -40,6 +42,14 @@ static pbio_error_t pbdrv_counter_stm32f0_gpio_quad_enc_get_angle(pbdrv_counter_
     return PBIO_SUCCESS;
 }
 
+static pbio_error_t pbdrv_counter_stm32f0_gpio_quad_enc_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us) {
+    private_data_t *priv = dev->priv;
+
+    *time_us = priv->edge_time;
+
+    return PBIO_SUCCESS;
+}
+
 static void pbdrv_counter_stm32f0_gpio_quad_enc_update_count(private_data_t *priv,
     bool int_pin_state, bool dir_pin_state) {
     if (int_pin_state ^ dir_pin_state) {
@@ -47,6 +57,7 @@ static void pbdrv_counter_stm32f0_gpio_quad_enc_update_count(private_data_t *pri
     } else {
         priv->count++;
     }
+    priv->edge_time = pbdrv_clock_get_us();
 }
 
 // irq handler name defined in startup_stm32f0.s
@@ -75,6 +86,7 @@ void EXTI0_1_IRQHandler(void) {
 
 static const pbdrv_counter_funcs_t pbdrv_counter_stm32f0_gpio_quad_enc_funcs = {
     .get_angle = pbdrv_counter_stm32f0_gpio_quad_enc_get_angle,
+    .get_edge_time = pbdrv_counter_stm32f0_gpio_quad_enc_get_edge_time,
 };
 
 void pbdrv_counter_stm32f0_gpio_quad_enc_init(pbdrv_counter_dev_t *devs) {
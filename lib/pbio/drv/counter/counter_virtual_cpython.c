@@ -24,8 +24,17 @@
 #define dbg_err(s)
 #endif
 
+// State that is shared with CPython. Must match the ctypes structure of the
+// same name in pbio_virtual/drv/counter.py.
+typedef struct {
+    int32_t rotations;
+    int32_t millidegrees;
+} pbdrv_counter_virtual_cpython_state_t;
+
 typedef struct {
     pbdrv_counter_dev_t *dev;
+    // Shared state or NULL if the angle has to be read from attributes.
+    const volatile pbdrv_counter_virtual_cpython_state_t *state;
     uint8_t index;
 } private_data_t;
 
@@ -34,6 +43,13 @@ static private_data_t private_data[PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON_NUM_DEV]
 static pbio_error_t pbdrv_counter_virtual_cpython_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees) {
     private_data_t *priv = dev->priv;
 
+    // Fast path: read directly from memory without going through CPython.
+    if (priv->state) {
+        *rotations = priv->state->rotations;
+        *millidegrees = priv->state->millidegrees;
+        return PBIO_SUCCESS;
+    }
+
     pbio_error_t err = pbdrv_virtual_get_i32("counter", priv->index, "rotations", rotations);
     if (err != PBIO_SUCCESS) {
         return err;
@@ -65,6 +81,13 @@ void pbdrv_counter_virtual_cpython_init(pbdrv_counter_dev_t *devs) {
         _Static_assert(PBDRV_CONFIG_COUNTER_VIRTUAL_CPYTHON_NUM_DEV == PBDRV_CONFIG_COUNTER_NUM_DEV,
             "need to fix counter_virtual_cpython implementation to allow other counter devices");
 
+        // The state block is looked up only once. Counters that don't have
+        // one return 0, which is read as NULL.
+        void *state;
+        if (pbdrv_virtual_get_ctype_pointer("counter", i, "state", &state) == PBIO_SUCCESS) {
+            priv->state = state;
+        }
+
         priv->dev = &devs[i];
         priv->dev->funcs = &pbdrv_counter_virtual_cpython_funcs;
         priv->dev->priv = priv;
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Common functions used by drivers that read Linux sysfs attributes.
+//
+// Attributes are read with a single pread() on a raw file descriptor and are
+// parsed by hand. This avoids the overhead of stdio in drivers that are read
+// on every control loop iteration.
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_SYSFS
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pbio/error.h>
+
+#include "sysfs.h"
+
+/**
+ * Opens a sysfs attribute for reading.
+ *
+ * @param [in]  path    The path to the attribute.
+ * @param [out] fd      The file descriptor.
+ * @return              ::PBIO_SUCCESS or ::PBIO_ERROR_NO_DEV if the attribute
+ *                      could not be opened.
+ */
+pbio_error_t pbdrv_sysfs_open(const char *path, int *fd) {
+    *fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (*fd == -1) {
+        return PBIO_ERROR_NO_DEV;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Reads a sysfs attribute that holds a decimal integer.
+ *
+ * The attribute is read from the start each time, so the same file
+ * descriptor can be used for repeated reads.
+ *
+ * @param [in]  fd      The file descriptor from ::pbdrv_sysfs_open.
+ * @param [out] value   The value.
+ * @return              ::PBIO_SUCCESS or ::PBIO_ERROR_IO if the attribute
+ *                      could not be read or is not an integer.
+ */
+pbio_error_t pbdrv_sysfs_read_i32(int fd, int32_t *value) {
+    // Enough for "-2147483648\n".
+    char buf[16];
+
+    ssize_t size = pread(fd, buf, sizeof(buf), 0);
+    if (size <= 0) {
+        return PBIO_ERROR_IO;
+    }
+
+    ssize_t i = 0;
+    bool negative = buf[0] == '-';
+    if (negative) {
+        i++;
+    }
+
+    // Accumulate as negative number so that INT32_MIN fits.
+    int32_t result = 0;
+    ssize_t first_digit = i;
+    for (; i < size && buf[i] >= '0' && buf[i] <= '9'; i++) {
+        result = result * 10 - (buf[i] - '0');
+    }
+
+    if (i == first_digit) {
+        return PBIO_ERROR_IO;
+    }
+
+    *value = negative ? result : -result;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Writes a sysfs attribute.
+ *
+ * This is meant for configuring devices, so it opens and closes the
+ * attribute on each call.
+ *
+ * @param [in]  path    The path to the attribute.
+ * @param [in]  value   The value to write.
+ * @return              ::PBIO_SUCCESS, ::PBIO_ERROR_NO_DEV if the attribute
+ *                      could not be opened or ::PBIO_ERROR_IO if the value
+ *                      was not accepted.
+ */
+pbio_error_t pbdrv_sysfs_write(const char *path, const char *value) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        return PBIO_ERROR_NO_DEV;
+    }
+
+    size_t size = strlen(value);
+    ssize_t written = write(fd, value, size);
+
+    close(fd);
+
+    if (written != (ssize_t)size) {
+        return PBIO_ERROR_IO;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+#endif // PBDRV_CONFIG_SYSFS
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Common functions used by drivers that read Linux sysfs attributes.
+
+#ifndef _INTERNAL_PBDRV_SYSFS_H_
+#define _INTERNAL_PBDRV_SYSFS_H_
+
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+pbio_error_t pbdrv_sysfs_open(const char *path, int *fd);
+pbio_error_t pbdrv_sysfs_read_i32(int fd, int32_t *value);
+pbio_error_t pbdrv_sysfs_write(const char *path, const char *value);
+
+#endif // _INTERNAL_PBDRV_SYSFS_H_
@@ -115,6 +115,24 @@ void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart_dev) {
     uart->rx_result = PBIO_ERROR_CANCELED;
 }
 
+pbio_error_t pbdrv_uart_read_stream(pbdrv_uart_dev_t *uart_dev, uint8_t *buf, uint8_t size, uint8_t *count) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    *count = 0;
+
+    // bytes belong to the pending read, if any
+    if (uart->rx_buf) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    while (*count < size && uart->rx_ring_buf_head != uart->rx_ring_buf_tail) {
+        buf[(*count)++] = uart->rx_ring_buf[uart->rx_ring_buf_tail];
+        uart->rx_ring_buf_tail = (uart->rx_ring_buf_tail + 1) & (UART_RING_BUF_SIZE - 1);
+    }
+
+    return PBIO_SUCCESS;
+}
+
 pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
     pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
 
@@ -234,6 +252,9 @@ static void handle_poll(void) {
                     break;
                 }
             }
+        } else if (!uart->rx_buf && uart->rx_ring_buf_head != uart->rx_ring_buf_tail) {
+            // let stream readers know that there is new data
+            process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
         }
 
         if (uart->tx_buf && uart->tx_buf_index == uart->tx_buf_size) {
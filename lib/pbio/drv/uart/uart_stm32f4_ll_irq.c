@@ -113,6 +113,27 @@ void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart_dev) {
     // TODO
 }
 
+pbio_error_t pbdrv_uart_read_stream(pbdrv_uart_dev_t *uart_dev, uint8_t *buf, uint8_t size, uint8_t *count) {
+    pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
+
+    *count = 0;
+
+    if (uart->read_buf) {
+        // Bytes go to the pending read operation instead.
+        return PBIO_ERROR_AGAIN;
+    }
+
+    while (*count < size) {
+        int c = ringbuf_get(&uart->rx_buf);
+        if (c == -1) {
+            break;
+        }
+        buf[(*count)++] = c;
+    }
+
+    return PBIO_SUCCESS;
+}
+
 pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart_dev, uint8_t *msg, uint8_t length, uint32_t timeout) {
     pbdrv_uart_t *uart = PBIO_CONTAINER_OF(uart_dev, pbdrv_uart_t, uart_dev);
 
@@ -236,6 +257,11 @@ static void handle_poll(void) {
             process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
         }
 
+        // broadcast when there are bytes for stream readers
+        if (!uart->read_buf && ringbuf_elements(&uart->rx_buf)) {
+            process_post(PROCESS_BROADCAST, PROCESS_EVENT_COM, NULL);
+        }
+
         // broadcast when write_buf is drained
         if (uart->write_buf && uart->write_pos == uart->write_length) {
             // clearing write_buf to prevent multiple broadcasts
@@ -22,6 +22,7 @@ typedef struct _pbdrv_counter_dev_t pbdrv_counter_dev_t;
 pbio_error_t pbdrv_counter_get_dev(uint8_t id, pbdrv_counter_dev_t **dev);
 pbio_error_t pbdrv_counter_get_angle(pbdrv_counter_dev_t *dev, int32_t *rotations, int32_t *millidegrees);
 pbio_error_t pbdrv_counter_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *millidegrees);
+pbio_error_t pbdrv_counter_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us);
 
 #if !PBDRV_CONFIG_COUNTER_NUM_DEV
 #error Must define PBDRV_CONFIG_COUNTER_NUM_DEV
@@ -39,6 +40,9 @@ static inline pbio_error_t pbdrv_counter_get_angle(pbdrv_counter_dev_t *dev, int
 static inline pbio_error_t pbdrv_counter_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *millidegrees) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
+static inline pbio_error_t pbdrv_counter_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 
 #endif // PBDRV_CONFIG_COUNTER
 
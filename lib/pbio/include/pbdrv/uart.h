@@ -33,6 +33,22 @@ pbio_error_t pbdrv_uart_set_baud_rate(pbdrv_uart_dev_t *uart, uint32_t baud);
 pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t length, uint32_t timeout);
 pbio_error_t pbdrv_uart_read_end(pbdrv_uart_dev_t *uart);
 void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart);
+
+/**
+ * Copies the bytes received so far, without waiting for more.
+ *
+ * This lets protocols that stream data parse it as it arrives, instead of
+ * starting a new read for each part of a message. It can't be used while a
+ * read started by pbdrv_uart_read_begin() is pending.
+ *
+ * @param [in]  uart    The UART device
+ * @param [out] buf     Buffer for the received bytes
+ * @param [in]  size    Size of @p buf
+ * @param [out] count   Number of bytes copied to @p buf, which may be zero
+ * @return              ::PBIO_SUCCESS on success or ::PBIO_ERROR_AGAIN if a
+ *                      read is pending
+ */
+pbio_error_t pbdrv_uart_read_stream(pbdrv_uart_dev_t *uart, uint8_t *buf, uint8_t size, uint8_t *count);
 pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t length, uint32_t timeout);
 pbio_error_t pbdrv_uart_write_end(pbdrv_uart_dev_t *uart);
 void pbdrv_uart_write_cancel(pbdrv_uart_dev_t *uart);
@@ -55,6 +71,10 @@ static inline pbio_error_t pbdrv_uart_read_end(pbdrv_uart_dev_t *uart) {
 }
 static inline void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart) {
 }
+static inline pbio_error_t pbdrv_uart_read_stream(pbdrv_uart_dev_t *uart, uint8_t *buf, uint8_t size, uint8_t *count) {
+    *count = 0;
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 static inline pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t length, uint32_t timeout) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
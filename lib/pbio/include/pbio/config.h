@@ -16,12 +16,57 @@
 #define PBIO_CONFIG_CONTROL_LOOP_TIME_MS (5)
 #endif
 
+// Shortest control loop time. Loop times shorter than
+// PBIO_CONFIG_CONTROL_LOOP_TIME_MS need a copy of the motor model for each
+// motor, made for that time step.
+#ifndef PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS PBIO_CONFIG_CONTROL_LOOP_TIME_MS
+#endif
+
 // Angle differentiation time window, must be integer multiple of loop time
 // and integer divisor of 1000.
 #ifndef PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS
 #define PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS (125)
 #endif
 
+// Measure execution time and timing jitter of the motor control loop.
+#ifndef PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+#define PBIO_CONFIG_MOTOR_PROCESS_PROFILER (0)
+#endif
+
+// Number of position control segments that can be queued per controller.
+#ifndef PBIO_CONFIG_CONTROL_QUEUE_SIZE
+#define PBIO_CONFIG_CONTROL_QUEUE_SIZE (0)
+#endif
+
 #define PBIO_CONFIG_NUM_DRIVEBASES (PBDRV_CONFIG_NUM_MOTOR_CONTROLLER / 2)
 
+// Enables identification of the motor model of servos at runtime.
+#ifndef PBIO_CONFIG_SYSID
+#define PBIO_CONFIG_SYSID (0)
+#endif
+
+// Keeps the most recent data of each mode of I/O devices, so that modes
+// streamed together in a mode combination can be read without a mode switch.
+#ifndef PBIO_CONFIG_IODEV_MODE_DATA
+#define PBIO_CONFIG_IODEV_MODE_DATA (0)
+#endif
+
+// Number of data samples of each I/O device that are kept until they are
+// read, so that no samples are missed between reads. 0 disables this.
+#ifndef PBIO_CONFIG_IODEV_HISTORY_SIZE
+#define PBIO_CONFIG_IODEV_HISTORY_SIZE (0)
+#endif
+
+// Enables coordinated motion of groups of any number of servos.
+#ifndef PBIO_CONFIG_MOTION_GROUP
+#define PBIO_CONFIG_MOTION_GROUP (0)
+#endif
+
+#if PBIO_CONFIG_MOTION_GROUP
+#define PBIO_CONFIG_NUM_MOTION_GROUPS (PBDRV_CONFIG_NUM_MOTOR_CONTROLLER / 2)
+#else
+#define PBIO_CONFIG_NUM_MOTION_GROUPS (0)
+#endif
+
 #endif // _PBIO_CONFIG_H_
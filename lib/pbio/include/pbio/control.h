@@ -14,6 +14,7 @@
 #include <stdint.h>
 
 #include <pbio/angle.h>
+#include <pbio/config.h>
 #include <pbio/control_settings.h>
 #include <pbio/error.h>
 #include <pbio/port.h>
@@ -68,6 +69,10 @@ typedef struct _pbio_control_state_t {
      * Estimated speed from application-specific state observer.
      */
     int32_t speed_estimate;
+    /**
+     * Estimated load torque from application-specific state observer.
+     */
+    int32_t load_estimate;
 } pbio_control_state_t;
 
 /**
@@ -93,6 +98,23 @@ typedef enum {
     PBIO_CONTROL_POSITION,
 } pbio_control_type_t;
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+/**
+ * Position control segment that waits to be started after the current one.
+ */
+typedef struct _pbio_control_segment_t {
+    /**
+     * Trajectory of this segment. It starts at the endpoint of the trajectory
+     * before it, so it can be evaluated when it is queued.
+     */
+    pbio_trajectory_t trajectory;
+    /**
+     * Action to be taken when this segment completes.
+     */
+    pbio_control_on_completion_t on_completion;
+} pbio_control_segment_t;
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 /**
  * Controller status and state.
  */
@@ -140,6 +162,21 @@ typedef struct _pbio_control_t {
      * by the endpoint of the trajectory that is being followed.
      */
     bool on_target;
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    /**
+     * Ring buffer of position control segments that run after the current
+     * trajectory, without waiting for a new command in between.
+     */
+    pbio_control_segment_t queue[PBIO_CONFIG_CONTROL_QUEUE_SIZE];
+    /**
+     * Index of the next segment in the queue.
+     */
+    uint8_t queue_first;
+    /**
+     * Number of segments in the queue.
+     */
+    uint8_t queue_size;
+    #endif
 } pbio_control_t;
 
 // Time functions:
@@ -169,6 +206,15 @@ pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, u
 pbio_error_t pbio_control_start_position_control_hold(pbio_control_t *ctl, uint32_t time_now, int32_t position);
 pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t duration, int32_t speed, pbio_control_on_completion_t on_completion);
 
+// Queue control commands to run after the current one:
+
+pbio_error_t pbio_control_queue_position_control(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_control_queue_position_control_relative(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion);
+pbio_trajectory_t *pbio_control_get_last_trajectory(pbio_control_t *ctl);
+bool pbio_control_queue_must_wait(pbio_control_t *ctl, uint32_t time_now);
+pbio_error_t pbio_control_queue_remove_last(pbio_control_t *ctl);
+bool pbio_control_queue_is_full(pbio_control_t *ctl);
+
 #endif // _PBIO_CONTROL_H_
 
 /** @} */
@@ -4,10 +4,12 @@
 #ifndef _PBIO_CONTROL_SETTINGS_H_
 #define _PBIO_CONTROL_SETTINGS_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <pbio/angle.h>
 #include <pbio/error.h>
+#include <pbio/int_math.h>
 #include <pbio/trajectory.h>
 
 /**
@@ -17,6 +19,45 @@
  * @{
  */
 
+/**
+ * Maximum number of points in a gain schedule.
+ */
+#define PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX (4)
+
+/**
+ * Operating conditions by which the PID gains can be scheduled.
+ */
+typedef enum {
+    /**
+     * Absolute reference speed, in application units per second.
+     */
+    PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED,
+    /**
+     * Absolute load estimated by the observer, in mNm.
+     */
+    PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD,
+    /**
+     * Number of operating conditions.
+     */
+    PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM,
+} pbio_control_settings_gain_schedule_input_t;
+
+/**
+ * Scale factor of the PID gains as a function of an operating condition.
+ */
+typedef struct _pbio_control_settings_gain_schedule_t {
+    /**
+     * Points (x, y) sorted by x, where x is the operating condition and y
+     * is the factor in per mille by which kp, ki, and kd are scaled. The
+     * factor is interpolated between points, and held beyond the end points.
+     */
+    pbio_int_math_point_t points[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX];
+    /**
+     * Number of points in use. If zero, the gains are not scaled.
+     */
+    uint8_t num_points;
+} pbio_control_settings_gain_schedule_t;
+
 /**
  * Control settings.
  */
@@ -74,6 +115,10 @@ typedef struct _pbio_control_settings_t {
      * Absolute rate of change of the speed during off-ramp of the maneuver.
      */
     int32_t deceleration;
+    /**
+     * Shape of the acceleration and deceleration ramps of the maneuver.
+     */
+    pbio_trajectory_profile_t profile;
     /**
      * Maximum feedback actuation value. On a motor this is the maximum torque.
      */
@@ -94,6 +139,19 @@ typedef struct _pbio_control_settings_t {
      * Absolute bound on the rate at which the integrator accumulates errors.
      */
     int32_t integral_change_max;
+    /**
+     * Schedules that scale the PID gains depending on the operating
+     * condition. The factors of all schedules are multiplied.
+     */
+    pbio_control_settings_gain_schedule_t gain_schedules[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM];
+    /**
+     * Reciprocals of ctl_steps_per_app_step and the configured pid_kp and
+     * pid_ki, used to divide by these in every control loop iteration. They
+     * are refreshed on first use after the respective setting changes.
+     */
+    pbio_int_math_reciprocal_t ctl_steps_per_app_step_reciprocal;
+    pbio_int_math_reciprocal_t pid_kp_reciprocal;
+    pbio_int_math_reciprocal_t pid_ki_reciprocal;
 } pbio_control_settings_t;
 
 /**
@@ -112,6 +170,16 @@ typedef struct _pbio_control_settings_t {
  */
 #define pbio_control_time_ticks_to_ms(ticks) ((ticks) / PBIO_TRAJECTORY_TICKS_PER_MS)
 
+/**
+ * Longest allowed control loop time in milliseconds.
+ */
+#define PBIO_CONTROL_LOOP_TIME_MAX_MS (50)
+
+// Control loop time:
+
+uint32_t pbio_control_settings_get_loop_time(void);
+pbio_error_t pbio_control_settings_set_loop_time(uint32_t loop_time);
+
 // Unit conversion functions:
 
 int32_t pbio_control_settings_ctl_to_app(pbio_control_settings_t *s, int32_t input);
@@ -125,7 +193,10 @@ int32_t pbio_control_settings_actuation_app_to_ctl(int32_t input);
 
 int32_t pbio_control_settings_mul_by_loop_time(int32_t input);
 int32_t pbio_control_settings_mul_by_gain(int32_t value, int32_t gain);
-int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain);
+int32_t pbio_control_settings_div_by_kp(pbio_control_settings_t *s, int32_t value, int32_t pid_kp);
+int32_t pbio_control_settings_div_by_ki(pbio_control_settings_t *s, int32_t value, int32_t pid_ki);
+bool pbio_control_settings_gain_schedule_is_active(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input);
+void pbio_control_settings_get_scheduled_pid(pbio_control_settings_t *s, int32_t speed, int32_t load, int32_t *pid_kp, int32_t *pid_ki, int32_t *pid_kd);
 
 // Control settings getters and setters:
 
@@ -133,6 +204,8 @@ void pbio_control_settings_get_limits(pbio_control_settings_t *s, int32_t *speed
 pbio_error_t pbio_control_settings_set_limits(pbio_control_settings_t *s, int32_t speed, int32_t acceleration, int32_t deceleration, int32_t actuation);
 void pbio_control_settings_get_pid(pbio_control_settings_t *s, int32_t *pid_kp, int32_t *pid_ki, int32_t *pid_kd, int32_t *integral_change_max);
 pbio_error_t pbio_control_settings_set_pid(pbio_control_settings_t *s, int32_t pid_kp, int32_t pid_ki, int32_t pid_kd, int32_t integral_change_max);
+uint8_t pbio_control_settings_get_gain_schedule(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input, pbio_int_math_point_t *points);
+pbio_error_t pbio_control_settings_set_gain_schedule(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input, const pbio_int_math_point_t *points, uint8_t num_points);
 void pbio_control_settings_get_target_tolerances(pbio_control_settings_t *s, int32_t *speed, int32_t *position);
 pbio_error_t pbio_control_settings_set_target_tolerances(pbio_control_settings_t *s, int32_t speed, int32_t position);
 void pbio_control_settings_get_stall_tolerances(pbio_control_settings_t *s,  int32_t *speed, uint32_t *time);
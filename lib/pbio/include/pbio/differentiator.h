@@ -16,25 +16,99 @@
 #include <pbio/config.h>
 #include <pbio/angle.h>
 #include <pbio/control_settings.h>
+#include <pbio/error.h>
+
+/**
+ * Method used to estimate speed from angle samples.
+ */
+typedef enum {
+    /**
+     * Average speed across a window of recent angles. This lags behind by
+     * half the window.
+     */
+    PBIO_DIFFERENTIATOR_FILTER_WINDOW,
+    /**
+     * Alpha-beta tracking filter, which estimates angle and speed together.
+     * It has no lag at constant speed, and follows speed changes like two
+     * low pass filters in series, each with the response time as its time
+     * constant.
+     */
+    PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA,
+} pbio_differentiator_filter_t;
+
+/**
+ * Edge age passed to the differentiator if the counter does not record when
+ * the angle last changed.
+ */
+#define PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN (UINT32_MAX)
 
 /**
  * Differentiator of position signal.
  */
 typedef struct _pbio_differentiator_t {
     /**
-     * Ring buffer of position samples.
+     * Method used to estimate speed.
+     */
+    pbio_differentiator_filter_t filter;
+    /**
+     * Window length or response time of the filter, in ms.
+     */
+    uint16_t time_ms;
+    /**
+     * Loop time for which the state below was initialized, or zero if it
+     * must be reset on the next sample.
+     */
+    uint8_t loop_time;
+    /**
+     * Ring buffer of position samples, large enough for the full window at
+     * loop times of at least ::PBIO_CONFIG_CONTROL_LOOP_TIME_MS.
      */
     pbio_angle_t history[PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS / PBIO_CONFIG_CONTROL_LOOP_TIME_MS];
     /**
      * Ring buffer index.
      */
     uint8_t index;
+    /**
+     * Number of samples in the window, which depends on the loop time.
+     */
+    uint8_t num_samples;
+    /**
+     * Angle estimated by the alpha-beta filter.
+     */
+    pbio_angle_t angle;
+    /**
+     * Speed estimated by the alpha-beta filter.
+     */
+    int32_t speed;
+    /**
+     * Gains of the alpha-beta filter, scaled by 2**16.
+     */
+    int32_t alpha;
+    int32_t beta;
+    /**
+     * Angle at the most recent encoder edge.
+     */
+    pbio_angle_t edge_angle;
+    /**
+     * Time from the most recent encoder edge to the latest sample, in us.
+     */
+    uint32_t edge_elapsed;
+    /**
+     * Speed measured from the time between the two most recent edges.
+     */
+    int32_t edge_speed;
+    /**
+     * Direction of the most recent edge: 1, -1, or 0 if not known yet.
+     */
+    int8_t edge_direction;
 } pbio_differentiator_t;
 
-int32_t pbio_differentiator_get_speed(pbio_differentiator_t *dif, const pbio_angle_t *angle);
+int32_t pbio_differentiator_get_speed(pbio_differentiator_t *dif, const pbio_angle_t *angle, uint32_t edge_age);
 
 void pbio_differentiator_reset(pbio_differentiator_t *dif, const pbio_angle_t *angle);
 
+pbio_error_t pbio_differentiator_set_filter(pbio_differentiator_t *dif, pbio_differentiator_filter_t filter, uint32_t time_ms);
+
 #endif // _PBIO_DIFFERENTIATOR_H_
 
 /** @} */
@@ -35,6 +35,8 @@ pbio_error_t pbio_drivebase_is_stalled(pbio_drivebase_t *db, bool *stalled, uint
 
 pbio_error_t pbio_drivebase_drive_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_drivebase_drive_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_drivebase_queue_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_drivebase_queue_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion);
 
 // Infinite driving:
 
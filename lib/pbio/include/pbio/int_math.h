@@ -11,9 +11,49 @@
 #ifndef _pbio_int_math_H_
 #define _pbio_int_math_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+/**
+ * Point on a curve for linear interpolation.
+ */
+typedef struct _pbio_int_math_point_t {
+    int16_t x;
+    int16_t y;
+} pbio_int_math_point_t;
+
+/**
+ * Precomputed reciprocal of a positive divisor.
+ *
+ * Dividing by a reciprocal takes a multiplication and a shift, which is much
+ * faster than a division on platforms without a hardware divider.
+ */
+typedef struct _pbio_int_math_reciprocal_t {
+    /**
+     * The divisor. Must be positive.
+     */
+    int32_t divisor;
+    /**
+     * 2**(32 + shift) / divisor, rounded up. This needs up to 33 bits.
+     */
+    uint64_t multiplier;
+    /**
+     * Smallest number of bits such that divisor <= 2**shift.
+     */
+    uint8_t shift;
+} pbio_int_math_reciprocal_t;
+
+/**
+ * Constant initializer for a reciprocal, where @p shift must be the
+ * smallest number such that @p divisor <= 2**shift.
+ */
+#define PBIO_INT_MATH_RECIPROCAL(divisor_, shift_) { \
+        .divisor = (divisor_), \
+        .multiplier = ((uint64_t)1 << (32 + (shift_))) / (divisor_) + 1, \
+        .shift = (shift_), \
+}
+
 // Clamping and binding:
 
 int32_t pbio_int_math_bind(int32_t value, int32_t min, int32_t max);
@@ -30,9 +70,16 @@ int32_t pbio_int_math_sign(int32_t a);
 // Integer re-implementations of selected math functions.
 
 int32_t pbio_int_math_atan2(int32_t y, int32_t x);
+int32_t pbio_int_math_interpolate(const pbio_int_math_point_t *points, size_t len, int32_t x);
 int32_t pbio_int_math_mult_then_div(int32_t a, int32_t b, int32_t c);
 int32_t pbio_int_math_sqrt(int32_t n);
 
+// Division by precomputed reciprocals.
+
+void pbio_int_math_reciprocal_init(pbio_int_math_reciprocal_t *r, int32_t divisor);
+int32_t pbio_int_math_div_by_reciprocal(int32_t a, const pbio_int_math_reciprocal_t *r);
+int32_t pbio_int_math_mult_then_div_by_reciprocal(int32_t a, int32_t b, const pbio_int_math_reciprocal_t *r);
+
 #endif // _pbio_int_math_H_
 
 /** @} */
@@ -48,8 +48,8 @@ uint32_t pbio_position_integrator_get_ref_time(pbio_position_integrator_t *itg,
 void pbio_position_integrator_pause(pbio_position_integrator_t *itg, uint32_t time_now);
 void pbio_position_integrator_resume(pbio_position_integrator_t *itg, uint32_t time_now);
 void pbio_position_integrator_reset(pbio_position_integrator_t *itg, pbio_control_settings_t *settings, uint32_t time_now);
-int32_t pbio_position_integrator_update(pbio_position_integrator_t *itg, int32_t position_error, int32_t position_remaining);
-bool pbio_position_integrator_stalled(pbio_position_integrator_t *itg, uint32_t time_now, int32_t speed_now, int32_t speed_ref);
+int32_t pbio_position_integrator_update(pbio_position_integrator_t *itg, int32_t position_error, int32_t position_remaining, int32_t pid_kp, int32_t pid_ki);
+bool pbio_position_integrator_stalled(pbio_position_integrator_t *itg, uint32_t time_now, int32_t speed_now, int32_t speed_ref, int32_t pid_ki);
 
 #endif // _PBIO_INTEGRATOR_H_
 
@@ -11,11 +11,13 @@
 #ifndef _PBIO_IODEV_H_
 #define _PBIO_IODEV_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include <lego_uart.h>
 
+#include "pbio/config.h"
 #include "pbio/port.h"
 
 /**
@@ -422,6 +424,11 @@ typedef enum {
  */
 #define PBIO_IODEV_UOM_SIZE         LUMP_MAX_UOM_SIZE
 
+/**
+ * Max number of modes that can be combined with ::pbio_iodev_set_combi_mode_begin().
+ */
+#define PBIO_IODEV_MAX_COMBI_MODES  (4)
+
 /**
  * I/O device capability flags.
  */
@@ -538,6 +545,45 @@ typedef struct {
     pbio_iodev_mode_t mode_info[0];
 } pbio_iodev_info_t;
 
+/**
+ * Most recent data received for one mode of an I/O device.
+ */
+typedef struct {
+    /**
+     * Time (ms) at which the data was received.
+     */
+    uint32_t time;
+    /**
+     * Whether data was received since the mode or mode combination was last
+     * changed.
+     */
+    bool valid;
+    /**
+     * Binary data in the format given by the ::pbio_iodev_mode_t info of
+     * this mode.
+     */
+    uint8_t bin_data[PBIO_IODEV_MAX_DATA_SIZE]  __attribute__((aligned(4)));
+} pbio_iodev_mode_data_t;
+
+/**
+ * Data sample received from an I/O device.
+ */
+typedef struct {
+    /**
+     * Time (ms) at which the data was received.
+     */
+    uint32_t time;
+    /**
+     * The mode of the data.
+     */
+    uint8_t mode;
+    /**
+     * Binary data in the format given by the ::pbio_iodev_mode_t info of
+     * the mode.
+     */
+    uint8_t bin_data[PBIO_IODEV_MAX_DATA_SIZE]  __attribute__((aligned(4)));
+} pbio_iodev_sample_t;
+
 /**
  * Data structure for holding an I/O device's state.
  */
@@ -558,6 +604,9 @@ typedef struct {
     pbio_error_t (*write_begin)(pbio_iodev_t *iodev, const uint8_t *data, uint8_t size);
     pbio_error_t (*write_end)(pbio_iodev_t *iodev);
     void (*write_cancel)(pbio_iodev_t *iodev);
+    pbio_error_t (*set_combi_mode_begin)(pbio_iodev_t *iodev, const uint8_t *modes, uint8_t num_modes);
+    pbio_error_t (*set_combi_mode_end)(pbio_iodev_t *iodev);
+    void (*set_combi_mode_cancel)(pbio_iodev_t *iodev);
 } pbio_iodev_ops_t;
 
 struct _pbio_iodev_t {
@@ -584,6 +633,31 @@ struct _pbio_iodev_t {
      * the values could be foreign-endian.
      */
     uint8_t bin_data[PBIO_IODEV_MAX_DATA_SIZE]  __attribute__((aligned(4)));
+    /**
+     * Time (ms) at which *bin_data* was received.
+     */
+    uint32_t time;
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    /**
+     * Most recent data of each mode, including modes that are streamed
+     * together in a mode combination.
+     */
+    pbio_iodev_mode_data_t mode_data[PBIO_IODEV_MAX_NUM_MODES];
+    #endif
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    /**
+     * Ring buffer of samples that have been received but not yet read.
+     */
+    pbio_iodev_sample_t history[PBIO_CONFIG_IODEV_HISTORY_SIZE];
+    /**
+     * Index of the oldest sample in *history*.
+     */
+    uint8_t history_start;
+    /**
+     * Number of samples in *history*.
+     */
+    uint8_t history_count;
+    #endif
 };
 
 /** @endcond */
@@ -600,6 +674,12 @@ void pbio_iodev_set_data_cancel(pbio_iodev_t *iodev);
 pbio_error_t pbio_iodev_write_begin(pbio_iodev_t *iodev, const uint8_t *data, uint8_t size);
 pbio_error_t pbio_iodev_write_end(pbio_iodev_t *iodev);
 void pbio_iodev_write_cancel(pbio_iodev_t *iodev);
+pbio_error_t pbio_iodev_set_combi_mode_begin(pbio_iodev_t *iodev, const uint8_t *modes, uint8_t num_modes);
+pbio_error_t pbio_iodev_set_combi_mode_end(pbio_iodev_t *iodev);
+void pbio_iodev_set_combi_mode_cancel(pbio_iodev_t *iodev);
+pbio_error_t pbio_iodev_get_mode_data(pbio_iodev_t *iodev, uint8_t mode, uint8_t **data, uint32_t *time);
+void pbio_iodev_add_sample(pbio_iodev_t *iodev, uint8_t mode, const uint8_t *data, uint8_t size, uint32_t time);
+pbio_error_t pbio_iodev_read_history(pbio_iodev_t *iodev, uint8_t mode, uint8_t *buf, size_t size, size_t *written);
 
 #endif // _PBIO_IODEV_H_
 
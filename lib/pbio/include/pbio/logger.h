@@ -27,6 +27,14 @@ typedef struct _pbio_log_t {
      * Whether data should be logged.
      */
     bool active;
+    /**
+     * Whether the buffer is used as a ring that is drained while logging.
+     */
+    bool stream;
+    /**
+     * Whether rows are stored as varint-encoded deltas instead of raw values.
+     */
+    bool compressed;
     /**
      * Number of columns.
      */
@@ -36,9 +44,42 @@ typedef struct _pbio_log_t {
      */
     uint32_t num_rows;
     /**
-     * How many rows have been used (filled) so far.
+     * How many rows have been used (filled) so far. In stream mode, this is
+     * the number of rows that have not yet been read.
      */
     uint32_t num_rows_used;
+    /**
+     * Index of the oldest row in the buffer. Always 0 unless streaming.
+     */
+    uint32_t first_row;
+    /**
+     * Number of values of the oldest row that have already been read.
+     */
+    uint32_t first_row_values_read;
+    /**
+     * Total number of values read from the stream so far.
+     */
+    uint32_t num_values_read;
+    /**
+     * Number of rows discarded because the stream was not drained quickly enough.
+     */
+    uint32_t num_rows_dropped;
+    /**
+     * Size of the compressed data area in bytes.
+     */
+    uint32_t num_bytes;
+    /**
+     * How many bytes of the compressed data area have been used so far.
+     */
+    uint32_t num_bytes_used;
+    /**
+     * Number of compressed rows decoded so far by the reader.
+     */
+    uint32_t num_rows_decoded;
+    /**
+     * Offset into the compressed data area of the next row to decode.
+     */
+    uint32_t decode_offset;
     /**
      * Data buffer allocated by external application.
      */
@@ -65,19 +106,31 @@ typedef struct _pbio_log_t {
 #define PBIO_LOGGER_NUM_DEFAULT_COLS (1)
 
 void pbio_logger_start(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample);
+void pbio_logger_start_stream(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample);
+void pbio_logger_start_compressed(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample);
 void pbio_logger_stop(pbio_log_t *log);
+void pbio_logger_stop_stream(void);
 bool pbio_logger_is_active(pbio_log_t *log);
 void pbio_logger_add_row(pbio_log_t *log, int32_t *row_data);
 
 uint32_t pbio_logger_get_num_rows_used(pbio_log_t *log);
 int32_t *pbio_logger_get_row_data(pbio_log_t *log, uint32_t index);
 
+pbio_log_t *pbio_logger_get_stream(void);
+uint32_t pbio_logger_read_stream(pbio_log_t *log, int32_t *values, uint32_t max_values, uint32_t *index);
+
 #else
 
 static inline void pbio_logger_start(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
 }
+static inline void pbio_logger_start_stream(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
+}
+static inline void pbio_logger_start_compressed(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
+}
 static inline void pbio_logger_stop(pbio_log_t *log) {
 }
+static inline void pbio_logger_stop_stream(void) {
+}
 static inline bool pbio_logger_is_active(pbio_log_t *log) {
     return false;
 }
@@ -89,6 +142,12 @@ static inline uint32_t pbio_logger_get_num_rows_used(pbio_log_t *log) {
 static inline int32_t *pbio_logger_get_row_data(pbio_log_t *log, uint32_t index) {
     return NULL;
 }
+static inline pbio_log_t *pbio_logger_get_stream(void) {
+    return NULL;
+}
+static inline uint32_t pbio_logger_read_stream(pbio_log_t *log, int32_t *values, uint32_t max_values, uint32_t *index) {
+    return 0;
+}
 
 #endif // PBIO_CONFIG_LOGGER
 
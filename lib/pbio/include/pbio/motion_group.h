@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+/**
+ * @addtogroup MotionGroup pbio/motion_group: Coordinated motion of several servos
+ *
+ * Moves any number of servos such that they start and finish together.
+ * @{
+ */
+
+#ifndef _PBIO_MOTION_GROUP_H_
+#define _PBIO_MOTION_GROUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+#include <pbio/servo.h>
+
+#if PBIO_CONFIG_NUM_MOTION_GROUPS > 0
+
+/**
+ * Group of servos that move in a coordinated way.
+ *
+ * Each servo keeps using its own controller. Commands to the group give all
+ * servos a trajectory with the same start time and duration, so they move in
+ * a straight line in joint space.
+ */
+typedef struct _pbio_motion_group_t {
+    /**
+     * The servos in this group.
+     */
+    pbio_servo_t *axes[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    /**
+     * Number of servos in this group.
+     */
+    uint8_t num_axes;
+    /**
+     * Whether the servos are running a group command.
+     */
+    bool active;
+} pbio_motion_group_t;
+
+pbio_error_t pbio_motion_group_get_motion_group(pbio_motion_group_t **group_address, pbio_servo_t **axes, uint8_t num_axes);
+
+// Motion group status:
+
+bool pbio_motion_group_update_loop_is_running(pbio_motion_group_t *group);
+bool pbio_motion_group_is_done(pbio_motion_group_t *group);
+pbio_error_t pbio_motion_group_is_stalled(pbio_motion_group_t *group, bool *stalled, uint32_t *stall_duration);
+
+// Coordinated point to point control:
+
+pbio_error_t pbio_motion_group_run_target(pbio_motion_group_t *group, int32_t speed, const int32_t *targets, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_motion_group_run_angle(pbio_motion_group_t *group, int32_t speed, const int32_t *angles, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_motion_group_stop(pbio_motion_group_t *group, pbio_control_on_completion_t on_completion);
+
+#endif // PBIO_CONFIG_NUM_MOTION_GROUPS > 0
+
+#endif // _PBIO_MOTION_GROUP_H_
+
+/** @} */
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+/**
+ * @addtogroup MotorProcess pbio/motor_process: Background control loop
+ *
+ * Optional profiling of the background control loop that updates the
+ * battery, drive bases and servos.
+ * @{
+ */
+
+#ifndef _PBIO_MOTOR_PROCESS_H_
+#define _PBIO_MOTOR_PROCESS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+
+/**
+ * Stages of one control loop iteration.
+ */
+typedef enum {
+    /** Battery voltage update. */
+    PBIO_MOTOR_PROCESS_STAGE_BATTERY,
+    /** Drive base updates. */
+    PBIO_MOTOR_PROCESS_STAGE_DRIVEBASE,
+    /** Servo updates. */
+    PBIO_MOTOR_PROCESS_STAGE_SERVO,
+    /** Number of stages. */
+    PBIO_MOTOR_PROCESS_NUM_STAGES,
+} pbio_motor_process_stage_t;
+
+/**
+ * Number of bins in the loop period jitter histogram.
+ */
+#define PBIO_MOTOR_PROCESS_JITTER_NUM_BINS (8)
+
+/**
+ * Width of one bin in the loop period jitter histogram, in microseconds.
+ */
+#define PBIO_MOTOR_PROCESS_JITTER_BIN_US (500)
+
+/**
+ * Statistics of a measured duration.
+ */
+typedef struct _pbio_motor_process_timing_t {
+    /** Shortest duration in microseconds. */
+    uint32_t min;
+    /** Longest duration in microseconds. */
+    uint32_t max;
+    /** Sum of all durations in microseconds. */
+    uint64_t sum;
+    /** Number of measurements. */
+    uint32_t count;
+} pbio_motor_process_timing_t;
+
+/**
+ * Profile of the control loop, collected since it was last reset.
+ */
+typedef struct _pbio_motor_process_profile_t {
+    /** Execution time of each stage. */
+    pbio_motor_process_timing_t stages[PBIO_MOTOR_PROCESS_NUM_STAGES];
+    /** Time between the start of consecutive loop iterations. */
+    pbio_motor_process_timing_t period;
+    /**
+     * Histogram of the absolute difference between the actual and nominal
+     * loop period. The last bin also counts all larger differences.
+     */
+    uint32_t jitter[PBIO_MOTOR_PROCESS_JITTER_NUM_BINS];
+    /** Number of iterations that took longer than one loop period to execute. */
+    uint32_t num_overruns;
+    /** Number of iterations that started one or more loop periods late. */
+    uint32_t num_late;
+} pbio_motor_process_profile_t;
+
+#if PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+void pbio_motor_process_profile_reset(void);
+const pbio_motor_process_profile_t *pbio_motor_process_get_profile(void);
+uint32_t pbio_motor_process_timing_get_mean(const pbio_motor_process_timing_t *timing);
+
+#else
+
+static inline void pbio_motor_process_profile_reset(void) {
+}
+static inline const pbio_motor_process_profile_t *pbio_motor_process_get_profile(void) {
+    return NULL;
+}
+static inline uint32_t pbio_motor_process_timing_get_mean(const pbio_motor_process_timing_t *timing) {
+    return 0;
+}
+
+#endif // PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+#endif // _PBIO_MOTOR_PROCESS_H_
+
+/** @} */
@@ -13,6 +13,7 @@
 
 #include <stdint.h>
 
+#include <pbio/config.h>
 #include <pbio/control_settings.h>
 #include <pbio/dcmotor.h>
 #include <pbio/differentiator.h>
@@ -45,6 +46,11 @@ typedef struct _pbio_observer_model_t {
     int32_t gain;
 } pbio_observer_model_t;
 
+/**
+ * Fixed point scale of the first order model parameters.
+ */
+#define PBIO_OBSERVER_FIRST_ORDER_ONE ((int64_t)1 << 30)
+
 /**
  * Motor state observer object.
  */
@@ -81,6 +87,19 @@ typedef struct _pbio_observer_t {
      * Model parameters used by this model.
      */
     const pbio_observer_model_t *model;
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS < PBIO_CONFIG_CONTROL_LOOP_TIME_MS
+    /**
+     * Model for a loop time shorter than ::PBIO_CONFIG_CONTROL_LOOP_TIME_MS,
+     * made from @p model.
+     */
+    pbio_observer_model_t step_model;
+    /**
+     * Model and loop time from which @p step_model was made, or NULL and
+     * zero if it must be made again.
+     */
+    const pbio_observer_model_t *step_model_base;
+    uint8_t step_model_time;
+    #endif
     /**
      * Control settings, which includes stall settings.
      */
@@ -91,7 +110,7 @@ typedef struct _pbio_observer_t {
 
 void pbio_observer_reset(pbio_observer_t *obs, pbio_control_settings_t *settings, const pbio_angle_t *angle);
 void pbio_observer_get_estimated_state(const pbio_observer_t *obs, int32_t *speed_num, pbio_angle_t *angle_est, int32_t *speed_est);
-void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_t *angle, pbio_dcmotor_actuation_t actuation, int32_t voltage);
+void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_t *angle, uint32_t edge_age, pbio_dcmotor_actuation_t actuation, int32_t voltage);
 bool pbio_observer_is_stalled(const pbio_observer_t *obs, uint32_t time, uint32_t *stall_duration);
 int32_t pbio_observer_get_feedback_torque(pbio_observer_t *obs, const pbio_angle_t *angle);
 
@@ -100,6 +119,8 @@ int32_t pbio_observer_get_feedback_torque(pbio_observer_t *obs, const pbio_angle
 int32_t pbio_observer_get_feedforward_torque(const pbio_observer_model_t *model, int32_t rate_ref, int32_t acceleration_ref);
 int32_t pbio_observer_torque_to_voltage(const pbio_observer_model_t *model, int32_t desired_torque);
 int32_t pbio_observer_voltage_to_torque(const pbio_observer_model_t *model, int32_t voltage);
+pbio_error_t pbio_observer_model_from_first_order(pbio_observer_model_t *model, const pbio_observer_model_t *base, uint32_t step, int64_t alpha, int64_t beta, int64_t gamma);
+pbio_error_t pbio_observer_model_for_step(pbio_observer_model_t *model, const pbio_observer_model_t *base, uint32_t step);
 
 #endif // _PBIO_OBSERVER_H_
 
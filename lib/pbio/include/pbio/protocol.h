@@ -24,7 +24,7 @@
 #define PBIO_PROTOCOL_VERSION_MAJOR 1
 
 /** The minor version number for the protocol. */
-#define PBIO_PROTOCOL_VERSION_MINOR 2
+#define PBIO_PROTOCOL_VERSION_MINOR 3
 
 /** The patch version number for the protocol. */
 #define PBIO_PROTOCOL_VERSION_PATCH 0
@@ -156,8 +156,28 @@ typedef enum {
      * @since Protocol v1.0.0
      */
     PBIO_PYBRICKS_EVENT_STATUS_REPORT = 0,
+    /**
+     * Streamed log data.
+     *
+     * The payload is:
+     * - num_cols: The number of values per row of the log (8-bit unsigned integer).
+     * - index: The index of the first value in this event, counting from the
+     *   first value of the stream (16-bit little-endian unsigned integer,
+     *   wraps around). Rows start at multiples of num_cols.
+     * - values: Up to ::PBIO_PYBRICKS_EVENT_LOG_DATA_MAX_VALUES values
+     *   (32-bit little-endian signed integers).
+     *
+     * @since Protocol v1.3.0
+     */
+    PBIO_PYBRICKS_EVENT_LOG_DATA = 1,
 } pbio_pybricks_event_t;
 
+/**
+ * Maximum number of values in one ::PBIO_PYBRICKS_EVENT_LOG_DATA event, such
+ * that it fits in the minimum characteristic size of 20 bytes.
+ */
+#define PBIO_PYBRICKS_EVENT_LOG_DATA_MAX_VALUES (4)
+
 /**
  * Hub status indicators.
  *
@@ -231,6 +251,7 @@ typedef enum {
 #define PBIO_PYBRICKS_STATUS_FLAG(status) (1 << status)
 
 uint32_t pbio_pybricks_event_status_report(uint8_t *buf, uint32_t flags);
+uint32_t pbio_pybricks_event_log_data(uint8_t *buf, uint8_t num_cols, uint32_t index, const int32_t *values, uint32_t num_values);
 
 /**
  * Application-specific feature flag supported by a hub.
@@ -94,6 +94,8 @@ pbio_error_t pbio_servo_get_state_user(pbio_servo_t *srv, int32_t *angle, int32_
 bool pbio_servo_update_loop_is_running(pbio_servo_t *srv);
 pbio_error_t pbio_servo_is_stalled(pbio_servo_t *srv, bool *stalled, uint32_t *stall_duration);
 pbio_error_t pbio_servo_get_load(pbio_servo_t *srv, int32_t *load);
+pbio_error_t pbio_servo_get_speed_filter(pbio_servo_t *srv, pbio_differentiator_filter_t *filter, uint32_t *time_ms);
+pbio_error_t pbio_servo_set_speed_filter(pbio_servo_t *srv, pbio_differentiator_filter_t filter, uint32_t time_ms);
 
 // Servo end user commands:
 
@@ -104,6 +106,7 @@ pbio_error_t pbio_servo_run_time(pbio_servo_t *srv, int32_t speed, uint32_t dura
 pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, int32_t speed, int32_t angle, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, int32_t speed, int32_t target, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_servo_track_target(pbio_servo_t *srv, int32_t target);
+pbio_error_t pbio_servo_queue_target(pbio_servo_t *srv, int32_t speed, int32_t target, pbio_control_on_completion_t on_completion);
 
 #endif // PBIO_CONFIG_SERVO
 
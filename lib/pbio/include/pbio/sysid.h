@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+/**
+ * @addtogroup SysId pbio/sysid: Motor model identification
+ *
+ * Identifies the motor model of a servo by applying a short excitation
+ * sequence and fitting a first order model to the measured angles.
+ * @{
+ */
+
+#ifndef _PBIO_SYSID_H_
+#define _PBIO_SYSID_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+#include <pbio/error.h>
+#include <pbio/observer.h>
+#include <pbio/servo.h>
+
+/**
+ * Number of parameters of the first order model.
+ */
+#define PBIO_SYSID_NUM_PARAMETERS (3)
+
+/**
+ * Number of control loop iterations summed into each sample of the fit.
+ */
+#define PBIO_SYSID_WINDOW (16)
+
+/**
+ * Least squares fit of the first order model:
+ *
+ *     d(k + 1) = alpha * d(k) + beta * voltage(k + 1) - gamma * sign(d(k))
+ *
+ * where d(k) is the angle increment caused by voltage(k) during one control
+ * loop iteration.
+ *
+ * The measured angle is rounded to whole degrees, which is a large error on
+ * the increment of a single iteration. So each sample is the sum of this
+ * equation over ::PBIO_SYSID_WINDOW iterations. This holds just as well, but
+ * the summed increments are differences of angles that are further apart,
+ * so the rounding error is relatively small.
+ *
+ * Samples are accumulated as they arrive, so no sample buffer is needed.
+ */
+typedef struct _pbio_sysid_fit_t {
+    /**
+     * Sums of products of the scaled regressors.
+     */
+    int64_t normal[PBIO_SYSID_NUM_PARAMETERS][PBIO_SYSID_NUM_PARAMETERS];
+    /**
+     * Sums of products of the scaled regressors and the target.
+     */
+    int64_t target[PBIO_SYSID_NUM_PARAMETERS];
+    /**
+     * Number of samples added so far.
+     */
+    uint32_t num_samples;
+} pbio_sysid_fit_t;
+
+void pbio_sysid_fit_reset(pbio_sysid_fit_t *fit);
+void pbio_sysid_fit_add(pbio_sysid_fit_t *fit, int32_t angle_change, int32_t voltage_sum, int32_t direction_sum, int32_t angle_change_next);
+pbio_error_t pbio_sysid_fit_solve(pbio_sysid_fit_t *fit, int64_t *alpha, int64_t *beta, int64_t *gamma);
+
+#if PBIO_CONFIG_SYSID
+
+/**
+ * Identification state of one servo.
+ */
+typedef struct _pbio_sysid_t {
+    /**
+     * The servo being identified.
+     */
+    pbio_servo_t *srv;
+    /**
+     * Result of the identification, or ::PBIO_ERROR_AGAIN while it runs.
+     */
+    pbio_error_t status;
+    /**
+     * Amplitude of the excitation voltage in mV.
+     */
+    int32_t voltage;
+    /**
+     * Number of control loop iterations since the start.
+     */
+    uint32_t count;
+    /**
+     * Angle at the previous iteration.
+     */
+    pbio_angle_t angle;
+    /**
+     * Voltage applied at the previous iteration.
+     */
+    int32_t voltage_applied;
+    /**
+     * Recent angle increments and the voltages that caused them, indexed
+     * by the iteration count modulo the buffer size.
+     */
+    int32_t increments[PBIO_SYSID_WINDOW + 1];
+    int32_t voltages[PBIO_SYSID_WINDOW + 1];
+    /**
+     * Least squares fit of the samples so far.
+     */
+    pbio_sysid_fit_t fit;
+    /**
+     * Identified model, used by the observer when identification succeeds.
+     */
+    pbio_observer_model_t model;
+} pbio_sysid_t;
+
+pbio_error_t pbio_sysid_start(pbio_servo_t *srv, int32_t voltage);
+pbio_error_t pbio_sysid_get_status(pbio_servo_t *srv);
+void pbio_sysid_update_all(void);
+
+#else // PBIO_CONFIG_SYSID
+
+static inline void pbio_sysid_update_all(void) {
+}
+
+#endif // PBIO_CONFIG_SYSID
+
+#endif // _PBIO_SYSID_H_
+
+/** @} */
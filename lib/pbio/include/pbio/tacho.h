@@ -27,6 +27,7 @@ pbio_error_t pbio_tacho_get_tacho(pbio_port_id_t port, pbio_tacho_t **tacho);
 pbio_error_t pbio_tacho_setup(pbio_tacho_t *tacho, pbio_direction_t direction, bool reset_angle);
 
 pbio_error_t pbio_tacho_get_angle(pbio_tacho_t *tacho, pbio_angle_t *angle);
+pbio_error_t pbio_tacho_get_angle_and_edge_age(pbio_tacho_t *tacho, pbio_angle_t *angle, uint32_t *age);
 pbio_error_t pbio_tacho_reset_angle(pbio_tacho_t *tacho, pbio_angle_t *reset_angle, bool reset_to_abs);
 
 #else
@@ -43,6 +44,9 @@ static inline pbio_error_t pbio_tacho_setup(pbio_tacho_t *tacho, pbio_direction_
 static inline pbio_error_t pbio_tacho_get_angle(pbio_tacho_t *tacho, pbio_angle_t *angle) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
+static inline pbio_error_t pbio_tacho_get_angle_and_edge_age(pbio_tacho_t *tacho, pbio_angle_t *angle, uint32_t *age) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 static inline pbio_tacho_reset_angle(pbio_tacho_t * tacho, pbio_angle_t * reset_angle, bool reset_to_abs) {
     return PBIO_ERROR_NOT_SUPPORTED;
 }
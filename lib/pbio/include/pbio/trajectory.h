@@ -25,6 +25,24 @@
 // acceleration part of the maneuver.
 #define PBIO_TRAJECTORY_DURATION_FOREVER_MS (5 * 60 * 1000)
 
+/**
+ * Shape of the speed curve during acceleration and deceleration.
+ */
+typedef enum {
+    /**
+     * Speed changes linearly, with a constant acceleration. This is the
+     * fastest way to change speed, but the acceleration changes instantly
+     * at the start and end of each ramp.
+     */
+    PBIO_TRAJECTORY_PROFILE_TRAPEZOID,
+    /**
+     * Speed changes along an S-shaped curve, so the acceleration rises and
+     * falls gradually. The peak acceleration equals the configured value, so
+     * each ramp takes 1.5 times as long as with the trapezoidal profile.
+     */
+    PBIO_TRAJECTORY_PROFILE_S_CURVE,
+} pbio_trajectory_profile_t;
+
 /**
  * Minimal set of trajectory parameters from which a full trajectory is
  * calculated. All values in control units and time in ticks.
@@ -40,6 +58,7 @@ typedef struct _pbio_trajectory_command_t {
     int32_t acceleration;          /**<  Encoder acceleration magnitude during in-phase */
     int32_t deceleration;          /**<  Encoder acceleration magnitude during out-phase */
     bool continue_running;         /**<  Whether it movement continues after t3 (true) or not (false) */
+    pbio_trajectory_profile_t profile; /**<  Shape of the acceleration and deceleration phases */
 } pbio_trajectory_command_t;
 
 /**
@@ -52,6 +71,31 @@ typedef struct _pbio_trajectory_reference_t {
     int32_t acceleration;   /**<  Reference acceleration */
 } pbio_trajectory_reference_t;
 
+/**
+ * Most recently evaluated point on a trajectory, along with its increments
+ * for the next time step. While the reference is polled at a constant
+ * interval within one phase of the trajectory, it can be advanced with
+ * additions only. Angles and speeds are stored as a quotient and a remainder,
+ * so no round off errors accumulate.
+ */
+typedef struct _pbio_trajectory_cache_t {
+    bool valid;                          /**<  Whether the cached point belongs to the current trajectory */
+    int32_t time;                        /**<  Time of the cached point since the start of the trajectory */
+    int32_t time_step;                   /**<  Time step for which the increments are valid, or 0 if none */
+    int32_t time_end;                    /**<  End of the phase of the trajectory that contains the cached point */
+    int32_t th;                          /**<  Angle at cached point */
+    int32_t th_rem;                      /**<  Remainder of angle at cached point */
+    int32_t w;                           /**<  Speed at cached point */
+    int32_t w_rem;                       /**<  Remainder of speed change since start of phase */
+    int32_t a;                           /**<  Acceleration at cached point */
+    int32_t dth;                         /**<  Angle increment for the next step */
+    int32_t dth_rem;                     /**<  Remainder of angle increment for the next step */
+    int32_t ddth;                        /**<  Change of the angle increment per step */
+    int32_t ddth_rem;                    /**<  Remainder of change of the angle increment per step */
+    int32_t dw;                          /**<  Absolute speed increment per step */
+    int32_t dw_rem;                      /**<  Remainder of absolute speed increment per step */
+} pbio_trajectory_cache_t;
+
 /**
  * Complete set of motor trajectory parameters for an ideal maneuver without
  * disturbances. These values have custom units to keep them within safe
@@ -71,6 +115,8 @@ typedef struct _pbio_trajectory_t {
     int32_t w3;                          /**<  Encoder rate target after the maneuver ends */
     int32_t a0;                          /**<  Encoder acceleration during in-phase */
     int32_t a2;                          /**<  Encoder acceleration during out-phase */
+    pbio_trajectory_profile_t profile;   /**<  Shape of the acceleration and deceleration phases */
+    pbio_trajectory_cache_t cache;       /**<  Most recently evaluated reference point */
 } pbio_trajectory_t;
 
 // Make or modify trajectories:
@@ -79,6 +125,7 @@ pbio_error_t pbio_trajectory_new_angle_command(pbio_trajectory_t *trj, const pbi
 pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 void pbio_trajectory_make_constant(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 void pbio_trajectory_stretch(pbio_trajectory_t *trj, pbio_trajectory_t *leader);
+void pbio_trajectory_synchronize(pbio_trajectory_t **trajectories, uint8_t num_trajectories);
 
 // Reference getter functions:
 
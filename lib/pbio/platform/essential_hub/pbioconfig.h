@@ -2,8 +2,12 @@
 // Copyright (c) 2019-2022 The Pybricks Authors
 
 #define PBIO_CONFIG_BATTERY                 (1)
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS (1)
+#define PBIO_CONFIG_CONTROL_QUEUE_SIZE      (4)
 #define PBIO_CONFIG_DCMOTOR                 (1)
 #define PBIO_CONFIG_DRIVEBASE_SPIKE         (1)
+#define PBIO_CONFIG_IODEV_HISTORY_SIZE      (32)
+#define PBIO_CONFIG_IODEV_MODE_DATA         (1)
 #define PBIO_CONFIG_LIGHT                   (1)
 #define PBIO_CONFIG_LOGGER                  (1)
 #define PBIO_CONFIG_LIGHT_MATRIX            (0)
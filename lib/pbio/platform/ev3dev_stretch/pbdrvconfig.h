@@ -16,6 +16,7 @@
 #define PBDRV_CONFIG_COUNTER_NUM_DEV                        (4)
 #define PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO             (1)
 #define PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_NUM_DEV     (4)
+#define PBDRV_CONFIG_COUNTER_EV3DEV_STRETCH_IIO_BUFFER      (1)
 
 #define PBDRV_CONFIG_IOPORT                                 (1)
 #define PBDRV_CONFIG_IOPORT_EV3DEV_STRETCH                  (1)
@@ -24,6 +25,8 @@
 #define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV                   (4)
 #define PBDRV_CONFIG_MOTOR_DRIVER_EV3DEV_STRETCH            (1)
 
+#define PBDRV_CONFIG_SYSFS                                  (1)
+
 #define PBDRV_CONFIG_HAS_PORT_A (1)
 #define PBDRV_CONFIG_HAS_PORT_B (1)
 #define PBDRV_CONFIG_HAS_PORT_C (1)
@@ -2,14 +2,17 @@
 // Copyright (c) 2019-2022 The Pybricks Authors
 
 #define PBIO_CONFIG_BATTERY                 (1)
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS (1)
 #define PBIO_CONFIG_DCMOTOR                 (1)
 #define PBIO_CONFIG_DRIVEBASE_SPIKE         (0)
 #define PBIO_CONFIG_LOGGER                  (1)
+#define PBIO_CONFIG_MOTION_GROUP            (1)
 
 #define PBIO_CONFIG_SERVO                   (1)
 #define PBIO_CONFIG_SERVO_EV3_NXT           (1)
 #define PBIO_CONFIG_SERVO_PUP               (0)
 #define PBIO_CONFIG_SERVO_PUP_MOVE_HUB      (0)
+#define PBIO_CONFIG_SYSID                   (1)
 #define PBIO_CONFIG_TACHO                   (1)
 
 #define PBIO_CONFIG_UARTDEV                 (0)
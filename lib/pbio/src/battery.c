@@ -14,10 +14,32 @@
 // Slow moving average battery voltage.
 static int32_t battery_voltage_avg_scaled;
 
+// Fast moving average battery voltage. This follows voltage sag under load
+// within a few control loop iterations, so it is used to compensate the
+// motor duty cycle.
+static int32_t battery_voltage_fast_scaled;
+
+// Reciprocal of the fast average voltage, so that motor duty cycles can be
+// computed without division.
+static pbio_int_math_reciprocal_t battery_voltage_fast_reciprocal;
+
 // The average battery value is scaled up numerically
 // to reduce rounding errors in the moving average.
 #define SCALE (1024)
 
+// Number of samples over which each average is taken.
+#define SLOW_SAMPLES (128)
+#define FAST_SAMPLES (4)
+
+// Refreshes the reciprocal of the fast average voltage. The voltage in mV
+// changes only now and then, so the reciprocal is recomputed only if it does.
+static void pbio_battery_update_reciprocal(void) {
+    int32_t voltage = pbio_int_math_max(battery_voltage_fast_scaled / SCALE, 1);
+    if (battery_voltage_fast_reciprocal.divisor != voltage) {
+        pbio_int_math_reciprocal_init(&battery_voltage_fast_reciprocal, voltage);
+    }
+}
+
 // Initializes average to first measurement.
 pbio_error_t pbio_battery_init(void) {
 
@@ -28,13 +50,15 @@ pbio_error_t pbio_battery_init(void) {
         return err;
     }
 
-    // Initialize average voltage.
+    // Initialize average voltages.
     battery_voltage_avg_scaled = (int32_t)battery_voltage_now_mv * SCALE;
+    battery_voltage_fast_scaled = battery_voltage_avg_scaled;
+    pbio_battery_update_reciprocal();
 
     return PBIO_SUCCESS;
 }
 
-// Updates the average voltage.
+// Updates the average voltages.
 pbio_error_t pbio_battery_update(void) {
 
     // Get battery voltage.
@@ -44,8 +68,10 @@ pbio_error_t pbio_battery_update(void) {
         return err;
     }
 
-    // Update moving average.
-    battery_voltage_avg_scaled = (battery_voltage_avg_scaled * 127 + ((int32_t)battery_voltage_now_mv) * SCALE) / 128;
+    // Update moving averages.
+    battery_voltage_avg_scaled = (battery_voltage_avg_scaled * (SLOW_SAMPLES - 1) + ((int32_t)battery_voltage_now_mv) * SCALE) / SLOW_SAMPLES;
+    battery_voltage_fast_scaled = (battery_voltage_fast_scaled * (FAST_SAMPLES - 1) + ((int32_t)battery_voltage_now_mv) * SCALE) / FAST_SAMPLES;
+    pbio_battery_update_reciprocal();
 
     return PBIO_SUCCESS;
 }
@@ -59,13 +85,16 @@ int32_t pbio_battery_get_average_voltage(void) {
  * Gets the duty cycle required to output the desired voltage given the
  * current battery voltage.
  *
+ * This is used to actuate motors, so it uses the fast average voltage to
+ * compensate for voltage sag under load.
+ *
  * @param [in]  voltage     The desired voltage in mV.
  * @return                  A duty cycle in the range negative ::PBIO_BATTERY_MAX_DUTY
  *                          to positive ::PBIO_BATTERY_MAX_DUTY.
  */
 int32_t pbio_battery_get_duty_from_voltage(int32_t voltage) {
     // Calculate unbounded duty cycle value.
-    int32_t duty_cycle = voltage * PBIO_BATTERY_MAX_DUTY / (battery_voltage_avg_scaled / SCALE);
+    int32_t duty_cycle = pbio_int_math_mult_then_div_by_reciprocal(voltage, PBIO_BATTERY_MAX_DUTY, &battery_voltage_fast_reciprocal);
 
     return pbio_int_math_clamp(duty_cycle, PBIO_BATTERY_MAX_DUTY);
 }
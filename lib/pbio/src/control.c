@@ -33,6 +33,73 @@ bool pbio_control_time_is_later(uint32_t sample, uint32_t base) {
     return sample - base < UINT32_MAX / 2;
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Gets a segment from the queue.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  index           Index relative to the next segment in the queue.
+ * @return                      The segment.
+ */
+static pbio_control_segment_t *pbio_control_queue_get(pbio_control_t *ctl, uint8_t index) {
+    return &ctl->queue[(ctl->queue_first + index) % PBIO_CONFIG_CONTROL_QUEUE_SIZE];
+}
+
+/**
+ * Clears all queued segments.
+ *
+ * @param [in]  ctl             The control instance.
+ */
+static void pbio_control_queue_clear(pbio_control_t *ctl) {
+    ctl->queue_first = 0;
+    ctl->queue_size = 0;
+}
+
+/**
+ * Switches to the next queued segment once the current trajectory has ended.
+ *
+ * Each segment starts at the endpoint of the trajectory before it, so the
+ * reference continues seamlessly at the boundary.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_ref        The time on the trajectory (ticks).
+ */
+static void pbio_control_queue_advance(pbio_control_t *ctl, uint32_t time_ref) {
+
+    // Segments are only queued behind position based trajectories.
+    if (!pbio_control_type_is_position(ctl)) {
+        return;
+    }
+
+    // Move on to the last segment that has started by now. Usually this
+    // is just one, but very short segments may take less than one loop.
+    while (ctl->queue_size > 0) {
+        pbio_control_segment_t *next = pbio_control_queue_get(ctl, 0);
+        if (!pbio_control_time_is_later(time_ref, next->trajectory.start.time)) {
+            return;
+        }
+
+        // Start following the next segment. The control type stays the
+        // same, so the integrators continue as they are.
+        ctl->trajectory = next->trajectory;
+        ctl->on_completion = next->on_completion;
+        ctl->on_target = false;
+        ctl->queue_first = (ctl->queue_first + 1) % PBIO_CONFIG_CONTROL_QUEUE_SIZE;
+        ctl->queue_size--;
+    }
+}
+
+#else // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+static inline void pbio_control_queue_clear(pbio_control_t *ctl) {
+}
+
+static inline void pbio_control_queue_advance(pbio_control_t *ctl, uint32_t time_ref) {
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 static bool pbio_control_check_completion(pbio_control_t *ctl, uint32_t time, pbio_control_state_t *state, pbio_trajectory_reference_t *end) {
 
     // If no control is active, then all targets are complete.
@@ -86,9 +153,15 @@ static bool pbio_control_check_completion(pbio_control_t *ctl, uint32_t time, pb
  */
 void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, pbio_trajectory_reference_t *ref, pbio_dcmotor_actuation_t *actuation, int32_t *control) {
 
+    // Get the reference time point in the trajectory. This compensates for
+    // any time we may have spent pausing when the motor was stalled.
+    uint32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
+
+    // If the trajectory has ended, continue with the next queued segment.
+    pbio_control_queue_advance(ctl, time_ref);
+
     // Get reference signals at the reference time point in the trajectory.
-    // This compensates for any time we may have spent pausing when the motor was stalled.
-    pbio_trajectory_get_reference(&ctl->trajectory, pbio_control_get_ref_time(ctl, time_now), ref);
+    pbio_trajectory_get_reference(&ctl->trajectory, time_ref, ref);
 
     // Get reference point we want to be at in the end, to check for completion.
     pbio_trajectory_reference_t ref_end;
@@ -98,6 +171,10 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
     int32_t position_error = pbio_angle_diff_mdeg(&ref->position, &state->position);
     int32_t speed_error = ref->speed - state->speed_estimate;
 
+    // Get the PID gains for the current reference speed and load.
+    int32_t pid_kp, pid_ki, pid_kd;
+    pbio_control_settings_get_scheduled_pid(&ctl->settings, ref->speed, state->load_estimate, &pid_kp, &pid_ki, &pid_kd);
+
     // Calculate integral control errors, depending on control type.
     int32_t integral_error;
     int32_t position_error_used;
@@ -105,7 +182,7 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
 
         // Update count integral error and get current error state
         int32_t position_remaining = pbio_angle_diff_mdeg(&ref_end.position, &ref->position);
-        integral_error = pbio_position_integrator_update(&ctl->position_integrator, position_error, position_remaining);
+        integral_error = pbio_position_integrator_update(&ctl->position_integrator, position_error, position_remaining, pid_kp, pid_ki);
 
         // For position control, the proportional term is the real position error.
         position_error_used = position_error;
@@ -117,9 +194,9 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
     }
 
     // Corresponding PID control signal
-    int32_t torque_proportional = pbio_control_settings_mul_by_gain(position_error_used, ctl->settings.pid_kp);
-    int32_t torque_derivative = pbio_control_settings_mul_by_gain(speed_error, ctl->settings.pid_kd);
-    int32_t torque_integral = pbio_control_settings_mul_by_gain(integral_error, ctl->settings.pid_ki);
+    int32_t torque_proportional = pbio_control_settings_mul_by_gain(position_error_used, pid_kp);
+    int32_t torque_derivative = pbio_control_settings_mul_by_gain(speed_error, pid_kd);
+    int32_t torque_integral = pbio_control_settings_mul_by_gain(integral_error, pid_ki);
 
     // Total torque signal, capped by the actuation limit
     int32_t torque = pbio_int_math_clamp(torque_proportional + torque_integral + torque_derivative, ctl->settings.actuation_max);
@@ -131,7 +208,7 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
     // if we get at this limit. We wait a little longer though, to make sure it does not fall back to below the limit
     // within one sample, which we can predict using the current rate times the loop time, with a factor two tolerance.
     int32_t windup_margin = pbio_control_settings_mul_by_loop_time(pbio_int_math_abs(state->speed)) * 2;
-    int32_t max_windup_torque = ctl->settings.actuation_max + pbio_control_settings_mul_by_gain(windup_margin, ctl->settings.pid_kp);
+    int32_t max_windup_torque = ctl->settings.actuation_max + pbio_control_settings_mul_by_gain(windup_margin, pid_kp);
 
     // Position anti-windup: pause trajectory or integration if falling behind despite using maximum torque
     bool pause_integration =
@@ -165,14 +242,15 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
 
     // Check if controller is stalled
     ctl->stalled = pbio_control_type_is_position(ctl) ?
-        pbio_position_integrator_stalled(&ctl->position_integrator, time_now, state->speed, ref->speed) :
+        pbio_position_integrator_stalled(&ctl->position_integrator, time_now, state->speed, ref->speed, pid_ki) :
         pbio_speed_integrator_stalled(&ctl->speed_integrator, time_now, state->speed, ref->speed);
 
     // Check if we are on target
     ctl->on_target = pbio_control_check_completion(ctl, ref->time, state, &ref_end);
 
     // Save (low-pass filtered) load for diagnostics
-    ctl->pid_average = (ctl->pid_average * (100 - PBIO_CONFIG_CONTROL_LOOP_TIME_MS) + torque * PBIO_CONFIG_CONTROL_LOOP_TIME_MS) / 100;
+    int32_t loop_time = pbio_control_settings_get_loop_time();
+    ctl->pid_average = (ctl->pid_average * (100 - loop_time) + torque * loop_time) / 100;
 
     // Decide actuation based on whether control is on target.
     if (!ctl->on_target) {
@@ -270,6 +348,7 @@ void pbio_control_update(pbio_control_t *ctl, uint32_t time_now, pbio_control_st
  * @param [in]  ctl         Control status structure.
  */
 void pbio_control_stop(pbio_control_t *ctl) {
+    pbio_control_queue_clear(ctl);
     ctl->type = PBIO_CONTROL_NONE;
     ctl->on_target = true;
     ctl->stalled = false;
@@ -293,6 +372,9 @@ static void pbio_control_set_control_type(pbio_control_t *ctl, uint32_t time_now
         return;
     }
 
+    // A new maneuver replaces anything that was queued after the old one.
+    pbio_control_queue_clear(ctl);
+
     // Set on completion action for this maneuver.
     ctl->on_completion = on_completion;
 
@@ -351,6 +433,7 @@ static pbio_error_t _pbio_control_start_position_control(pbio_control_t *ctl, ui
         .speed_max = ctl->settings.speed_max,
         .acceleration = ctl->settings.acceleration,
         .deceleration = ctl->settings.deceleration,
+        .profile = ctl->settings.profile,
         .continue_running = on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE,
     };
 
@@ -552,6 +635,7 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time
         .speed_max = ctl->settings.speed_max,
         .acceleration = ctl->settings.acceleration,
         .deceleration = ctl->settings.deceleration,
+        .profile = ctl->settings.profile,
         .continue_running = on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE,
     };
 
@@ -619,6 +703,213 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time
     return PBIO_SUCCESS;
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Checks if a new segment has to wait for an ongoing trajectory to end.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @return                      True if the segment must be queued, false if it can start now.
+ */
+bool pbio_control_queue_must_wait(pbio_control_t *ctl, uint32_t time_now) {
+
+    // If there are segments already, the new one goes after them.
+    if (ctl->queue_size > 0) {
+        return true;
+    }
+
+    // Only ongoing position based trajectories are waited for.
+    if (!pbio_control_type_is_position(ctl)) {
+        return false;
+    }
+
+    // If the current trajectory has already ended, we can start right away.
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(&ctl->trajectory, &end);
+    return !pbio_control_time_is_later(pbio_control_get_ref_time(ctl, time_now), end.time);
+}
+
+/**
+ * Adds a position control segment to the queue.
+ *
+ * @param [in]  ctl            The control instance.
+ * @param [in]  target         The target position to run to (control units).
+ * @param [in]  speed          The top speed on the way to the target (control units). The sign is ignored. If zero, default speed is used.
+ * @param [in]  on_completion  What to do when reaching the target position.
+ * @return                     Error code.
+ */
+static pbio_error_t _pbio_control_queue_position_control(pbio_control_t *ctl, pbio_angle_t *target, int32_t speed, pbio_control_on_completion_t on_completion) {
+
+    if (pbio_control_queue_is_full(ctl)) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    // The segment starts where the last trajectory ends.
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(pbio_control_get_last_trajectory(ctl), &end);
+
+    pbio_trajectory_command_t command = {
+        .time_start = end.time,
+        .position_start = end.position,
+        .speed_start = end.speed,
+        .position_end = *target,
+        .speed_target = speed == 0 ? ctl->settings.speed_default : speed,
+        .speed_max = ctl->settings.speed_max,
+        .acceleration = ctl->settings.acceleration,
+        .deceleration = ctl->settings.deceleration,
+        .profile = ctl->settings.profile,
+        .continue_running = on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE,
+    };
+
+    // The trajectory can be fully computed now, so errors are raised
+    // right away instead of when the segment starts.
+    pbio_control_segment_t *segment = pbio_control_queue_get(ctl, ctl->queue_size);
+    pbio_error_t err = pbio_trajectory_new_angle_command(&segment->trajectory, &command);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    segment->on_completion = on_completion;
+    ctl->queue_size++;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Queues a command to run to a given target position after the ongoing one.
+ *
+ * The new segment starts exactly when the trajectory before it ends, from its
+ * endpoint. If that endpoint has a nonzero speed because it used
+ * ::PBIO_CONTROL_ON_COMPLETION_CONTINUE, the motion continues without slowing
+ * down. The completion action of a segment is only used if no other segment
+ * follows it.
+ *
+ * If no position control is ongoing, this is the same as
+ * ::pbio_control_start_position_control.
+ *
+ * @param [in]  ctl            The control instance.
+ * @param [in]  time_now       The wall time (ticks).
+ * @param [in]  state          The current state of the system being controlled (control units).
+ * @param [in]  position       The target position to run to (application units).
+ * @param [in]  speed          The top speed on the way to the target (application units). The sign is ignored. If zero, default speed is used.
+ * @param [in]  on_completion  What to do when reaching the target position.
+ * @return                     ::PBIO_ERROR_BUSY if the queue is full, otherwise other error code.
+ */
+pbio_error_t pbio_control_queue_position_control(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion) {
+
+    if (!pbio_control_queue_must_wait(ctl, time_now)) {
+        return pbio_control_start_position_control(ctl, time_now, state, position, speed, on_completion);
+    }
+
+    // Convert target position to control units.
+    pbio_angle_t target;
+    pbio_control_settings_app_to_ctl_long(&ctl->settings, position, &target);
+
+    // Queue position control in control units.
+    return _pbio_control_queue_position_control(ctl, &target, pbio_control_settings_app_to_ctl(&ctl->settings, speed), on_completion);
+}
+
+/**
+ * Queues a command to run by a given distance after the ongoing one.
+ *
+ * The distance is relative to the endpoint of the last queued segment or the
+ * ongoing trajectory. See ::pbio_control_queue_position_control for details.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @param [in]  state           The current state of the system being controlled (control units).
+ * @param [in]  distance        The distance to run by (application units).
+ * @param [in]  speed           The top speed on the way to the target (application units). Negative speed flips the distance sign.
+ * @param [in]  on_completion   What to do when reaching the target position.
+ * @return                      ::PBIO_ERROR_BUSY if the queue is full, otherwise other error code.
+ */
+pbio_error_t pbio_control_queue_position_control_relative(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion) {
+
+    if (!pbio_control_queue_must_wait(ctl, time_now)) {
+        return pbio_control_start_position_control_relative(ctl, time_now, state, distance, speed, on_completion);
+    }
+
+    // Convert distance to control units.
+    pbio_angle_t increment;
+    pbio_control_settings_app_to_ctl_long(&ctl->settings, (speed < 0 ? -distance : distance), &increment);
+
+    // The target is relative to where the last trajectory ends.
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(pbio_control_get_last_trajectory(ctl), &end);
+    pbio_angle_t target;
+    pbio_angle_sum(&end.position, &increment, &target);
+
+    // Queue position control in control units.
+    return _pbio_control_queue_position_control(ctl, &target, pbio_control_settings_app_to_ctl(&ctl->settings, speed), on_completion);
+}
+
+/**
+ * Gets the trajectory that will be followed last, which is either the last
+ * queued segment or the ongoing trajectory.
+ *
+ * @param [in]  ctl             The control instance.
+ * @return                      The trajectory.
+ */
+pbio_trajectory_t *pbio_control_get_last_trajectory(pbio_control_t *ctl) {
+    if (ctl->queue_size == 0) {
+        return &ctl->trajectory;
+    }
+    return &pbio_control_queue_get(ctl, ctl->queue_size - 1)->trajectory;
+}
+
+/**
+ * Removes the last queued segment, such as when a command that queues
+ * segments in several controllers could not queue all of them.
+ *
+ * @param [in]  ctl             The control instance.
+ * @return                      ::PBIO_ERROR_INVALID_OP if nothing is queued, otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbio_control_queue_remove_last(pbio_control_t *ctl) {
+    if (ctl->queue_size == 0) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+    ctl->queue_size--;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Checks if no more segments can be queued.
+ *
+ * @param [in]  ctl             The control instance.
+ * @return                      True if the queue is full, false if not.
+ */
+bool pbio_control_queue_is_full(pbio_control_t *ctl) {
+    return ctl->queue_size == PBIO_CONFIG_CONTROL_QUEUE_SIZE;
+}
+
+#else // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+pbio_error_t pbio_control_queue_position_control(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+pbio_error_t pbio_control_queue_position_control_relative(pbio_control_t *ctl, uint32_t time_now, pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+bool pbio_control_queue_must_wait(pbio_control_t *ctl, uint32_t time_now) {
+    return false;
+}
+
+pbio_error_t pbio_control_queue_remove_last(pbio_control_t *ctl) {
+    return PBIO_ERROR_INVALID_OP;
+}
+
+pbio_trajectory_t *pbio_control_get_last_trajectory(pbio_control_t *ctl) {
+    return &ctl->trajectory;
+}
+
+bool pbio_control_queue_is_full(pbio_control_t *ctl) {
+    return true;
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 
 
 /**
@@ -701,5 +992,10 @@ bool pbio_control_is_stalled(pbio_control_t *ctl, uint32_t *stall_duration) {
  * @return                      True if the controller is done, false if not.
  */
 bool pbio_control_is_done(pbio_control_t *ctl) {
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    if (ctl->queue_size > 0) {
+        return false;
+    }
+    #endif
     return ctl->type == PBIO_CONTROL_NONE || ctl->on_target;
 }
@@ -7,6 +7,65 @@
 #include <pbio/control_settings.h>
 #include <pbio/int_math.h>
 
+// Control loop time in milliseconds.
+static uint32_t control_loop_time = PBIO_CONFIG_CONTROL_LOOP_TIME_MS;
+
+// Gains and the loop time are scaled by 1000 in every control loop iteration.
+static const pbio_int_math_reciprocal_t reciprocal_1000 = PBIO_INT_MATH_RECIPROCAL(1000, 10);
+
+/**
+ * Gets the reciprocal of a setting, refreshing it if the setting changed.
+ *
+ * @param [in] r              Reciprocal of the setting.
+ * @param [in] divisor        Current value of the setting.
+ * @return                    The up to date reciprocal.
+ */
+static const pbio_int_math_reciprocal_t *pbio_control_settings_get_reciprocal(pbio_int_math_reciprocal_t *r, int32_t divisor) {
+    if (r->divisor != divisor) {
+        pbio_int_math_reciprocal_init(r, divisor);
+    }
+    return r;
+}
+
+/**
+ * Gets the control loop time.
+ *
+ * @return                    Control loop time in milliseconds.
+ */
+uint32_t pbio_control_settings_get_loop_time(void) {
+    return control_loop_time;
+}
+
+/**
+ * Sets the control loop time.
+ *
+ * The motor models are discretized with a step of
+ * ::PBIO_CONFIG_CONTROL_LOOP_TIME_MS, so longer loop times must be a multiple
+ * of it. Then the observer runs several model steps per loop iteration.
+ * Shorter loop times down to ::PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS are
+ * allowed too. Then the observer makes a model for one loop time.
+ *
+ * Integrators and speed differentiators scale with the new loop time.
+ * Because the differentiator restarts, the numeric speed reads zero for
+ * one differentiator window after changing the loop time while motors run.
+ *
+ * @param [in] loop_time      Control loop time in milliseconds.
+ * @return                    ::PBIO_SUCCESS on success, or
+ *                            ::PBIO_ERROR_INVALID_ARG if the loop time is
+ *                            too short, too long, or a longer loop time is
+ *                            not a multiple of the model step.
+ */
+pbio_error_t pbio_control_settings_set_loop_time(uint32_t loop_time) {
+    if (loop_time < PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS || loop_time == 0 || loop_time > PBIO_CONTROL_LOOP_TIME_MAX_MS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (loop_time > PBIO_CONFIG_CONTROL_LOOP_TIME_MS && loop_time % PBIO_CONFIG_CONTROL_LOOP_TIME_MS != 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    control_loop_time = loop_time;
+    return PBIO_SUCCESS;
+}
+
 /**
  * Converts position-like control units to application-specific units.
  *
@@ -17,7 +76,8 @@
  * @return                    Signal in application units.
  */
 int32_t pbio_control_settings_ctl_to_app(pbio_control_settings_t *s, int32_t input) {
-    return input / s->ctl_steps_per_app_step;
+    return pbio_int_math_div_by_reciprocal(input,
+        pbio_control_settings_get_reciprocal(&s->ctl_steps_per_app_step_reciprocal, s->ctl_steps_per_app_step));
 }
 
 /**
@@ -92,25 +152,115 @@ int32_t pbio_control_settings_actuation_app_to_ctl(int32_t input) {
  * @return                   Torque in uNm.
  */
 int32_t pbio_control_settings_mul_by_gain(int32_t value, int32_t gain) {
-    return pbio_int_math_mult_then_div(gain, value, 1000);
+    return pbio_int_math_mult_then_div_by_reciprocal(gain, value, &reciprocal_1000);
 }
 
 /**
- * Divides a torque (uNm) by a control gain to get an angle (mdeg),
- * speed (mdeg/s) or angle integral (mdeg s), and accounts for scaling.
+ * Divides a torque (uNm) by a control gain and accounts for scaling.
  *
- * Only positive gains are allowed. If the gain is zero or less, this returns
- * zero.
+ * A scheduled gain changes nearly every tick, so building a reciprocal for
+ * it would cost more than dividing once. Only the configured gain is cached.
+ * Schedule factors go up to about 32 times, so a scheduled gain may exceed
+ * the 2**16 divisor limit of pbio_int_math_mult_then_div(). It is divided
+ * in 64 bits instead.
  *
  * @param [in] value         Input value (uNm).
- * @param [in] gain          Positive gain in uNm/deg, uNm/(deg/s), or uNm/(deg s).
- * @return                   Result in mdeg, mdeg/s, or mdeg s.
+ * @param [in] gain          Scheduled gain.
+ * @param [in] configured    Configured gain, without scheduling.
+ * @param [in] reciprocal    Cached reciprocal of the configured gain.
+ * @return                   Result in mdeg or mdeg s.
  */
-int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain) {
+static int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain, int32_t configured, pbio_int_math_reciprocal_t *reciprocal) {
     if (gain < 1) {
         return 0;
     }
-    return pbio_int_math_mult_then_div(value, 1000, gain);
+    if (gain != configured) {
+        return (int64_t)value * 1000 / gain;
+    }
+    return pbio_int_math_mult_then_div_by_reciprocal(value, 1000,
+        pbio_control_settings_get_reciprocal(reciprocal, gain));
+}
+
+/**
+ * Divides a torque (uNm) by the proportional position gain to get an
+ * angle (mdeg), and accounts for scaling.
+ *
+ * If the gain is zero or less, this returns zero.
+ *
+ * @param [in] s             Control settings used to cache the reciprocal.
+ * @param [in] value         Input value (uNm).
+ * @param [in] pid_kp        Scheduled proportional position gain.
+ * @return                   Result in mdeg.
+ */
+int32_t pbio_control_settings_div_by_kp(pbio_control_settings_t *s, int32_t value, int32_t pid_kp) {
+    return pbio_control_settings_div_by_gain(value, pid_kp, s->pid_kp, &s->pid_kp_reciprocal);
+}
+
+/**
+ * Divides a torque (uNm) by the integral position gain to get an angle
+ * integral (mdeg s), and accounts for scaling.
+ *
+ * If the gain is zero or less, this returns zero.
+ *
+ * @param [in] s             Control settings used to cache the reciprocal.
+ * @param [in] value         Input value (uNm).
+ * @param [in] pid_ki        Scheduled integral position gain.
+ * @return                   Result in mdeg s.
+ */
+int32_t pbio_control_settings_div_by_ki(pbio_control_settings_t *s, int32_t value, int32_t pid_ki) {
+    return pbio_control_settings_div_by_gain(value, pid_ki, s->pid_ki, &s->pid_ki_reciprocal);
+}
+
+/**
+ * Checks whether the PID gains are scaled depending on an operating
+ * condition.
+ *
+ * This can be used to skip estimating a condition that is not used.
+ *
+ * @param [in]  s             Control settings containing the schedules.
+ * @param [in]  input         Operating condition of the schedule.
+ * @return                    True if the schedule has any points, false if not.
+ */
+bool pbio_control_settings_gain_schedule_is_active(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input) {
+    return input < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM && s->gain_schedules[input].num_points > 0;
+}
+
+/**
+ * Gets the PID gains for the current operating condition.
+ *
+ * The configured gains are scaled by the factor of each gain schedule that
+ * is in use. Without any schedules, these are just the configured gains.
+ *
+ * @param [in]  s             Control settings containing the gains.
+ * @param [in]  speed         Reference speed (control units).
+ * @param [in]  load          Estimated load (uNm).
+ * @param [out] pid_kp        Scheduled position error feedback constant.
+ * @param [out] pid_ki        Scheduled accumulated error feedback constant.
+ * @param [out] pid_kd        Scheduled speed error feedback constant.
+ */
+void pbio_control_settings_get_scheduled_pid(pbio_control_settings_t *s, int32_t speed, int32_t load, int32_t *pid_kp, int32_t *pid_ki, int32_t *pid_kd) {
+
+    *pid_kp = s->pid_kp;
+    *pid_ki = s->pid_ki;
+    *pid_kd = s->pid_kd;
+
+    for (uint8_t i = 0; i < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM; i++) {
+        const pbio_control_settings_gain_schedule_t *schedule = &s->gain_schedules[i];
+        if (schedule->num_points == 0) {
+            continue;
+        }
+
+        // Schedules are defined in application units.
+        int32_t condition = i == PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED ?
+            pbio_control_settings_ctl_to_app(s, pbio_int_math_abs(speed)) :
+            pbio_control_settings_actuation_ctl_to_app(pbio_int_math_abs(load));
+
+        // Scale all gains by the per mille factor at this condition.
+        int32_t factor = pbio_int_math_interpolate(schedule->points, schedule->num_points, condition);
+        *pid_kp = pbio_int_math_mult_then_div_by_reciprocal(*pid_kp, factor, &reciprocal_1000);
+        *pid_ki = pbio_int_math_mult_then_div_by_reciprocal(*pid_ki, factor, &reciprocal_1000);
+        *pid_kd = pbio_int_math_mult_then_div_by_reciprocal(*pid_kd, factor, &reciprocal_1000);
+    }
 }
 
 /**
@@ -120,7 +270,7 @@ int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain) {
  * @return                    Input scaled by loop time in seconds.
  */
 int32_t pbio_control_settings_mul_by_loop_time(int32_t input) {
-    return input / (1000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    return pbio_int_math_mult_then_div_by_reciprocal(input, control_loop_time, &reciprocal_1000);
 }
 
 /**
@@ -204,6 +354,61 @@ pbio_error_t pbio_control_settings_set_pid(pbio_control_settings_t *s, int32_t p
     return PBIO_SUCCESS;
 }
 
+/**
+ * Gets a gain schedule.
+ *
+ * @param [in]  s             Control settings structure from which to read.
+ * @param [in]  input         Operating condition of the schedule.
+ * @param [out] points        Points of the schedule, with room for
+ *                            ::PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX points.
+ * @return                    Number of points in the schedule.
+ */
+uint8_t pbio_control_settings_get_gain_schedule(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input, pbio_int_math_point_t *points) {
+    if (input >= PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM) {
+        return 0;
+    }
+    const pbio_control_settings_gain_schedule_t *schedule = &s->gain_schedules[input];
+    for (uint8_t i = 0; i < schedule->num_points; i++) {
+        points[i] = schedule->points[i];
+    }
+    return schedule->num_points;
+}
+
+/**
+ * Sets a gain schedule that scales the PID gains depending on an operating
+ * condition.
+ *
+ * Each point maps the absolute value of the condition to a factor in per
+ * mille, so that a factor of 1000 gives the gains set with
+ * pbio_control_settings_set_pid(). Give no points to stop scheduling.
+ *
+ * @param [in] s              Control settings structure to write to.
+ * @param [in] input          Operating condition of the schedule.
+ * @param [in] points         Points sorted by condition, in application units.
+ * @param [in] num_points     Number of points.
+ * @return                    ::PBIO_SUCCESS on success
+ *                            ::PBIO_ERROR_INVALID_ARG if there are too many
+ *                            points, if they are not sorted, or if any value
+ *                            is negative.
+ */
+pbio_error_t pbio_control_settings_set_gain_schedule(pbio_control_settings_t *s, pbio_control_settings_gain_schedule_input_t input, const pbio_int_math_point_t *points, uint8_t num_points) {
+    if (input >= PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM || num_points > PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    for (uint8_t i = 0; i < num_points; i++) {
+        if (points[i].x < 0 || points[i].y < 0 || (i > 0 && points[i].x <= points[i - 1].x)) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    pbio_control_settings_gain_schedule_t *schedule = &s->gain_schedules[input];
+    for (uint8_t i = 0; i < num_points; i++) {
+        schedule->points[i] = points[i];
+    }
+    schedule->num_points = num_points;
+    return PBIO_SUCCESS;
+}
+
 /**
  * Gets the tolerances associated with reaching a position target.
  * @param [in]  s           Control settings structure from which to read.
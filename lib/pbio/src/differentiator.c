@@ -11,6 +11,22 @@
 #include <pbio/int_math.h>
 #include <pbio/util.h>
 
+_Static_assert(PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS >= PBIO_CONTROL_LOOP_TIME_MAX_MS,
+    "differentiator window must fit at least one sample at the longest loop time");
+
+// Scale of the alpha-beta filter gains.
+#define ALPHA_BETA_ONE (1 << 16)
+
+// Angle between encoder edges. This is one degree for all supported motors.
+#define EDGE_ANGLE_MDEG (1000)
+
+// Time since the last edge is not counted beyond this (us). Any edge after
+// this long gives a speed that rounds to zero.
+#define EDGE_ELAPSED_MAX (1 << 30)
+
+// Smallest time between edges used to calculate speed (us).
+#define EDGE_INTERVAL_MIN (100)
+
 /**
  * Updates the angle buffer and calculates the average speed across buffer.
  *
@@ -18,27 +34,209 @@
  * @param [in]  angle          New angle sample to add to the buffer.
  * @return                     Average speed across position buffer.
  */
-int32_t pbio_differentiator_get_speed(pbio_differentiator_t *dif, const pbio_angle_t *angle) {
+static int32_t pbio_differentiator_get_speed_window(pbio_differentiator_t *dif, const pbio_angle_t *angle) {
 
     // Difference between current angle and oldest in buffer.
     int32_t delta = pbio_angle_diff_mdeg(angle, &dif->history[dif->index]);
 
     // Override oldest sample with new value.
     dif->history[dif->index] = *angle;
-    dif->index = (dif->index + 1) % PBIO_ARRAY_SIZE(dif->history);
+    dif->index = (dif->index + 1) % dif->num_samples;
 
     // Return average speed.
-    return delta * (1000 / PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS);
+    return pbio_int_math_mult_then_div(delta, 1000, dif->num_samples * dif->loop_time);
+}
+
+/**
+ * Updates the alpha-beta filter and returns its speed estimate.
+ *
+ * The filter predicts the angle from the estimated speed, and then corrects
+ * both by a fraction of the prediction error.
+ *
+ * @param [in]  dif            The differentiator instance.
+ * @param [in]  angle          New angle sample.
+ * @return                     Estimated speed.
+ */
+static int32_t pbio_differentiator_get_speed_alpha_beta(pbio_differentiator_t *dif, const pbio_angle_t *angle) {
+
+    // Predict the angle at this sample.
+    pbio_angle_add_mdeg(&dif->angle, dif->speed * dif->loop_time / 1000);
+
+    // Correct the prediction.
+    int32_t residual = pbio_angle_diff_mdeg(angle, &dif->angle);
+    pbio_angle_add_mdeg(&dif->angle, (int64_t)dif->alpha * residual / ALPHA_BETA_ONE);
+    dif->speed += (int64_t)dif->beta * residual * 1000 / (ALPHA_BETA_ONE * dif->loop_time);
+
+    return dif->speed;
+}
+
+/**
+ * Updates the speed measured from the time between encoder edges.
+ *
+ * At low speeds, there are only a few edges in the window of the filters
+ * above, so their estimate jumps by one degree per window each time an edge
+ * is counted or not. Measuring the time between edges instead gives the
+ * speed as precisely as the clock that timestamps them.
+ *
+ * While no new edge arrives, the motor can't be faster than one edge in the
+ * time since the last one, so the speed decays when the motor stops.
+ *
+ * An edge in the other direction than the previous one, such as when the
+ * motor reverses or the encoder jitters between two edges at standstill,
+ * gives no speed, so timing starts over from that edge.
+ *
+ * @param [in]  dif            The differentiator instance.
+ * @param [in]  angle          New angle sample.
+ * @param [in]  edge_age       Time from the most recent edge to this sample (us).
+ * @return                     Speed measured from edge times.
+ */
+static int32_t pbio_differentiator_get_speed_edges(pbio_differentiator_t *dif, const pbio_angle_t *angle, uint32_t edge_age) {
+
+    uint32_t loop_time_us = dif->loop_time * 1000;
+
+    int32_t delta = pbio_angle_diff_mdeg(angle, &dif->edge_angle);
+    if (delta == 0) {
+        dif->edge_elapsed = pbio_int_math_min(dif->edge_elapsed + loop_time_us, EDGE_ELAPSED_MAX);
+        int32_t speed_max = (int64_t)EDGE_ANGLE_MDEG * 1000000 / dif->edge_elapsed;
+        dif->edge_speed = speed_max > 0 ? pbio_int_math_clamp(dif->edge_speed, speed_max) : 0;
+        return dif->edge_speed;
+    }
+
+    // The angle changed, so the last edge came after the previous sample.
+    if (edge_age > loop_time_us) {
+        edge_age = loop_time_us;
+    }
+
+    int8_t direction = delta > 0 ? 1 : -1;
+    if (direction != dif->edge_direction) {
+        dif->edge_direction = direction;
+        dif->edge_speed = 0;
+        dif->edge_angle = *angle;
+        dif->edge_elapsed = edge_age;
+        return 0;
+    }
+
+    // Time between the previous edge and this one, bounded by the resolution
+    // of the slowest clocks that timestamp edges. After a standstill, this is
+    // far more than pbio_int_math_mult_then_div() can divide by.
+    int32_t interval = pbio_int_math_max(dif->edge_elapsed + loop_time_us - edge_age, EDGE_INTERVAL_MIN);
+
+    dif->edge_speed = (int64_t)delta * 1000000 / interval;
+    dif->edge_angle = *angle;
+    dif->edge_elapsed = edge_age;
+    return dif->edge_speed;
+}
+
+/**
+ * Gets the speed estimate for a new angle sample.
+ *
+ * If the counter records when the angle last changed, the speed is measured
+ * from the time between edges whenever there is less than one edge per loop
+ * time. Otherwise, the selected filter is used.
+ *
+ * @param [in]  dif            The differentiator instance.
+ * @param [in]  angle          New angle sample.
+ * @param [in]  edge_age       Time since the angle last changed (us), or
+ *                             ::PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN.
+ * @return                     Estimated speed.
+ */
+int32_t pbio_differentiator_get_speed(pbio_differentiator_t *dif, const pbio_angle_t *angle, uint32_t edge_age) {
+
+    // Start over if the loop time or the filter changed.
+    if (dif->loop_time != pbio_control_settings_get_loop_time()) {
+        pbio_differentiator_reset(dif, angle);
+    }
+
+    // The filters keep running so they are up to date when edges get dense.
+    int32_t speed;
+    if (dif->filter == PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA) {
+        speed = pbio_differentiator_get_speed_alpha_beta(dif, angle);
+    } else {
+        speed = pbio_differentiator_get_speed_window(dif, angle);
+    }
+
+    if (edge_age == PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN) {
+        return speed;
+    }
+
+    int32_t edge_speed = pbio_differentiator_get_speed_edges(dif, angle, edge_age);
+    if (pbio_int_math_abs(edge_speed) < EDGE_ANGLE_MDEG * 1000 / dif->loop_time) {
+        return edge_speed;
+    }
+    return speed;
 }
 
 /**
- * Resets the position angle buffer in order to set speed to zero.
+ * Resets the differentiator state in order to set speed to zero.
  *
  * @param [in]  dif            The differentiator instance.
  * @param [in]  angle          New angle sample to add to the buffer.
  */
 void pbio_differentiator_reset(pbio_differentiator_t *dif, const pbio_angle_t *angle) {
-    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(dif->history); i++) {
+
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+    dif->loop_time = loop_time;
+
+    // Use the configured window if no filter was set.
+    if (dif->time_ms == 0) {
+        dif->filter = PBIO_DIFFERENTIATOR_FILTER_WINDOW;
+        dif->time_ms = PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS;
+    }
+
+    // Use as much of the buffer as fits in the window at this loop time. At
+    // loop times shorter than the model step, the window gets shorter.
+    dif->num_samples = pbio_int_math_bind(dif->time_ms / loop_time, 1, PBIO_ARRAY_SIZE(dif->history));
+    dif->index = 0;
+    for (uint8_t i = 0; i < dif->num_samples; i++) {
         dif->history[i] = *angle;
     }
+
+    // Critically damped gains for the response time at this loop time.
+    int32_t theta = dif->time_ms * ALPHA_BETA_ONE / (dif->time_ms + loop_time);
+    dif->alpha = ALPHA_BETA_ONE - (int64_t)theta * theta / ALPHA_BETA_ONE;
+    dif->beta = (int64_t)(ALPHA_BETA_ONE - theta) * (ALPHA_BETA_ONE - theta) / ALPHA_BETA_ONE;
+    dif->angle = *angle;
+    dif->speed = 0;
+
+    // Start as if the last edge was long ago.
+    dif->edge_angle = *angle;
+    dif->edge_elapsed = EDGE_ELAPSED_MAX;
+    dif->edge_speed = 0;
+    dif->edge_direction = 0;
+}
+
+/**
+ * Selects the method used to estimate speed.
+ *
+ * The estimate restarts from zero on the next sample.
+ *
+ * @param [in]  dif            The differentiator instance.
+ * @param [in]  filter         The estimation method.
+ * @param [in]  time_ms        Window length of the window filter, or the
+ *                             response time of the alpha-beta filter (ms).
+ * @return                     ::PBIO_SUCCESS on success, or
+ *                             ::PBIO_ERROR_INVALID_ARG if the window does not
+ *                             fit in the buffer or the time is out of range.
+ */
+pbio_error_t pbio_differentiator_set_filter(pbio_differentiator_t *dif, pbio_differentiator_filter_t filter, uint32_t time_ms) {
+
+    switch (filter) {
+        case PBIO_DIFFERENTIATOR_FILTER_WINDOW:
+            if (time_ms < PBIO_CONFIG_CONTROL_LOOP_TIME_MS || time_ms > PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+            break;
+        case PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA:
+            if (time_ms < 1 || time_ms > 1000) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+            break;
+        default:
+            return PBIO_ERROR_INVALID_ARG;
+    }
+
+    dif->filter = filter;
+    dif->time_ms = time_ms;
+    dif->loop_time = 0;
+    return PBIO_SUCCESS;
 }
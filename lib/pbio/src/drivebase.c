@@ -62,6 +62,9 @@ static void drivebase_adopt_settings(pbio_control_settings_t *s_distance, pbio_c
     s_distance->acceleration = pbio_int_math_min(s_left->acceleration, s_right->acceleration) * 3 / 4;
     s_distance->deceleration = pbio_int_math_min(s_left->deceleration, s_right->deceleration) * 3 / 4;
 
+    // Use smooth ramps if either motor uses them.
+    s_distance->profile = s_left->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE ? s_left->profile : s_right->profile;
+
     // Use minimum PID of both motors, to avoid overly aggressive control if
     // one of the two motors has much higher PID values. For proportional
     // control, take a much lower gain. Drivebases don't need it, and it makes
@@ -80,6 +83,11 @@ static void drivebase_adopt_settings(pbio_control_settings_t *s_distance, pbio_c
     // The default speed is 40% of the maximum speed.
     s_distance->speed_default = s_distance->speed_max * 10 / 25;
 
+    // Motor gain schedules are in motor units, so they don't apply here.
+    for (uint8_t i = 0; i < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM; i++) {
+        s_distance->gain_schedules[i].num_points = 0;
+    }
+
     // By default, heading control is the nearly same as distance control.
     *s_heading = *s_distance;
 
@@ -112,11 +120,20 @@ static pbio_error_t pbio_drivebase_get_state_control(pbio_drivebase_t *db, pbio_
         return err;
     }
 
+    // The servos estimate the load only for their own gain schedules, so
+    // estimate it here if the drive base schedules its gains by load.
+    if (pbio_control_settings_gain_schedule_is_active(&db->control_distance.settings, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD) ||
+        pbio_control_settings_gain_schedule_is_active(&db->control_heading.settings, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD)) {
+        state_left.load_estimate = pbio_observer_get_feedback_torque(&db->left->observer, &state_left.position);
+        state_right.load_estimate = pbio_observer_get_feedback_torque(&db->right->observer, &state_right.position);
+    }
+
     // Take sum to get distance state
     pbio_angle_avg(&state_left.position, &state_right.position, &state_distance->position);
     pbio_angle_avg(&state_left.position_estimate, &state_right.position_estimate, &state_distance->position_estimate);
     state_distance->speed_estimate = (state_left.speed_estimate + state_right.speed_estimate) / 2;
     state_distance->speed = (state_left.speed + state_right.speed) / 2;
+    state_distance->load_estimate = (state_left.load_estimate + state_right.load_estimate) / 2;
 
     // Take difference to get heading state, which is implemented as
     // (left - right) / 2 = (left + right) / 2 - right = avg - right.
@@ -124,6 +141,7 @@ static pbio_error_t pbio_drivebase_get_state_control(pbio_drivebase_t *db, pbio_
     pbio_angle_diff(&state_distance->position_estimate, &state_right.position_estimate, &state_heading->position_estimate);
     state_heading->speed_estimate = state_distance->speed_estimate - state_right.speed_estimate;
     state_heading->speed = state_distance->speed - state_right.speed;
+    state_heading->load_estimate = state_distance->load_estimate - state_right.load_estimate;
 
     return PBIO_SUCCESS;
 }
@@ -412,6 +430,34 @@ void pbio_drivebase_update_all(void) {
     }
 }
 
+/**
+ * Stretches the shortest of two trajectories to match the duration of the
+ * longest, so that distance and heading control complete at the same time.
+ *
+ * @param [in]  distance        The distance trajectory.
+ * @param [in]  heading         The heading trajectory.
+ */
+static void pbio_drivebase_synchronize_trajectories(pbio_trajectory_t *distance, pbio_trajectory_t *heading) {
+
+    // First, find out which controller takes the lead
+    pbio_trajectory_t *leader;
+    pbio_trajectory_t *follower;
+
+    if (pbio_trajectory_get_duration(distance) > pbio_trajectory_get_duration(heading)) {
+        // Distance control takes the longest, so it will take the lead
+        leader = distance;
+        follower = heading;
+    } else {
+        // Heading control takes the longest, so it will take the lead
+        leader = heading;
+        follower = distance;
+    }
+
+    // Revise follower trajectory so it takes as long as the leader, achieved
+    // by picking a lower speed and accelerations that makes the times match.
+    pbio_trajectory_stretch(follower, leader);
+}
+
 /**
  * Starts the drivebase controllers to run by a given distance and angle.
  *
@@ -458,25 +504,7 @@ static pbio_error_t pbio_drivebase_drive_relative(pbio_drivebase_t *db, int32_t
 
     // At this point, the two trajectories may have different durations, so they won't complete at the same time
     // To account for this, we re-compute the shortest trajectory to have the same duration as the longest.
-
-    // First, find out which controller takes the lead
-    pbio_control_t *control_leader;
-    pbio_control_t *control_follower;
-
-    if (pbio_trajectory_get_duration(&db->control_distance.trajectory) >
-        pbio_trajectory_get_duration(&db->control_heading.trajectory)) {
-        // Distance control takes the longest, so it will take the lead
-        control_leader = &db->control_distance;
-        control_follower = &db->control_heading;
-    } else {
-        // Heading control takes the longest, so it will take the lead
-        control_leader = &db->control_heading;
-        control_follower = &db->control_distance;
-    }
-
-    // Revise follower trajectory so it takes as long as the leader, achieved
-    // by picking a lower speed and accelerations that makes the times match.
-    pbio_trajectory_stretch(&control_follower->trajectory, &control_leader->trajectory);
+    pbio_drivebase_synchronize_trajectories(&db->control_distance.trajectory, &db->control_heading.trajectory);
 
     return PBIO_SUCCESS;
 }
@@ -519,6 +547,106 @@ pbio_error_t pbio_drivebase_drive_curve(pbio_drivebase_t *db, int32_t radius, in
     return pbio_drivebase_drive_relative(db, arc_length, 0, arc_angle, 0, on_completion);
 }
 
+/**
+ * Queues drivebase commands to run by a given distance and angle after the
+ * ongoing ones complete.
+ *
+ * If no command is ongoing, this is the same as starting it right away.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  distance        The distance to run by in mm.
+ * @param [in]  angle           The angle to turn in deg.
+ * @param [in]  on_completion   What to do at the target if no other command is queued after it.
+ * @return                      ::PBIO_ERROR_BUSY if the queue is full, otherwise other error code.
+ */
+static pbio_error_t pbio_drivebase_queue_relative(pbio_drivebase_t *db, int32_t distance, int32_t angle, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_drivebase_update_loop_is_running(db)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Get current time
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    // Both controllers run in sync, so segments are queued only if both
+    // are still busy. Otherwise just start the new command now.
+    if (!pbio_control_queue_must_wait(&db->control_distance, time_now) ||
+        !pbio_control_queue_must_wait(&db->control_heading, time_now)) {
+        return pbio_drivebase_drive_relative(db, distance, 0, angle, 0, on_completion);
+    }
+
+    // Queue in both controllers or not at all.
+    if (pbio_control_queue_is_full(&db->control_distance) || pbio_control_queue_is_full(&db->control_heading)) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    // Get drive base state
+    pbio_control_state_t state_distance;
+    pbio_control_state_t state_heading;
+    pbio_error_t err = pbio_drivebase_get_state_control(db, &state_distance, &state_heading);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Queue segment for controller that controls the average angle of both motors.
+    err = pbio_control_queue_position_control_relative(&db->control_distance, time_now, &state_distance, distance, 0, on_completion);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Queue segment for controller that controls half the difference between
+    // both angles. If that fails, drop the distance segment as well so the
+    // controllers stay in sync.
+    err = pbio_control_queue_position_control_relative(&db->control_heading, time_now, &state_heading, angle, 0, on_completion);
+    if (err != PBIO_SUCCESS) {
+        pbio_control_queue_remove_last(&db->control_distance);
+        return err;
+    }
+
+    // Both segments start at the same time, so make them end together too.
+    pbio_drivebase_synchronize_trajectories(pbio_control_get_last_trajectory(&db->control_distance), pbio_control_get_last_trajectory(&db->control_heading));
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Queues the drivebase to run by a given distance after the ongoing command.
+ *
+ * This will use the default speed.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  distance        The distance to run by in mm.
+ * @param [in]  on_completion   What to do at the target if no other command is queued after it.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_drivebase_queue_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion) {
+    return pbio_drivebase_queue_relative(db, distance, 0, on_completion);
+}
+
+/**
+ * Queues the drivebase to run by an arc of given radius and angle after the
+ * ongoing command.
+ *
+ * This will use the default speed.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  radius          Radius of the arc in mm.
+ * @param [in]  angle           Angle in degrees.
+ * @param [in]  on_completion   What to do at the target if no other command is queued after it.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_drivebase_queue_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion) {
+
+    // The angle is signed by the radius so we can go both ways.
+    int32_t arc_angle = radius < 0 ? -angle : angle;
+
+    // Arc length is computed accordingly.
+    int32_t arc_length = (10 * pbio_int_math_abs(angle) * radius) / 573;
+
+    return pbio_drivebase_queue_relative(db, arc_length, arc_angle, on_completion);
+}
+
 /**
  * Starts the drivebase controllers to run for a given duration.
  *
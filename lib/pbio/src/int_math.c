@@ -119,7 +119,9 @@ int32_t pbio_int_math_clamp(int32_t value, int32_t abs_max) {
 /**
  * Gets the square root.
  *
- * If @p n <= 0, it returns 0.
+ * If @p n <= 0, it returns 0. The result is rounded down.
+ *
+ * This computes one bit of the result at a time, so it needs no division.
  *
  * @param [in]  n       The input value
  * @return              The square root.
@@ -128,26 +130,28 @@ int32_t pbio_int_math_sqrt(int32_t n) {
     if (n <= 0) {
         return 0;
     }
-    int32_t x0 = n;
-    int32_t x1 = x0;
 
-    while (true) {
-        x1 = (x0 + n / x0) / 2;
-        if (x1 == x0 || x1 == x0 + 1) {
-            return x0;
+    uint32_t remainder = n;
+    uint32_t root = 0;
+
+    // Start at the highest power of four that does not exceed the input.
+    uint32_t bit = 1u << 30;
+    while (bit > remainder) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (remainder >= root + bit) {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
         }
-        x0 = x1;
+        bit >>= 2;
     }
+    return root;
 }
 
-/**
- * Points on a curve for linear interpolation.
- */
-typedef struct {
-    int16_t x;
-    int16_t y;
-} point_t;
-
 /**
  * Sample points along the curve y = atan(x / 1024) * 8.
  *
@@ -157,7 +161,7 @@ typedef struct {
  * x = Ratios b / a, upscaled by 1024.
  * y = Matching atan(b / b) output, upscaled by 8 * 180 / pi (eighth of a degree).
  */
-static const point_t atan_points[] = {
+static const pbio_int_math_point_t atan_points[] = {
     { .x = 0, .y = 0 },
     { .x = 409, .y = 178 },
     { .x = 972, .y = 348 },
@@ -182,7 +186,7 @@ static const point_t atan_points[] = {
  * @param [in]   x       Value for which to estimate y = f(x)
  * @return               Estimated value for y = f(x)
  */
-static int32_t pbio_int_math_interpolate(const point_t *points, size_t len, int32_t x) {
+int32_t pbio_int_math_interpolate(const pbio_int_math_point_t *points, size_t len, int32_t x) {
 
     // If x is below the minimum x, return the minimum y.
     if (x < points[0].x) {
@@ -191,11 +195,11 @@ static int32_t pbio_int_math_interpolate(const point_t *points, size_t len, int3
 
     // Find nearest match and interpolate.
     for (size_t i = 0; i < len - 1; i++) {
-        const point_t *p0 = &points[i];
-        const point_t *p1 = &points[i + 1];
+        const pbio_int_math_point_t *p0 = &points[i];
+        const pbio_int_math_point_t *p1 = &points[i + 1];
 
         if (x < p1->x) {
-            return p0->y + (x - p0->x) * (p1->y - p0->y) / (p1->x - p0->x);
+            return p0->y + (int64_t)(x - p0->x) * (p1->y - p0->y) / (p1->x - p0->x);
         }
     }
 
@@ -291,3 +295,97 @@ int32_t pbio_int_math_mult_then_div(int32_t a, int32_t b, int32_t c) {
     assert(result == (int64_t)a * (int64_t)b / (int64_t)c);
     return result;
 }
+
+/**
+ * Initializes the reciprocal of a divisor.
+ *
+ * This uses a division, so it should be done once, for example when a
+ * setting changes, and not in every control loop iteration.
+ *
+ * @param [out] r        The reciprocal.
+ * @param [in]  divisor  Positive divisor.
+ */
+void pbio_int_math_reciprocal_init(pbio_int_math_reciprocal_t *r, int32_t divisor) {
+    assert(divisor > 0);
+
+    uint8_t shift = 0;
+    while (((int64_t)1 << shift) < divisor) {
+        shift++;
+    }
+
+    r->divisor = divisor;
+    r->multiplier = ((uint64_t)1 << (32 + shift)) / divisor + 1;
+    r->shift = shift;
+}
+
+/**
+ * Divides an unsigned number by a precomputed reciprocal.
+ *
+ * This is exact for all inputs. See Granlund and Montgomery, "Division by
+ * Invariant Integers using Multiplication", 1994.
+ *
+ * @param [in]  n        Any unsigned number.
+ * @param [in]  r        The reciprocal.
+ * @return               The result of n / divisor, rounded down.
+ */
+static uint32_t pbio_int_math_udiv_by_reciprocal(uint32_t n, const pbio_int_math_reciprocal_t *r) {
+    // Get n * multiplier / 2**32. The multiplier has up to 33 bits, so
+    // multiply by the low and high word separately to avoid overflow.
+    uint64_t product = (((uint64_t)n * (uint32_t)r->multiplier) >> 32) + (uint64_t)n * (uint32_t)(r->multiplier >> 32);
+    return product >> r->shift;
+}
+
+/**
+ * Divides a number by a precomputed reciprocal.
+ *
+ * The result is the same as @p a / divisor, so it is rounded towards zero.
+ *
+ * @param [in]  a        Positive or negative number.
+ * @param [in]  r        The reciprocal.
+ * @return               The result of a / divisor.
+ */
+int32_t pbio_int_math_div_by_reciprocal(int32_t a, const pbio_int_math_reciprocal_t *r) {
+    if (a < 0) {
+        return (int32_t)(0u - pbio_int_math_udiv_by_reciprocal(0u - (uint32_t)a, r));
+    }
+    return pbio_int_math_udiv_by_reciprocal(a, r);
+}
+
+/**
+ * Multiplies two numbers and scales down the result by a precomputed
+ * reciprocal.
+ *
+ * The result is the same as pbio_int_math_mult_then_div() with the same
+ * limits, but without division.
+ *
+ * @param [in]  a        Positive or negative number.
+ * @param [in]  b        Positive or negative number.
+ * @param [in]  r        Reciprocal of a divisor that does not exceed 2**16.
+ * @return               The result of a * b / divisor.
+ */
+int32_t pbio_int_math_mult_then_div_by_reciprocal(int32_t a, int32_t b, const pbio_int_math_reciprocal_t *r) {
+
+    // Get long product.
+    uint64_t x = (uint64_t)(a < 0 ? -a : a) * (uint64_t)(b < 0 ? -b : b);
+
+    assert(x < ((int64_t)1) << 47);
+    assert(r->divisor <= (1 << 16));
+
+    // Divide in two base-65536 digits like pbio_int_math_mult_then_div.
+    uint32_t d1 = x >> 16;
+    uint32_t d0 = x & 0xffffu;
+
+    uint32_t y1 = pbio_int_math_udiv_by_reciprocal(d1, r);
+    uint32_t r1 = d1 - y1 * r->divisor;
+    uint32_t y0 = pbio_int_math_udiv_by_reciprocal(r1 << 16 | d0, r);
+
+    // Return a quotient formed from the two quotient digits, signed by inputs.
+    int32_t result = (int32_t)(y1 << 16 | y0);
+    if ((a < 0) != (b < 0)) {
+        result = -result;
+    }
+
+    // Assert result is correct and return.
+    assert(result == (int64_t)a * (int64_t)b / r->divisor);
+    return result;
+}
@@ -151,15 +151,16 @@ void pbio_position_integrator_reset(pbio_position_integrator_t *itg, pbio_contro
 
 }
 
-int32_t pbio_position_integrator_update(pbio_position_integrator_t *itg, int32_t position_error, int32_t position_remaining) {
+int32_t pbio_position_integrator_update(pbio_position_integrator_t *itg, int32_t position_error, int32_t position_remaining, int32_t pid_kp, int32_t pid_ki) {
 
     // Specify in which region integral control should be active. This is
     // at least the error that would still lead to maximum  proportional
     // control, with a factor of 2 so we begin integrating a bit sooner.
-    int32_t integral_range = pbio_control_settings_div_by_gain(itg->settings->actuation_max, itg->settings->pid_kp) * 2;
+    // The gains are the scheduled ones, so this matches the actual control.
+    int32_t integral_range = pbio_control_settings_div_by_kp(itg->settings, itg->settings->actuation_max, pid_kp) * 2;
 
     // Get integral value that would lead to maximum actuation.
-    int32_t integral_max = pbio_control_settings_div_by_gain(itg->settings->actuation_max, itg->settings->pid_ki);
+    int32_t integral_max = pbio_control_settings_div_by_ki(itg->settings, itg->settings->actuation_max, pid_ki);
 
     // Previous error will be multiplied by time delta and then added to integral (unless we limit growth)
     int32_t cerr = itg->count_err_prev;
@@ -199,10 +200,10 @@ int32_t pbio_position_integrator_update(pbio_position_integrator_t *itg, int32_t
     return itg->count_err_integral;
 }
 
-bool pbio_position_integrator_stalled(pbio_position_integrator_t *itg, uint32_t time_now, int32_t speed_now, int32_t speed_ref) {
+bool pbio_position_integrator_stalled(pbio_position_integrator_t *itg, uint32_t time_now, int32_t speed_now, int32_t speed_ref, int32_t pid_ki) {
 
     // Get integral value that would lead to maximum actuation.
-    int32_t integral_max = pbio_control_settings_div_by_gain(itg->settings->actuation_max, itg->settings->pid_ki);
+    int32_t integral_max = pbio_control_settings_div_by_ki(itg->settings, itg->settings->actuation_max, pid_ki);
 
     // Whether the integrator is saturated.
     bool saturated = integral_max != 0 && pbio_int_math_abs(itg->count_err_integral) >= integral_max;
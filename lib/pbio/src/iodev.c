@@ -3,10 +3,18 @@
 
 #include <assert.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "pbdrv/ioport.h"
+#include "pbio/config.h"
 #include "pbio/error.h"
 #include "pbio/port.h"
+#include "pbio/util.h"
+
+#if PBIO_CONFIG_IODEV_HISTORY_SIZE
+_Static_assert(PBIO_CONFIG_IODEV_HISTORY_SIZE <= UINT8_MAX,
+    "history indexes must fit in uint8_t");
+#endif
 
 /**
  * Gets the size of a data type.
@@ -183,3 +191,174 @@ void pbio_iodev_write_cancel(pbio_iodev_t *iodev) {
 
     iodev->ops->write_cancel(iodev);
 }
+
+/**
+ * Sets a combination of modes that the I/O device streams at the same time.
+ *
+ * After this completes, the data of each of the modes is available through
+ * ::pbio_iodev_get_mode_data() as it is received, so no mode switch is needed
+ * to read any of them. Setting a single mode ends the combination.
+ *
+ * @param [in]  iodev       The I/O device
+ * @param [in]  modes       The modes to combine, which become available in this order
+ * @param [in]  num_modes   The number of modes
+ * @return                  ::PBIO_SUCCESS on success
+ *                          ::PBIO_ERROR_INVALID_ARG if the modes can't be combined
+ *                          ::PBIO_ERROR_AGAIN if the device is busy with something else
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if the device does not support mode combinations
+ */
+pbio_error_t pbio_iodev_set_combi_mode_begin(pbio_iodev_t *iodev, const uint8_t *modes, uint8_t num_modes) {
+    if (!iodev->ops->set_combi_mode_begin) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    if (num_modes < 2 || num_modes > PBIO_IODEV_MAX_COMBI_MODES) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Modes can only be combined if the device says so.
+    for (uint8_t i = 0; i < num_modes; i++) {
+        if (modes[i] >= iodev->info->num_modes || !(iodev->info->mode_combos & (1 << modes[i]))) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    return iodev->ops->set_combi_mode_begin(iodev, modes, num_modes);
+}
+
+pbio_error_t pbio_iodev_set_combi_mode_end(pbio_iodev_t *iodev) {
+    if (!iodev->ops->set_combi_mode_end) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    return iodev->ops->set_combi_mode_end(iodev);
+}
+
+void pbio_iodev_set_combi_mode_cancel(pbio_iodev_t *iodev) {
+    if (!iodev->ops->set_combi_mode_cancel) {
+        return;
+    }
+
+    iodev->ops->set_combi_mode_cancel(iodev);
+}
+
+/**
+ * Gets the most recent raw data of one mode of an I/O device.
+ *
+ * Unlike ::pbio_iodev_get_data(), this works for any mode that is currently
+ * streamed by the device, including all modes of a mode combination.
+ *
+ * @param [in]  iodev       The I/O device
+ * @param [in]  mode        The mode
+ * @param [out] data        Pointer to hold array of data values
+ * @param [out] time        Time (ms) at which the data was received
+ * @return                  ::PBIO_SUCCESS on success
+ *                          ::PBIO_ERROR_INVALID_ARG if the mode is not valid
+ *                          ::PBIO_ERROR_NO_DEV if the port does not have a device attached
+ *                          ::PBIO_ERROR_AGAIN if no data was received for this mode since it was last set
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if data is not kept per mode
+ *
+ * The binary format and size of *data* is determined by ::pbio_iodev_get_data_format().
+ */
+pbio_error_t pbio_iodev_get_mode_data(pbio_iodev_t *iodev, uint8_t mode, uint8_t **data, uint32_t *time) {
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    if (iodev->info->type_id == PBIO_IODEV_TYPE_ID_NONE) {
+        return PBIO_ERROR_NO_DEV;
+    }
+    if (mode >= iodev->info->num_modes) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    pbio_iodev_mode_data_t *mode_data = &iodev->mode_data[mode];
+    if (!mode_data->valid) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    *data = mode_data->bin_data;
+    *time = mode_data->time;
+
+    return PBIO_SUCCESS;
+    #else
+    return PBIO_ERROR_NOT_SUPPORTED;
+    #endif
+}
+
+/**
+ * Adds a data sample to the history of an I/O device.
+ *
+ * If the history is full, the oldest sample is dropped.
+ *
+ * @param [in]  iodev       The I/O device
+ * @param [in]  mode        The mode of the data
+ * @param [in]  data        The binary data
+ * @param [in]  size        Size of *data* in bytes
+ * @param [in]  time        Time (ms) at which the data was received
+ */
+void pbio_iodev_add_sample(pbio_iodev_t *iodev, uint8_t mode, const uint8_t *data, uint8_t size, uint32_t time) {
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    if (iodev->history_count == PBIO_CONFIG_IODEV_HISTORY_SIZE) {
+        iodev->history_start = (iodev->history_start + 1) % PBIO_CONFIG_IODEV_HISTORY_SIZE;
+        iodev->history_count--;
+    }
+
+    pbio_iodev_sample_t *sample = &iodev->history[(iodev->history_start + iodev->history_count) % PBIO_CONFIG_IODEV_HISTORY_SIZE];
+    sample->time = time;
+    sample->mode = mode;
+    memcpy(sample->bin_data, data, size);
+    iodev->history_count++;
+    #endif
+}
+
+/**
+ * Reads the oldest data samples of a mode from the history of an I/O device
+ * and removes them from the history.
+ *
+ * Each sample is written to *buf* as a little-endian 32-bit timestamp (ms)
+ * followed by the raw data of the mode, as given by
+ * ::pbio_iodev_get_data_format(). Samples are read until no more fit in
+ * *buf*. Samples of other modes are kept, so they can still be read later.
+ *
+ * @param [in]  iodev       The I/O device
+ * @param [in]  mode        The mode of the samples
+ * @param [out] buf         Buffer for the samples
+ * @param [in]  size        Size of *buf* in bytes
+ * @param [out] written     Number of bytes written to *buf*
+ * @return                  ::PBIO_SUCCESS on success
+ *                          ::PBIO_ERROR_INVALID_ARG if the mode is not valid
+ *                          ::PBIO_ERROR_NO_DEV if the port does not have a device attached
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if samples are not kept
+ */
+pbio_error_t pbio_iodev_read_history(pbio_iodev_t *iodev, uint8_t mode, uint8_t *buf, size_t size, size_t *written) {
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    uint8_t len;
+    pbio_iodev_data_type_t type;
+    pbio_error_t err = pbio_iodev_get_data_format(iodev, mode, &len, &type);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    size_t data_size = len * pbio_iodev_size_of(type);
+
+    // Copy out samples of this mode while they fit, and move the samples
+    // that are kept towards the oldest end of the history.
+    *written = 0;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < iodev->history_count; i++) {
+        pbio_iodev_sample_t *sample = &iodev->history[(iodev->history_start + i) % PBIO_CONFIG_IODEV_HISTORY_SIZE];
+        if (sample->mode == mode && *written + 4 + data_size <= size) {
+            pbio_set_uint32_le(buf + *written, sample->time);
+            memcpy(buf + *written + 4, sample->bin_data, data_size);
+            *written += 4 + data_size;
+            continue;
+        }
+        if (kept != i) {
+            iodev->history[(iodev->history_start + kept) % PBIO_CONFIG_IODEV_HISTORY_SIZE] = *sample;
+        }
+        kept++;
+    }
+    iodev->history_count = kept;
+
+    return PBIO_SUCCESS;
+    #else
+    return PBIO_ERROR_NOT_SUPPORTED;
+    #endif
+}
@@ -7,6 +7,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include <pbdrv/clock.h>
@@ -14,6 +15,37 @@
 #include <pbio/error.h>
 #include <pbio/logger.h>
 
+// The log that is currently being streamed, if any.
+static pbio_log_t *stream_log;
+
+// Maximum number of bytes needed to store one value in compressed mode.
+#define PBIO_LOGGER_MAX_VARINT_SIZE (5)
+
+static void pbio_logger_init(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
+
+    // Stop streaming if we were streaming this log previously.
+    pbio_logger_stop(log);
+
+    // (re-)initialize logger status.
+    log->stream = false;
+    log->compressed = false;
+    log->num_rows_used = 0;
+    log->first_row = 0;
+    log->first_row_values_read = 0;
+    log->num_values_read = 0;
+    log->num_rows_dropped = 0;
+    log->num_bytes = 0;
+    log->num_bytes_used = 0;
+    log->num_rows_decoded = 0;
+    log->decode_offset = 0;
+    log->skipped_samples = 0;
+    log->data = buf;
+    log->num_rows = num_rows;
+    log->num_cols = num_cols;
+    log->down_sample = down_sample;
+    log->start_time = pbdrv_clock_get_ms();
+}
+
 /**
  * Starts logging in the background.
  *
@@ -24,14 +56,74 @@
  * @param [in]  down_sample For every @p down_sample of update calls, only one row is logged.
  */
 void pbio_logger_start(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
-    // (re-)initialize logger status.
-    log->num_rows_used = 0;
-    log->skipped_samples = 0;
-    log->data = buf;
-    log->num_rows = num_rows;
-    log->num_cols = num_cols;
-    log->down_sample = down_sample;
-    log->start_time = pbdrv_clock_get_ms();
+    pbio_logger_init(log, buf, num_rows, num_cols, down_sample);
+
+    // Data may now be logged.
+    log->active = true;
+}
+
+/**
+ * Starts logging in the background, using the buffer as a ring.
+ *
+ * Unlike ::pbio_logger_start, logging does not stop when the buffer is full.
+ * Rows must be drained with ::pbio_logger_read_stream instead. If they are
+ * not drained quickly enough, new rows are dropped until there is space.
+ *
+ * Only one log can be streamed at a time. Starting a stream stops any other
+ * log that was being streamed.
+ *
+ * @param [in]  log         Pointer to log.
+ * @param [in]  buf         Array large enough to hold @p num_rows rows of data.
+ * @param [in]  num_rows    Number of rows that can be buffered before they are read.
+ * @param [in]  num_cols    Number of entries in one row.
+ * @param [in]  down_sample For every @p down_sample of update calls, only one row is logged.
+ */
+void pbio_logger_start_stream(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
+
+    // Only one log can be streamed at a time.
+    if (stream_log) {
+        pbio_logger_stop(stream_log);
+    }
+
+    pbio_logger_init(log, buf, num_rows, num_cols, down_sample);
+    log->stream = true;
+    stream_log = log;
+
+    // Data may now be logged.
+    log->active = true;
+}
+
+/**
+ * Starts logging in the background, storing compressed rows.
+ *
+ * Each value is stored as the zig-zag varint encoded difference with the
+ * same value in the previous row. Most values change only a little between
+ * control loop iterations, so this usually takes one or two bytes per value
+ * instead of four. This lets the same buffer hold many more rows than
+ * @p num_rows. Logging stops when there may not be enough space left for
+ * another row.
+ *
+ * The first row of the buffer holds the most recently logged row, so the
+ * next row can be encoded relative to it. Rows must be read in order after
+ * logging has stopped, using ::pbio_logger_get_row_data.
+ *
+ * @param [in]  log         Pointer to log.
+ * @param [in]  buf         Array large enough to hold @p num_rows uncompressed rows of data.
+ * @param [in]  num_rows    Size of @p buf in number of uncompressed rows.
+ * @param [in]  num_cols    Number of entries in one row.
+ * @param [in]  down_sample For every @p down_sample of update calls, only one row is logged.
+ */
+void pbio_logger_start_compressed(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_t num_cols, int32_t down_sample) {
+    pbio_logger_init(log, buf, num_rows, num_cols, down_sample);
+    log->compressed = true;
+
+    // The first row is used for the previous row. The rest holds encoded data.
+    if (num_rows > 1) {
+        log->num_bytes = (num_rows - 1) * num_cols * sizeof(int32_t);
+
+        // The first row is encoded relative to zero.
+        memset(buf, 0, num_cols * sizeof(int32_t));
+    }
 
     // Data may now be logged.
     log->active = true;
@@ -44,6 +136,21 @@ void pbio_logger_start(pbio_log_t *log, int32_t *buf, uint32_t num_rows, uint32_
  */
 void pbio_logger_stop(pbio_log_t *log) {
     log->active = false;
+
+    if (log == stream_log) {
+        stream_log = NULL;
+    }
+}
+
+/**
+ * Stops the log that is currently being streamed, if any.
+ *
+ * Rows that have not been read yet are discarded.
+ */
+void pbio_logger_stop_stream(void) {
+    if (stream_log) {
+        pbio_logger_stop(stream_log);
+    }
 }
 
 /**
@@ -56,6 +163,92 @@ bool pbio_logger_is_active(pbio_log_t *log) {
     return log->active;
 }
 
+// Stores a value as a zig-zag varint and returns the number of bytes used.
+static uint32_t pbio_logger_encode_value(uint8_t *dest, int32_t value) {
+
+    // Zig-zag encoding maps small negative values to small positive values.
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+    // Store 7 bits per byte, with the top bit set if more bytes follow.
+    uint32_t size = 0;
+    while (zigzag >= 0x80) {
+        dest[size++] = (zigzag & 0x7f) | 0x80;
+        zigzag >>= 7;
+    }
+    dest[size++] = zigzag;
+    return size;
+}
+
+// Reads a zig-zag varint value and returns the number of bytes used.
+static uint32_t pbio_logger_decode_value(const uint8_t *src, int32_t *value) {
+    uint32_t zigzag = 0;
+    uint32_t size = 0;
+    do {
+        zigzag |= (uint32_t)(src[size] & 0x7f) << (7 * size);
+    } while (src[size++] & 0x80);
+
+    *value = (int32_t)((zigzag >> 1) ^ -(zigzag & 1));
+    return size;
+}
+
+static uint8_t *pbio_logger_get_compressed_data(pbio_log_t *log) {
+    return (uint8_t *)(log->data + log->num_cols);
+}
+
+static void pbio_logger_add_row_compressed(pbio_log_t *log, int32_t time, int32_t *row_data) {
+
+    // Exit if there may not be enough space for another row.
+    if (log->num_bytes_used + log->num_cols * PBIO_LOGGER_MAX_VARINT_SIZE > log->num_bytes) {
+        log->active = false;
+        return;
+    }
+
+    int32_t *previous = log->data;
+    uint8_t *dest = pbio_logger_get_compressed_data(log);
+
+    for (uint8_t i = 0; i < log->num_cols; i++) {
+        int32_t value = i < PBIO_LOGGER_NUM_DEFAULT_COLS ? time : row_data[i - PBIO_LOGGER_NUM_DEFAULT_COLS];
+
+        // Store the difference with the previous row. This may wrap around,
+        // which is undone by wrapping back around when decoding.
+        log->num_bytes_used += pbio_logger_encode_value(dest + log->num_bytes_used, (uint32_t)value - (uint32_t)previous[i]);
+        previous[i] = value;
+    }
+
+    // Increment used row counter.
+    log->num_rows_used++;
+}
+
+static int32_t *pbio_logger_get_row_data_compressed(pbio_log_t *log, uint32_t index) {
+
+    // The first row of the buffer is reused to hold the decoded row.
+    int32_t *row = log->data;
+
+    // We can only decode in order, so start over if an earlier row is needed.
+    if (index < log->num_rows_decoded) {
+        if (index + 1 == log->num_rows_decoded) {
+            return row;
+        }
+        log->num_rows_decoded = 0;
+    }
+    if (log->num_rows_decoded == 0) {
+        log->decode_offset = 0;
+        memset(row, 0, log->num_cols * sizeof(int32_t));
+    }
+
+    const uint8_t *src = pbio_logger_get_compressed_data(log);
+
+    while (log->num_rows_decoded <= index) {
+        for (uint8_t i = 0; i < log->num_cols; i++) {
+            int32_t delta;
+            log->decode_offset += pbio_logger_decode_value(src + log->decode_offset, &delta);
+            row[i] = (uint32_t)row[i] + (uint32_t)delta;
+        }
+        log->num_rows_decoded++;
+    }
+    return row;
+}
+
 /**
  * Add new data from a background loop.
  *
@@ -70,18 +263,30 @@ void pbio_logger_add_row(pbio_log_t *log, int32_t *row_data) {
     }
     log->skipped_samples = 0;
 
+    if (log->compressed) {
+        pbio_logger_add_row_compressed(log, pbdrv_clock_get_ms() - log->start_time, row_data);
+        return;
+    }
+
     // Exit if log is full.
     if (log->num_rows_used >= log->num_rows) {
-        log->active = false;
+        if (log->stream) {
+            // Keep streaming, but drop this row until the reader catches up.
+            log->num_rows_dropped++;
+        } else {
+            log->active = false;
+        }
         return;
     }
 
+    int32_t *row = pbio_logger_get_row_data(log, log->num_rows_used);
+
     // Write time of logging.
-    log->data[log->num_rows_used * log->num_cols] = pbdrv_clock_get_ms() - log->start_time;
+    row[0] = pbdrv_clock_get_ms() - log->start_time;
 
     // Write the data.
     for (uint8_t i = PBIO_LOGGER_NUM_DEFAULT_COLS; i < log->num_cols; i++) {
-        log->data[log->num_rows_used * log->num_cols + i] = row_data[i - PBIO_LOGGER_NUM_DEFAULT_COLS];
+        row[i] = row_data[i - PBIO_LOGGER_NUM_DEFAULT_COLS];
     }
 
     // Increment used row counter.
@@ -103,11 +308,68 @@ uint32_t pbio_logger_get_num_rows_used(pbio_log_t *log) {
 /**
  * Gets row from the log. Caller must ensure that valid index is used.
  *
+ * Compressed logs must be stopped before reading, and are fastest to read
+ * in order. The returned row is only valid until the next call.
+ *
  * @param [in]  log         Pointer to log.
+ * @param [in]  index       Index of the row, counting from the oldest row.
  * @return                  Pointer to row data.
  */
 int32_t *pbio_logger_get_row_data(pbio_log_t *log, uint32_t index) {
-    return log->data + index * log->num_cols;
+
+    if (log->compressed) {
+        return pbio_logger_get_row_data_compressed(log, index);
+    }
+
+    // In stream mode, the oldest row need not be at the start of the buffer.
+    uint32_t row = log->first_row + index;
+    if (row >= log->num_rows) {
+        row -= log->num_rows;
+    }
+    return log->data + row * log->num_cols;
+}
+
+/**
+ * Gets the log that is currently being streamed.
+ *
+ * @return                  The log or NULL if no log is being streamed.
+ */
+pbio_log_t *pbio_logger_get_stream(void) {
+    return stream_log;
+}
+
+/**
+ * Reads values from a streamed log and frees up the rows that were read.
+ *
+ * Rows are read as one flat sequence of values, so a read may stop halfway
+ * through a row. The next read continues where the previous one stopped.
+ *
+ * @param [in]  log         Pointer to log.
+ * @param [out] values      Buffer that receives the values.
+ * @param [in]  max_values  Maximum number of values to read.
+ * @param [out] index       Total number of values read from this stream
+ *                          before this call, used to locate the values.
+ * @return                  Number of values read.
+ */
+uint32_t pbio_logger_read_stream(pbio_log_t *log, int32_t *values, uint32_t max_values, uint32_t *index) {
+
+    *index = log->num_values_read;
+
+    uint32_t count = 0;
+    while (count < max_values && log->num_rows_used > 0) {
+        int32_t *row = pbio_logger_get_row_data(log, 0);
+        values[count++] = row[log->first_row_values_read++];
+
+        // Once the oldest row is fully read, free it up for new data.
+        if (log->first_row_values_read == log->num_cols) {
+            log->first_row_values_read = 0;
+            log->first_row = log->first_row + 1 == log->num_rows ? 0 : log->first_row + 1;
+            log->num_rows_used--;
+        }
+    }
+    log->num_values_read += count;
+
+    return count;
 }
 
 #endif // PBIO_CONFIG_LOGGER
@@ -16,9 +16,11 @@
 #include <pbdrv/ioport.h>
 #include <pbdrv/sound.h>
 #include <pbio/config.h>
+#include <pbio/control_settings.h>
 #include <pbio/dcmotor.h>
 #include <pbio/light_matrix.h>
 #include <pbio/light.h>
+#include <pbio/logger.h>
 #include <pbio/main.h>
 #include <pbio/uartdev.h>
 
@@ -69,7 +71,14 @@ void pbio_stop_all(bool reset) {
     }
     #endif
     pbio_dcmotor_stop_all(reset);
+    if (reset) {
+        // The next program starts with the default loop time.
+        pbio_control_settings_set_loop_time(PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    }
     pbdrv_sound_stop();
+
+    // The log buffer belongs to the application, so stop draining it.
+    pbio_logger_stop_stream();
 }
 
 /**
@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+#include <pbio/error.h>
+#include <pbio/motion_group.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#if PBIO_CONFIG_NUM_MOTION_GROUPS > 0
+
+// Motion group objects
+static pbio_motion_group_t motion_groups[PBIO_CONFIG_NUM_MOTION_GROUPS];
+
+/**
+ * Gets the state of the motion group update loop.
+ *
+ * This becomes true after a successful call to
+ * pbio_motion_group_get_motion_group and becomes false when there is an
+ * error, such as when a cable is unplugged.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  True if up and running, false if not.
+ */
+bool pbio_motion_group_update_loop_is_running(pbio_motion_group_t *group) {
+
+    // Motion group must have servos.
+    if (group->num_axes == 0) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_servo_t *srv = group->axes[i];
+
+        // Motion group must be the parent of all of its servos, and all servo
+        // update loops must be running.
+        if (!pbio_parent_equals(&srv->parent, group) || !pbio_servo_update_loop_is_running(srv)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Stops control of all servos in a motion group and coasts them.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  Error code.
+ */
+static pbio_error_t pbio_motion_group_coast_axes(pbio_motion_group_t *group) {
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_control_stop(&group->axes[i]->control);
+        pbio_error_t err = pbio_dcmotor_coast(group->axes[i]->dcmotor);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Motion group stop function that can be called from a servo.
+ *
+ * When a new command is issued to one of the servos, the servo calls this to
+ * stop the group command and to stop the other motors physically.
+ *
+ * @param [in]  motion_group    Void pointer to this motion group instance.
+ * @param [in]  clear_parent    Unused. There is currently no higher
+ *                              abstraction than a motion group.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_motion_group_stop_from_servo(void *motion_group, bool clear_parent) {
+
+    // Specify pointer type.
+    pbio_motion_group_t *group = motion_group;
+
+    // If no group command is active, there is nothing we need to do.
+    if (!group->active) {
+        return PBIO_SUCCESS;
+    }
+    group->active = false;
+
+    // Since we don't know which child called the parent to stop, we stop all
+    // motors. We don't stop their parents to avoid escalating the stop calls
+    // up the chain (and back here) once again.
+    return pbio_motion_group_coast_axes(group);
+}
+
+/**
+ * Gets motion group instance from several servo instances.
+ *
+ * @param [out] group_address    Motion group instance if available.
+ * @param [in]  axes             Servo instances.
+ * @param [in]  num_axes         Number of servos.
+ * @return                       Error code.
+ */
+pbio_error_t pbio_motion_group_get_motion_group(pbio_motion_group_t **group_address, pbio_servo_t **axes, uint8_t num_axes) {
+
+    // Need at least two servos to coordinate, each used only once.
+    if (num_axes < 2 || num_axes > PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    for (uint8_t i = 0; i < num_axes; i++) {
+        for (uint8_t j = 0; j < i; j++) {
+            if (axes[i] == axes[j]) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+        }
+
+        // If a servo is already in use by a higher level
+        // abstraction like a drivebase, we can't re-use it.
+        if (pbio_parent_exists(&axes[i]->parent)) {
+            return PBIO_ERROR_BUSY;
+        }
+    }
+
+    // Now we know that the servos are free, there must be an available
+    // motion group. We can just use the first one that isn't running.
+    uint8_t index;
+    for (index = 0; index < PBIO_CONFIG_NUM_MOTION_GROUPS; index++) {
+        if (!pbio_motion_group_update_loop_is_running(&motion_groups[index])) {
+            break;
+        }
+    }
+    // Verify result is in range.
+    if (index == PBIO_CONFIG_NUM_MOTION_GROUPS) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // So, this is the motion group we'll use.
+    pbio_motion_group_t *group = &motion_groups[index];
+    *group_address = group;
+
+    // Attach servos and set their parents, so they can stop this group.
+    group->num_axes = num_axes;
+    group->active = false;
+    for (uint8_t i = 0; i < num_axes; i++) {
+        group->axes[i] = axes[i];
+        pbio_parent_set(&axes[i]->parent, group, pbio_motion_group_stop_from_servo);
+    }
+
+    // Reset all motors to a passive state.
+    return pbio_motion_group_stop(group, PBIO_CONTROL_ON_COMPLETION_COAST);
+}
+
+/**
+ * Starts all servos to run to a target, such that they start and finish at
+ * the same time.
+ *
+ * Either all servos start, or none of them do. All servos must use the same
+ * speed profile, since trajectories with different profiles can't be
+ * stretched to the same duration.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Speed of the servo that takes the longest, in deg/s.
+ * @param [in]  positions       One target angle or relative angle per servo, in deg.
+ * @param [in]  relative        Whether positions are relative to the current angles.
+ * @param [in]  on_completion   What to do when reaching the target.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_motion_group_run(pbio_motion_group_t *group, int32_t speed, const int32_t *positions, bool relative, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_motion_group_update_loop_is_running(group)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Read the physical and estimated state of all servos before changing
+    // any of them, so that a servo that fails doesn't leave the others
+    // running on their own.
+    pbio_control_state_t states[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_servo_t *srv = group->axes[i];
+        if (srv->control.settings.profile != group->axes[0]->control.settings.profile) {
+            return PBIO_ERROR_INVALID_OP;
+        }
+        pbio_error_t err = pbio_servo_get_state_control(srv, &states[i]);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+
+    // All trajectories start at the same time.
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    pbio_trajectory_t *trajectories[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_servo_t *srv = group->axes[i];
+
+        // Stop ongoing control, so that each trajectory starts from the
+        // measured state at the same time instead of continuing from an
+        // earlier trajectory.
+        pbio_control_stop(&srv->control);
+
+        // Plan the trajectory of this servo at the group speed.
+        pbio_error_t err;
+        if (relative) {
+            err = pbio_control_start_position_control_relative(&srv->control, time_now, &states[i], positions[i], speed, on_completion);
+        } else {
+            err = pbio_control_start_position_control(&srv->control, time_now, &states[i], positions[i], speed, on_completion);
+        }
+        if (err != PBIO_SUCCESS) {
+            // Stop the servos that already started, and any ongoing
+            // movement of the others.
+            pbio_motion_group_coast_axes(group);
+            return err;
+        }
+        trajectories[i] = &srv->control.trajectory;
+    }
+
+    // The slowest servo sets the pace. All others are slowed down so they
+    // finish at the same time. All servos are updated in the same control
+    // loop iteration, so they stay synchronized.
+    pbio_trajectory_synchronize(trajectories, group->num_axes);
+    group->active = true;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Starts all servos to run to a target angle, such that they start and
+ * finish at the same time.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Speed of the servo that takes the longest, in deg/s.
+ * @param [in]  targets         One target angle per servo, in deg.
+ * @param [in]  on_completion   What to do when reaching the target.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_run_target(pbio_motion_group_t *group, int32_t speed, const int32_t *targets, pbio_control_on_completion_t on_completion) {
+    return pbio_motion_group_run(group, speed, targets, false, on_completion);
+}
+
+/**
+ * Starts all servos to run by an angle, such that they start and finish at
+ * the same time.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Speed of the servo that takes the longest, in deg/s.
+ * @param [in]  angles          One relative angle per servo, in deg.
+ * @param [in]  on_completion   What to do when reaching the target.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_run_angle(pbio_motion_group_t *group, int32_t speed, const int32_t *angles, pbio_control_on_completion_t on_completion) {
+    return pbio_motion_group_run(group, speed, angles, true, on_completion);
+}
+
+/**
+ * Stops all servos in a motion group.
+ *
+ * @param [in]  group            Motion group instance.
+ * @param [in]  on_completion    Which stop type to use.
+ * @return                       Error code.
+ */
+pbio_error_t pbio_motion_group_stop(pbio_motion_group_t *group, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_motion_group_update_loop_is_running(group)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // We're asked to stop, so continuing makes no sense.
+    if (on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // The group command ends here, so the servo stops below won't call back.
+    group->active = false;
+
+    // Stop the servos and pass on requested stop type.
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        pbio_error_t err = pbio_servo_stop(group->axes[i], on_completion);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Checks if all servos in a motion group have completed their maneuver.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  True if done, false if any servo is still moving.
+ */
+bool pbio_motion_group_is_done(pbio_motion_group_t *group) {
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        if (!pbio_control_is_done(&group->axes[i]->control)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks if any servo in a motion group is stalled.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [out] stalled         True if any servo is stalled, false if not.
+ * @param [out] stall_duration  For how long the longest stalled servo has been stalled (ms).
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_is_stalled(pbio_motion_group_t *group, bool *stalled, uint32_t *stall_duration) {
+
+    *stalled = false;
+    *stall_duration = 0;
+
+    for (uint8_t i = 0; i < group->num_axes; i++) {
+        bool axis_stalled;
+        uint32_t axis_stall_duration;
+        pbio_error_t err = pbio_servo_is_stalled(group->axes[i], &axis_stalled, &axis_stall_duration);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        if (axis_stalled) {
+            *stalled = true;
+            if (axis_stall_duration > *stall_duration) {
+                *stall_duration = axis_stall_duration;
+            }
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+#endif // PBIO_CONFIG_NUM_MOTION_GROUPS > 0
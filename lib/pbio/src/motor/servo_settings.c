@@ -244,6 +244,11 @@ pbio_error_t pbio_servo_load_settings(pbio_control_settings_t *settings, const p
     settings->stall_time = pbio_control_time_ms_to_ticks(200);
     settings->integral_change_max = DEG_TO_MDEG(15);
 
+    // Use the same gains at all speeds and loads by default.
+    for (uint8_t i = 0; i < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM; i++) {
+        settings->gain_schedules[i].num_points = 0;
+    }
+
     // Device type specific speed, acceleration, and PD settings.
     switch (id) {
         case PBIO_IODEV_TYPE_ID_NONE:
@@ -330,6 +335,9 @@ pbio_error_t pbio_servo_load_settings(pbio_control_settings_t *settings, const p
     // Deceleration defaults to same value as acceleration
     settings->deceleration = settings->acceleration;
 
+    // Use trapezoidal speed profiles by default.
+    settings->profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
+
     // Initialize maximum torque as the stall torque for maximum voltage.
     settings->actuation_max = pbio_observer_voltage_to_torque(*model, pbio_dcmotor_get_max_voltage(id));
 
@@ -1,15 +1,122 @@
 // SPDX-License-Identifier: MIT
-// Copyright (c) 2018-2020 The Pybricks Authors
+// Copyright (c) 2018-2023 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbdrv/clock.h>
 
 #include <pbio/battery.h>
 #include <pbio/control.h>
 #include <pbio/drivebase.h>
+#include <pbio/int_math.h>
+#include <pbio/motor_process.h>
 #include <pbio/servo.h>
+#include <pbio/sysid.h>
 
 #include <contiki.h>
 
 #if PBDRV_CONFIG_NUM_MOTOR_CONTROLLER != 0
 
+#if PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+static pbio_motor_process_profile_t profile;
+
+// Start time of the previous loop iteration, used to measure the period.
+static uint32_t profile_loop_start;
+
+// Whether profile_loop_start is valid.
+static bool profile_loop_started;
+
+/**
+ * Resets the control loop profile.
+ */
+void pbio_motor_process_profile_reset(void) {
+    profile = (pbio_motor_process_profile_t) {0};
+    profile_loop_started = false;
+}
+
+/**
+ * Gets the control loop profile collected since the last reset.
+ *
+ * @return                  The profile.
+ */
+const pbio_motor_process_profile_t *pbio_motor_process_get_profile(void) {
+    return &profile;
+}
+
+/**
+ * Gets the mean value of a measured duration.
+ *
+ * @param [in]  timing      The timing statistics.
+ * @return                  The mean duration in microseconds, or 0 if nothing was measured.
+ */
+uint32_t pbio_motor_process_timing_get_mean(const pbio_motor_process_timing_t *timing) {
+    if (timing->count == 0) {
+        return 0;
+    }
+    return timing->sum / timing->count;
+}
+
+static void pbio_motor_process_timing_add(pbio_motor_process_timing_t *timing, uint32_t duration) {
+    if (timing->count == 0 || duration < timing->min) {
+        timing->min = duration;
+    }
+    if (duration > timing->max) {
+        timing->max = duration;
+    }
+    timing->sum += duration;
+    timing->count++;
+}
+
+static uint32_t pbio_motor_process_profile_loop_begin(void) {
+    uint32_t now = pbdrv_clock_get_us();
+
+    if (profile_loop_started) {
+        const uint32_t nominal = pbio_control_settings_get_loop_time() * 1000;
+        uint32_t period = now - profile_loop_start;
+        pbio_motor_process_timing_add(&profile.period, period);
+
+        // Update jitter histogram.
+        uint32_t bin = pbio_int_math_abs((int32_t)(period - nominal)) / PBIO_MOTOR_PROCESS_JITTER_BIN_US;
+        profile.jitter[pbio_int_math_min(bin, PBIO_MOTOR_PROCESS_JITTER_NUM_BINS - 1)]++;
+
+        if (period >= nominal * 2) {
+            profile.num_late++;
+        }
+    }
+    profile_loop_start = now;
+    profile_loop_started = true;
+
+    return now;
+}
+
+static void pbio_motor_process_profile_stage_end(pbio_motor_process_stage_t stage, uint32_t *stage_start) {
+    uint32_t now = pbdrv_clock_get_us();
+    pbio_motor_process_timing_add(&profile.stages[stage], now - *stage_start);
+    *stage_start = now;
+}
+
+static void pbio_motor_process_profile_loop_end(uint32_t loop_start) {
+    if (pbdrv_clock_get_us() - loop_start > pbio_control_settings_get_loop_time() * 1000) {
+        profile.num_overruns++;
+    }
+}
+
+#else // PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+static inline uint32_t pbio_motor_process_profile_loop_begin(void) {
+    return 0;
+}
+
+static inline void pbio_motor_process_profile_stage_end(pbio_motor_process_stage_t stage, uint32_t *stage_start) {
+}
+
+static inline void pbio_motor_process_profile_loop_end(uint32_t loop_start) {
+}
+
+#endif // PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
 PROCESS(pbio_motor_process, "servo");
 
 PROCESS_THREAD(pbio_motor_process, ev, data) {
@@ -23,22 +130,31 @@ PROCESS_THREAD(pbio_motor_process, ev, data) {
     // Initialize motors in stopped state.
     pbio_dcmotor_stop_all(true);
 
-    etimer_set(&timer, PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    etimer_set(&timer, pbio_control_settings_get_loop_time());
 
     for (;;) {
         PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && etimer_expired(&timer));
 
+        uint32_t loop_start = pbio_motor_process_profile_loop_begin();
+        uint32_t stage_start = loop_start;
+
         // Update battery voltage.
         pbio_battery_update();
+        pbio_motor_process_profile_stage_end(PBIO_MOTOR_PROCESS_STAGE_BATTERY, &stage_start);
 
         // Update drivebase
         pbio_drivebase_update_all();
+        pbio_motor_process_profile_stage_end(PBIO_MOTOR_PROCESS_STAGE_DRIVEBASE, &stage_start);
 
-        // Update servos
+        // Update servos, and any ongoing motor model identification.
         pbio_servo_update_all();
+        pbio_sysid_update_all();
+        pbio_motor_process_profile_stage_end(PBIO_MOTOR_PROCESS_STAGE_SERVO, &stage_start);
+
+        pbio_motor_process_profile_loop_end(loop_start);
 
-        // Reset timer to wait for next update
-        etimer_restart(&timer);
+        // Reset timer to wait for next update, which may have a new loop time.
+        etimer_set(&timer, pbio_control_settings_get_loop_time());
     }
 
     PROCESS_END();
@@ -7,6 +7,8 @@
 #include <math.h>
 
 #include <pbio/angle.h>
+#include <pbio/config.h>
+#include <pbio/control_settings.h>
 #include <pbio/dcmotor.h>
 #include <pbio/int_math.h>
 #include <pbio/observer.h>
@@ -44,6 +46,12 @@ void pbio_observer_reset(pbio_observer_t *obs, pbio_control_settings_t *settings
     // Reset stall state.
     obs->stalled = false;
 
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS < PBIO_CONFIG_CONTROL_LOOP_TIME_MS
+    // Make the model for short loop times again when it is next needed.
+    obs->step_model_base = NULL;
+    obs->step_model_time = 0;
+    #endif
+
     // Reset position differentiator.
     pbio_differentiator_reset(&obs->differentiator, angle);
 }
@@ -117,16 +125,58 @@ int32_t pbio_observer_get_feedback_torque(pbio_observer_t *obs, const pbio_angle
     return pbio_control_settings_mul_by_gain(error, obs->model->gain);
 }
 
+/**
+ * Gets the model used for the observer steps at the current loop time.
+ *
+ * @param [in]  obs            The observer instance.
+ * @param [out] num_steps      How many model steps fit in one loop iteration.
+ * @return                     The model.
+ */
+static const pbio_observer_model_t *pbio_observer_get_step_model(pbio_observer_t *obs, uint32_t *num_steps) {
+
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS < PBIO_CONFIG_CONTROL_LOOP_TIME_MS
+    // Shorter loop times take one step of a model made for that time step.
+    // It is made again only if the loop time or the model changes.
+    if (loop_time < PBIO_CONFIG_CONTROL_LOOP_TIME_MS) {
+        if (obs->step_model_base != obs->model || obs->step_model_time != loop_time) {
+            // This only fails for models that don't describe a real motor.
+            // Then keep the base model, which runs too slowly but is stable.
+            if (pbio_observer_model_for_step(&obs->step_model, obs->model, loop_time) != PBIO_SUCCESS) {
+                obs->step_model = *obs->model;
+            }
+            obs->step_model_base = obs->model;
+            obs->step_model_time = loop_time;
+        }
+        *num_steps = 1;
+        return &obs->step_model;
+    }
+
+    // A model may be changed in place at this loop time, such as by system
+    // identification, so make the short step model again next time.
+    obs->step_model_base = NULL;
+    #endif
+
+    // The model is discretized with the base loop time, so take as many
+    // model steps as fit in one control loop iteration. The input is held
+    // constant in between.
+    *num_steps = loop_time / PBIO_CONFIG_CONTROL_LOOP_TIME_MS;
+    return obs->model;
+}
+
 /**
  * Predicts next system state and corrects the model using a measurement.
  *
  * @param [in]  obs            The observer instance.
  * @param [in]  time           Wall time.
  * @param [in]  angle          Measured angle used to correct the model.
+ * @param [in]  edge_age       Time since the measured angle last changed (us),
+ *                             or ::PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN.
  * @param [in]  actuation      Actuation type currently applied to the motor.
  * @param [in]  voltage        If actuation type is voltage, this is the payload in mV.
  */
-void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_t *angle, pbio_dcmotor_actuation_t actuation, int32_t voltage) {
+void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_t *angle, uint32_t edge_age, pbio_dcmotor_actuation_t actuation, int32_t voltage) {
 
     const pbio_observer_model_t *m = obs->model;
 
@@ -135,7 +185,7 @@ void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_
     }
 
     // Update numerical derivative as speed sanity check.
-    obs->speed_numeric = pbio_differentiator_get_speed(&obs->differentiator, angle);
+    obs->speed_numeric = pbio_differentiator_get_speed(&obs->differentiator, angle, edge_age);
 
     // Apply observer error feedback as voltage.
     // int32_t feedback_voltage = pbio_observer_torque_to_voltage(m,
@@ -156,34 +206,42 @@ void pbio_observer_update(pbio_observer_t *obs, uint32_t time, const pbio_angle_
     // keep it in sync with the real system.
     voltage += feedback_voltage;
 
-    // The only modeled torque is a static friction torque.
-    int32_t torque = obs->speed > 0 ? m->torque_friction / 2: -m->torque_friction / 2;
-
-    // Get next state based on current state and input: x(k+1) = Ax(k) + Bu(k)
-    pbio_angle_add_mdeg(&obs->angle,
-        PRESCALE_SPEED * obs->speed / m->d_angle_d_speed +
-        PRESCALE_CURRENT * obs->current / m->d_angle_d_current +
-        PRESCALE_VOLTAGE * voltage / m->d_angle_d_voltage +
-        PRESCALE_TORQUE * torque / m->d_angle_d_torque);
-    int32_t speed_next = pbio_int_math_clamp(0 +
-        PRESCALE_SPEED * obs->speed / m->d_speed_d_speed +
-        PRESCALE_CURRENT * obs->current / m->d_speed_d_current +
-        PRESCALE_VOLTAGE * voltage / m->d_speed_d_voltage +
-        PRESCALE_TORQUE * torque / m->d_speed_d_torque, MAX_NUM_SPEED);
-    int32_t current_next = pbio_int_math_clamp(0 +
-        PRESCALE_SPEED * obs->speed / m->d_current_d_speed +
-        PRESCALE_CURRENT * obs->current / m->d_current_d_current +
-        PRESCALE_VOLTAGE * voltage / m->d_current_d_voltage +
-        PRESCALE_TORQUE * torque / m->d_current_d_torque, MAX_NUM_CURRENT);
-
-    // TODO: Better friction model.
-    if ((speed_next < 0) != (speed_next - PRESCALE_TORQUE * torque / m->d_speed_d_torque < 0)) {
-        speed_next = 0;
-    }
+    // Get the model for the current loop time, which may take several steps
+    // per loop iteration.
+    uint32_t num_steps;
+    m = pbio_observer_get_step_model(obs, &num_steps);
+
+    for (uint32_t i = 0; i < num_steps; i++) {
+
+        // The only modeled torque is a static friction torque.
+        int32_t torque = obs->speed > 0 ? m->torque_friction / 2: -m->torque_friction / 2;
+
+        // Get next state based on current state and input: x(k+1) = Ax(k) + Bu(k)
+        pbio_angle_add_mdeg(&obs->angle,
+            PRESCALE_SPEED * obs->speed / m->d_angle_d_speed +
+            PRESCALE_CURRENT * obs->current / m->d_angle_d_current +
+            PRESCALE_VOLTAGE * voltage / m->d_angle_d_voltage +
+            PRESCALE_TORQUE * torque / m->d_angle_d_torque);
+        int32_t speed_next = pbio_int_math_clamp(0 +
+            PRESCALE_SPEED * obs->speed / m->d_speed_d_speed +
+            PRESCALE_CURRENT * obs->current / m->d_speed_d_current +
+            PRESCALE_VOLTAGE * voltage / m->d_speed_d_voltage +
+            PRESCALE_TORQUE * torque / m->d_speed_d_torque, MAX_NUM_SPEED);
+        int32_t current_next = pbio_int_math_clamp(0 +
+            PRESCALE_SPEED * obs->speed / m->d_current_d_speed +
+            PRESCALE_CURRENT * obs->current / m->d_current_d_current +
+            PRESCALE_VOLTAGE * voltage / m->d_current_d_voltage +
+            PRESCALE_TORQUE * torque / m->d_current_d_torque, MAX_NUM_CURRENT);
+
+        // TODO: Better friction model.
+        if ((speed_next < 0) != (speed_next - PRESCALE_TORQUE * torque / m->d_speed_d_torque < 0)) {
+            speed_next = 0;
+        }
 
-    // Save new state.
-    obs->speed = speed_next;
-    obs->current = current_next;
+        // Save new state.
+        obs->speed = speed_next;
+        obs->current = current_next;
+    }
 }
 
 /**
@@ -222,3 +280,164 @@ int32_t pbio_observer_torque_to_voltage(const pbio_observer_model_t *model, int3
 int32_t pbio_observer_voltage_to_torque(const pbio_observer_model_t *model, int32_t voltage) {
     return PRESCALE_VOLTAGE * pbio_int_math_clamp(voltage, MAX_NUM_VOLTAGE) / model->d_torque_d_voltage;
 }
+
+/**
+ * Gets the stored form of a model coefficient, PRESCALE / coefficient, where
+ * the coefficient is given as the fraction @p num / @p den.
+ *
+ * Coefficients that are zero are stored as the largest possible value. Then
+ * the prescaled signal divided by it is always zero.
+ */
+static int32_t pbio_observer_model_coefficient(int64_t prescale, int64_t num, int64_t den) {
+    if (num == 0) {
+        return INT32_MAX;
+    }
+    int64_t result = prescale * den / num;
+    if (result > INT32_MAX || result < -INT32_MAX) {
+        return result > 0 ? INT32_MAX : -INT32_MAX;
+    }
+    if (result == 0) {
+        return num > 0 ? 1 : -1;
+    }
+    return result;
+}
+
+/**
+ * Makes an observer model from a first order model of the motor, such as
+ * one obtained by system identification.
+ *
+ * The first order model gives the angle increment d in millidegrees during
+ * each model step of @p step ms:
+ *
+ *     d(k + 1) = alpha * d(k) + beta * voltage(k) - gamma * sign(d(k))
+ *
+ * The current is not measured, so it is not a state of the first order
+ * model. Likewise, the ratio between voltage and torque cannot be identified
+ * from the angle alone, so it is taken from the @p base model of the same
+ * device type, along with the observer gain.
+ *
+ * @param [out] model       The resulting model.
+ * @param [in]  base        Model for this type of motor, used for constants that are not identified.
+ * @param [in]  step        Model step in ms.
+ * @param [in]  alpha       Speed decay per step, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @param [in]  beta        Angle increment per mV, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @param [in]  gamma       Friction in mdeg per step, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @return                  ::PBIO_SUCCESS on success, or ::PBIO_ERROR_FAILED
+ *                          if the parameters don't describe a stable motor.
+ */
+pbio_error_t pbio_observer_model_from_first_order(pbio_observer_model_t *model, const pbio_observer_model_t *base, uint32_t step, int64_t alpha, int64_t beta, int64_t gamma) {
+
+    const int64_t one = PBIO_OBSERVER_FIRST_ORDER_ONE;
+    const int64_t h = step;
+
+    // The speed must decay without changing sign, voltage must push forward,
+    // and friction must oppose motion.
+    if (alpha <= 0 || alpha >= one || beta <= 0 || gamma < 0) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // Torque per voltage, as PRESCALE_VOLTAGE / d_torque_d_voltage.
+    const int64_t d_torque_d_voltage = base->d_torque_d_voltage;
+
+    // Angle and speed are driven by voltage. The speed state is the average
+    // speed during the previous step, so the angle advances by its value
+    // times the step time.
+    model->d_angle_d_speed = pbio_observer_model_coefficient(PRESCALE_SPEED * 1000, alpha * h, one);
+    model->d_speed_d_speed = pbio_observer_model_coefficient(PRESCALE_SPEED, alpha, one);
+    model->d_angle_d_voltage = pbio_observer_model_coefficient(PRESCALE_VOLTAGE, beta, one);
+    model->d_speed_d_voltage = pbio_observer_model_coefficient(PRESCALE_VOLTAGE * h, beta * 1000, one);
+
+    // A load torque acts like the equivalent negative voltage.
+    model->d_angle_d_torque = pbio_observer_model_coefficient(PRESCALE_TORQUE * PRESCALE_VOLTAGE, -beta * d_torque_d_voltage, one);
+    model->d_speed_d_torque = pbio_observer_model_coefficient(PRESCALE_TORQUE * PRESCALE_VOLTAGE * h, -beta * d_torque_d_voltage * 1000, one);
+
+    // The current is not a state of the first order model.
+    model->d_current_d_speed = INT32_MAX;
+    model->d_angle_d_current = INT32_MAX;
+    model->d_speed_d_current = INT32_MAX;
+    model->d_current_d_current = INT32_MAX;
+    model->d_current_d_voltage = INT32_MAX;
+    model->d_current_d_torque = INT32_MAX;
+
+    // Steady state conversions between voltage and torque are not identified.
+    model->d_voltage_d_torque = base->d_voltage_d_torque;
+    model->d_torque_d_voltage = base->d_torque_d_voltage;
+
+    // The steady state speed per voltage is beta / (one - alpha) / h, so the
+    // back EMF torque per speed is the torque per voltage divided by that.
+    int64_t speed_scale = PRESCALE_SPEED * 1000 * beta / ((one - alpha) * h);
+    model->d_torque_d_speed = pbio_observer_model_coefficient(speed_scale * d_torque_d_voltage, PRESCALE_VOLTAGE, 1);
+
+    // The time constant is approximately h * (one + alpha) / (one - alpha) / 2,
+    // and the torque per acceleration is the time constant times the torque
+    // per speed.
+    int64_t acceleration_scale = PRESCALE_ACCELERATION * 2000000 * beta / ((one + alpha) * h * h);
+    model->d_torque_d_acceleration = pbio_observer_model_coefficient(acceleration_scale * d_torque_d_voltage, PRESCALE_VOLTAGE, 1);
+
+    // The voltage that balances friction, converted to torque. The observer
+    // and feedforward use half the friction torque.
+    int64_t friction_voltage_uv = gamma * 1000 / beta;
+    int64_t torque_friction = friction_voltage_uv * 2 * PRESCALE_VOLTAGE / 1000 / d_torque_d_voltage;
+    model->torque_friction = torque_friction > MAX_NUM_TORQUE ? MAX_NUM_TORQUE : torque_friction;
+
+    model->gain = base->gain;
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Makes an observer model for another model step than the one it was
+ * discretized with, such as for a loop time shorter than
+ * ::PBIO_CONFIG_CONTROL_LOOP_TIME_MS.
+ *
+ * Apart from the discrete model, each model gives the steady state torque
+ * per voltage and per speed, the torque per acceleration, and the friction.
+ * Together, these are a first order model of the motor in continuous time,
+ * which is discretized for the new step with the same time constant
+ * approximation as pbio_observer_model_from_first_order(). The current is
+ * not modeled, but its time constant is much shorter than one step anyway.
+ *
+ * @param [out] model       The resulting model.
+ * @param [in]  base        Model of the motor at any step.
+ * @param [in]  step        New model step in ms.
+ * @return                  ::PBIO_SUCCESS on success, or ::PBIO_ERROR_FAILED
+ *                          if the model doesn't describe a stable motor at
+ *                          this step.
+ */
+pbio_error_t pbio_observer_model_for_step(pbio_observer_model_t *model, const pbio_observer_model_t *base, uint32_t step) {
+
+    const int64_t one = PBIO_OBSERVER_FIRST_ORDER_ONE;
+    const int64_t h_us = step * 1000;
+
+    if (base->d_torque_d_speed <= 0 || base->d_torque_d_acceleration <= 0 || base->d_torque_d_voltage <= 0) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // The time constant (us) is the torque per acceleration divided by the
+    // torque per speed. It must be long enough to be sampled at this step.
+    int64_t time_constant = (int64_t)1000000 * PRESCALE_ACCELERATION * base->d_torque_d_speed /
+        ((int64_t)PRESCALE_SPEED * base->d_torque_d_acceleration);
+    if (time_constant * 2 <= h_us || time_constant > 10000000) {
+        return PBIO_ERROR_FAILED;
+    }
+    int64_t alpha = one * (time_constant * 2 - h_us) / (time_constant * 2 + h_us);
+
+    // The steady state speed (mdeg/s) per voltage (V) is the torque per
+    // voltage divided by the torque per speed.
+    int64_t speed_per_voltage = (int64_t)PRESCALE_VOLTAGE * 1000 * base->d_torque_d_speed /
+        ((int64_t)PRESCALE_SPEED * base->d_torque_d_voltage);
+    if (speed_per_voltage <= 0 || speed_per_voltage > ((int64_t)1 << 28)) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // In steady state, the angle increment per step per voltage is
+    // beta / (one - alpha).
+    int64_t beta = (one - alpha) * speed_per_voltage * step / 1000000;
+
+    // The friction is given as twice the torque that balances it. Gamma is
+    // the angle increment that the voltage of that torque would give.
+    int64_t friction_voltage_uv = (int64_t)base->torque_friction * base->d_torque_d_voltage * 1000 / (2 * PRESCALE_VOLTAGE);
+    int64_t gamma = beta * friction_voltage_uv / 1000;
+
+    return pbio_observer_model_from_first_order(model, base, step, alpha, beta, gamma);
+}
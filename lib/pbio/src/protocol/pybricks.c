@@ -25,6 +25,27 @@ uint32_t pbio_pybricks_event_status_report(uint8_t *buf, uint32_t flags) {
     return 5;
 }
 
+/**
+ * Writes Pybricks log data event to @p buf
+ *
+ * @param [in]  buf         The buffer to hold the binary data. Must be large
+ *                          enough to hold 4 + 4 * @p num_values bytes.
+ * @param [in]  num_cols    The number of values per row of the log.
+ * @param [in]  index       The index of the first value in the stream.
+ * @param [in]  values      The values.
+ * @param [in]  num_values  The number of values, at most ::PBIO_PYBRICKS_EVENT_LOG_DATA_MAX_VALUES.
+ * @return                  The number of bytes written to @p buf.
+ */
+uint32_t pbio_pybricks_event_log_data(uint8_t *buf, uint8_t num_cols, uint32_t index, const int32_t *values, uint32_t num_values) {
+    buf[0] = PBIO_PYBRICKS_EVENT_LOG_DATA;
+    buf[1] = num_cols;
+    pbio_set_uint16_le(&buf[2], index);
+    for (uint32_t i = 0; i < num_values; i++) {
+        pbio_set_uint32_le(&buf[4 + i * 4], values[i]);
+    }
+    return 4 + num_values * 4;
+}
+
 /**
  * Encodes the value of the Pybricks hub capabilities characteristic.
  *
@@ -68,46 +68,86 @@ bool pbio_servo_update_loop_is_running(pbio_servo_t *srv) {
     return srv->run_update_loop;
 }
 
-static pbio_error_t pbio_servo_update(pbio_servo_t *srv) {
+// Intermediate results of one servo during pbio_servo_update_all().
+typedef struct {
+    // Physical and estimated state.
+    pbio_control_state_t state;
+    // Time since the measured angle last changed, if known.
+    uint32_t edge_age;
+    // Whether control was active at the start of the update.
+    bool control;
+    // Whether control was still active after the control update.
+    bool active;
+    // Trajectory reference point, if control is active.
+    pbio_trajectory_reference_t ref;
+    // Requested actuation type, if control is active.
+    pbio_dcmotor_actuation_t actuation;
+    // Calculated control torques.
+    int32_t feedback_torque;
+    int32_t feedforward_torque;
+} pbio_servo_update_t;
 
-    // Get current time
-    uint32_t time_now = pbio_control_get_time_ticks();
+// Completes the servo state for the physical angle in the state.
+static void pbio_servo_get_state_estimate(pbio_servo_t *srv, pbio_control_state_t *state) {
 
-    // Read the physical and estimated state
-    pbio_control_state_t state;
-    pbio_error_t err = pbio_servo_get_state_control(srv, &state);
-    if (err != PBIO_SUCCESS) {
-        return err;
+    // Get estimated state
+    pbio_observer_get_estimated_state(&srv->observer, &state->speed, &state->position_estimate, &state->speed_estimate);
+
+    // The observer error is a measure of the load torque. It is only needed
+    // for gain scheduling, so skip it if the gains don't depend on the load.
+    state->load_estimate = 0;
+    if (pbio_control_settings_gain_schedule_is_active(&srv->control.settings, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD)) {
+        state->load_estimate = pbio_observer_get_feedback_torque(&srv->observer, &state->position);
     }
+}
 
-    // Trajectory reference point
-    pbio_trajectory_reference_t ref;
+static void pbio_servo_update_control(pbio_servo_t *srv, uint32_t time_now, pbio_servo_update_t *update) {
 
-    // Control action to be calculated
-    int32_t feedback_torque = 0;
-    int32_t feedforward_torque = 0;
+    // No control action unless a control update is needed.
+    update->feedback_torque = 0;
+    update->feedforward_torque = 0;
 
-    // Check if a control update is needed
-    if (pbio_control_is_active(&srv->control)) {
+    // The control update may stop the controller, so remember whether the
+    // resulting actuation must still be applied.
+    update->control = pbio_control_is_active(&srv->control);
+    if (!update->control) {
+        return;
+    }
 
-        // Calculate feedback control signal
-        pbio_dcmotor_actuation_t requested_actuation;
-        pbio_control_update(&srv->control, time_now, &state, &ref, &requested_actuation, &feedback_torque);
+    // Calculate feedback control signal
+    pbio_control_update(&srv->control, time_now, &update->state, &update->ref, &update->actuation, &update->feedback_torque);
+    update->active = pbio_control_is_active(&srv->control);
 
-        // Get required feedforward torque for current reference
-        feedforward_torque = pbio_observer_get_feedforward_torque(srv->observer.model, ref.speed, ref.acceleration);
+    // Get required feedforward torque for current reference
+    update->feedforward_torque = pbio_observer_get_feedforward_torque(srv->observer.model, update->ref.speed, update->ref.acceleration);
+}
 
-        // Actuate the servo. For torque control, the torque payload is passed along. Otherwise payload is ignored.
-        err = pbio_servo_actuate(srv, requested_actuation, feedback_torque + feedforward_torque);
-        if (err != PBIO_SUCCESS) {
-            return err;
-        }
+static pbio_error_t pbio_servo_update_actuate(pbio_servo_t *srv, pbio_servo_update_t *update) {
+
+    if (!update->control) {
+        return PBIO_SUCCESS;
     }
+
+    // A servo that failed earlier in this phase may have stopped this one,
+    // such as when both are part of a drive base. Then the computed
+    // actuation no longer applies.
+    if (update->active && !pbio_control_is_active(&srv->control)) {
+        return PBIO_SUCCESS;
+    }
+
+    // Actuate the servo. For torque control, the torque payload is passed along. Otherwise payload is ignored.
+    return pbio_servo_actuate(srv, update->actuation, update->feedback_torque + update->feedforward_torque);
+}
+
+static void pbio_servo_update_observer(pbio_servo_t *srv, uint32_t time_now, pbio_servo_update_t *update) {
+
     // Whether or not there is control, get the ongoing actuation state so we can log it and update observer.
     pbio_dcmotor_actuation_t applied_actuation;
     int32_t voltage;
     pbio_dcmotor_get_state(srv->dcmotor, &applied_actuation, &voltage);
 
+    pbio_control_state_t *state = &update->state;
+
     // Optionally log servo state.
     if (pbio_logger_is_active(&srv->log)) {
 
@@ -121,59 +161,95 @@ static pbio_error_t pbio_servo_update(pbio_servo_t *srv) {
             // Column 1: Current time.
             time_now,
             // Column 2: Motor angle in degrees.
-            pbio_control_settings_ctl_to_app_long(&srv->control.settings, &state.position),
+            pbio_control_settings_ctl_to_app_long(&srv->control.settings, &state->position),
             // Column 3: Motor speed in degrees/second.
-            pbio_control_settings_ctl_to_app(&srv->control.settings, state.speed),
+            pbio_control_settings_ctl_to_app(&srv->control.settings, state->speed),
             // Column 4: Actuation type (LSB 0--1), stall state (LSB 2).
             applied_actuation | (stalled << 2),
             // Column 5: Actuation voltage.
             voltage,
             // Column 6: Estimated position in degrees.
-            pbio_control_settings_ctl_to_app_long(&srv->control.settings, &state.position_estimate),
+            pbio_control_settings_ctl_to_app_long(&srv->control.settings, &state->position_estimate),
             // Column 7: Estimated speed in degrees/second.
-            pbio_control_settings_ctl_to_app(&srv->control.settings, state.speed_estimate),
+            pbio_control_settings_ctl_to_app(&srv->control.settings, state->speed_estimate),
             // Column 8: Feedback torque (uNm).
-            feedback_torque,
+            update->feedback_torque,
             // Column 9: Feedback torque (uNm).
-            feedforward_torque
+            update->feedforward_torque
         };
         pbio_logger_add_row(&srv->log, log_data);
     }
 
     // Update the state observer
-    pbio_observer_update(&srv->observer, time_now, &state.position, applied_actuation, voltage);
+    pbio_observer_update(&srv->observer, time_now, &state->position, update->edge_age, applied_actuation, voltage);
+}
 
-    return PBIO_SUCCESS;
+static void pbio_servo_update_failed(pbio_servo_t *srv) {
+    // If the update failed, don't update it anymore.
+    pbio_servo_update_loop_set_state(srv, false);
+
+    // Coast the motor, letting errors pass.
+    pbio_dcmotor_coast(srv->dcmotor);
+
+    // Stop the control state.
+    pbio_control_reset(&srv->control);
+
+    // Stop higher level controls, such as drive bases.
+    pbio_parent_stop(&srv->parent, false);
 }
 
 /**
  * Updates the servo state and controller.
  *
  * This gets called once on every control loop.
+ *
+ * All servos are updated in phases. First all angles are read, then all
+ * control signals are calculated, and then all motors are actuated. This
+ * keeps the time between the reading of each motor and between the
+ * actuation of each motor as short as possible, so that mechanisms driven
+ * by several motors behave the same regardless of the ports used.
  */
 void pbio_servo_update_all(void) {
-    pbio_error_t err;
+    static pbio_servo_update_t updates[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+    // All servos share the same sample time.
+    uint32_t time_now = pbio_control_get_time_ticks();
 
-    // Go through all motors.
+    // Read the physical and estimated state of all servos.
     for (uint8_t i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
         pbio_servo_t *srv = &servos[i];
 
         // Run update loop only if registered.
-        if (srv->run_update_loop) {
-            err = pbio_servo_update(srv);
-            if (err != PBIO_SUCCESS) {
-                // If the update failed, don't update it anymore.
-                pbio_servo_update_loop_set_state(srv, false);
+        if (!srv->run_update_loop) {
+            continue;
+        }
+        // Read the angle together with the time since it last changed.
+        if (pbio_tacho_get_angle_and_edge_age(srv->tacho, &updates[i].state.position, &updates[i].edge_age) != PBIO_SUCCESS) {
+            pbio_servo_update_failed(srv);
+            continue;
+        }
+        pbio_servo_get_state_estimate(srv, &updates[i].state);
+    }
 
-                // Coast the motor, letting errors pass.
-                pbio_dcmotor_coast(srv->dcmotor);
+    // Calculate all control signals.
+    for (uint8_t i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        if (servos[i].run_update_loop) {
+            pbio_servo_update_control(&servos[i], time_now, &updates[i]);
+        }
+    }
 
-                // Stop the control state.
-                pbio_control_reset(&srv->control);
+    // Actuate all servos.
+    for (uint8_t i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        pbio_servo_t *srv = &servos[i];
+        if (srv->run_update_loop && pbio_servo_update_actuate(srv, &updates[i]) != PBIO_SUCCESS) {
+            pbio_servo_update_failed(srv);
+        }
+    }
 
-                // Stop higher level controls, such as drive bases.
-                pbio_parent_stop(&srv->parent, false);
-            }
+    // Log and update the state observers with the applied actuation.
+    for (uint8_t i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        if (servos[i].run_update_loop) {
+            pbio_servo_update_observer(&servos[i], time_now, &updates[i]);
         }
     }
 }
@@ -259,6 +335,12 @@ pbio_error_t pbio_servo_setup(pbio_servo_t *srv, pbio_direction_t direction, int
         return err;
     }
 
+    // Use the default speed estimate.
+    err = pbio_differentiator_set_filter(&srv->observer.differentiator, PBIO_DIFFERENTIATOR_FILTER_WINDOW, PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
     // Reset observer to current angle.
     pbio_observer_reset(&srv->observer, &srv->control.settings, &angle);
 
@@ -342,9 +424,7 @@ pbio_error_t pbio_servo_get_state_control(pbio_servo_t *srv, pbio_control_state_
         return err;
     }
 
-    // Get estimated state
-    pbio_observer_get_estimated_state(&srv->observer, &state->speed, &state->position_estimate, &state->speed_estimate);
-
+    pbio_servo_get_state_estimate(srv, state);
     return PBIO_SUCCESS;
 }
 
@@ -615,6 +695,51 @@ pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, int32_t speed, int32_t angl
     return pbio_control_start_position_control_relative(&srv->control, time_now, &state, angle, speed, on_completion);
 }
 
+/**
+ * Queues a command to run the servo to a given target angle after the
+ * ongoing one completes.
+ *
+ * The queued command starts exactly when the current trajectory ends, without
+ * waiting for a new user command. This runs multi-step motions back to back.
+ * If no command is ongoing, this is the same as ::pbio_servo_run_target.
+ *
+ * @param [in]  srv            The control instance.
+ * @param [in]  speed          Top angular velocity in degrees per second. Must not be zero.
+ * @param [in]  target         Angle to run to.
+ * @param [in]  on_completion  What to do at the target angle if no other command is queued after it.
+ * @return                     ::PBIO_ERROR_BUSY if the queue is full, otherwise other error code.
+ */
+pbio_error_t pbio_servo_queue_target(pbio_servo_t *srv, int32_t speed, int32_t target, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_servo_update_loop_is_running(srv)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // A stationary segment would never end, so it can't be queued.
+    if (speed == 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Stop parent object that uses this motor, if any.
+    pbio_error_t err = pbio_parent_stop(&srv->parent, false);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Get current time
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    // Read the physical and estimated state
+    pbio_control_state_t state;
+    err = pbio_servo_get_state_control(srv, &state);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    return pbio_control_queue_position_control(&srv->control, time_now, &state, target, speed, on_completion);
+}
+
 /**
  * Steers the servo to the given target and holds it there.
  *
@@ -688,6 +813,47 @@ pbio_error_t pbio_servo_is_stalled(pbio_servo_t *srv, bool *stalled, uint32_t *s
     return PBIO_SUCCESS;
 }
 
+/**
+ * Gets how the speed of the servo is estimated from its angle.
+ *
+ * @param [in]  srv         The servo instance.
+ * @param [out] filter      The estimation method.
+ * @param [out] time_ms     Window length or response time of the filter (ms).
+ * @return                  Error code.
+ */
+pbio_error_t pbio_servo_get_speed_filter(pbio_servo_t *srv, pbio_differentiator_filter_t *filter, uint32_t *time_ms) {
+
+    // Don't allow access if update loop not registered.
+    if (!pbio_servo_update_loop_is_running(srv)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    *filter = srv->observer.differentiator.filter;
+    *time_ms = srv->observer.differentiator.time_ms;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Selects how the speed of the servo is estimated from its angle.
+ *
+ * This speed is reported to the user and is used to detect stalls. The
+ * speed used for feedback control is estimated by the observer instead.
+ *
+ * @param [in]  srv         The servo instance.
+ * @param [in]  filter      The estimation method.
+ * @param [in]  time_ms     Window length or response time of the filter (ms).
+ * @return                  Error code.
+ */
+pbio_error_t pbio_servo_set_speed_filter(pbio_servo_t *srv, pbio_differentiator_filter_t filter, uint32_t time_ms) {
+
+    // Don't allow access if update loop not registered.
+    if (!pbio_servo_update_loop_is_running(srv)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    return pbio_differentiator_set_filter(&srv->observer.differentiator, filter, time_ms);
+}
+
 /**
  * Gets estimated external load experienced by the servo.
  *
@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/config.h>
+#include <pbio/control.h>
+#include <pbio/int_math.h>
+#include <pbio/observer.h>
+#include <pbio/parent.h>
+#include <pbio/servo.h>
+#include <pbio/sysid.h>
+#include <pbio/util.h>
+
+// Regressors are scaled to this range, so that products of two of them stay
+// below 2**30, and sums of many products stay well within 64 bits.
+#define SYSID_SCALE (1 << 15)
+
+// Angle increment (mdeg) and voltage (mV) that are scaled to SYSID_SCALE.
+#define SYSID_INCREMENT_MAX (20000)
+#define SYSID_VOLTAGE_MAX (12000)
+
+// Maximum number of samples, so the sums cannot overflow.
+#define SYSID_NUM_SAMPLES_MAX (1 << 16)
+
+// Mean products are shifted right by this much before solving, so that the
+// back substitution cannot overflow.
+#define SYSID_SOLVE_SHIFT (4)
+
+/**
+ * Resets the least squares fit.
+ *
+ * @param [out] fit             The fit.
+ */
+void pbio_sysid_fit_reset(pbio_sysid_fit_t *fit) {
+    *fit = (pbio_sysid_fit_t) {0};
+}
+
+/**
+ * Adds a sample to the fit.
+ *
+ * All arguments are sums over ::PBIO_SYSID_WINDOW iterations, where the
+ * window of @p voltage_sum and @p angle_change_next is one iteration later
+ * than that of @p angle_change and @p direction_sum.
+ *
+ * @param [in]  fit                 The fit.
+ * @param [in]  angle_change        Angle change during the earlier window (mdeg).
+ * @param [in]  voltage_sum         Sum of voltages applied during the later window (mV).
+ * @param [in]  direction_sum       Sum of signs of increments during the earlier window.
+ * @param [in]  angle_change_next   Angle change during the later window (mdeg).
+ */
+void pbio_sysid_fit_add(pbio_sysid_fit_t *fit, int32_t angle_change, int32_t voltage_sum, int32_t direction_sum, int32_t angle_change_next) {
+
+    if (fit->num_samples >= SYSID_NUM_SAMPLES_MAX) {
+        return;
+    }
+
+    const int32_t angle_max = SYSID_INCREMENT_MAX * PBIO_SYSID_WINDOW;
+    const int32_t voltage_max = SYSID_VOLTAGE_MAX * PBIO_SYSID_WINDOW;
+
+    // Scaled regressors and target.
+    int32_t x[PBIO_SYSID_NUM_PARAMETERS] = {
+        (int64_t)pbio_int_math_clamp(angle_change, angle_max) * SYSID_SCALE / angle_max,
+        (int64_t)pbio_int_math_clamp(voltage_sum, voltage_max) * SYSID_SCALE / voltage_max,
+        pbio_int_math_clamp(direction_sum, PBIO_SYSID_WINDOW) * SYSID_SCALE / PBIO_SYSID_WINDOW,
+    };
+    int32_t y = (int64_t)pbio_int_math_clamp(angle_change_next, angle_max) * SYSID_SCALE / angle_max;
+
+    for (uint8_t i = 0; i < PBIO_SYSID_NUM_PARAMETERS; i++) {
+        for (uint8_t j = 0; j < PBIO_SYSID_NUM_PARAMETERS; j++) {
+            fit->normal[i][j] += (int64_t)x[i] * x[j];
+        }
+        fit->target[i] += (int64_t)x[i] * y;
+    }
+    fit->num_samples++;
+}
+
+/**
+ * Solves the fit for the parameters of the first order model.
+ *
+ * This solves the normal equations by Gaussian elimination. They are
+ * symmetric and positive definite unless the samples are degenerate, so no
+ * pivoting is needed.
+ *
+ * @param [in]  fit             The fit.
+ * @param [out] alpha           Speed decay per step, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @param [out] beta            Angle increment per mV, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @param [out] gamma           Friction in mdeg per step, scaled by ::PBIO_OBSERVER_FIRST_ORDER_ONE.
+ * @return                      ::PBIO_SUCCESS on success, or
+ *                              ::PBIO_ERROR_FAILED if the samples don't
+ *                              determine the parameters.
+ */
+pbio_error_t pbio_sysid_fit_solve(pbio_sysid_fit_t *fit, int64_t *alpha, int64_t *beta, int64_t *gamma) {
+
+    const uint8_t n = PBIO_SYSID_NUM_PARAMETERS;
+
+    if (fit->num_samples < n) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // Mean products are at most 2**30. They are reduced to 2**26, so that
+    // the back substitution below can multiply them by parameters up to
+    // 4 * PBIO_OBSERVER_FIRST_ORDER_ONE (2**32) and sum the products without
+    // overflow. Elimination keeps them within this bound, since the matrix
+    // is symmetric and positive definite.
+    int64_t a[PBIO_SYSID_NUM_PARAMETERS][PBIO_SYSID_NUM_PARAMETERS];
+    int64_t b[PBIO_SYSID_NUM_PARAMETERS];
+    const int64_t divisor = (int64_t)fit->num_samples << SYSID_SOLVE_SHIFT;
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++) {
+            a[i][j] = fit->normal[i][j] / divisor;
+        }
+        b[i] = fit->target[i] / divisor;
+    }
+
+    // Eliminate below the diagonal.
+    for (uint8_t j = 0; j < n; j++) {
+        if (a[j][j] <= 0) {
+            return PBIO_ERROR_FAILED;
+        }
+        for (uint8_t i = j + 1; i < n; i++) {
+            for (uint8_t k = j + 1; k < n; k++) {
+                a[i][k] -= a[i][j] * a[j][k] / a[j][j];
+            }
+            b[i] -= a[i][j] * b[j] / a[j][j];
+            a[i][j] = 0;
+        }
+    }
+
+    // Solve by back substitution. Scaled parameters are expected to be
+    // less than 1, so reject anything beyond 4. Each term is then at most
+    // 2**58, so the sum of the three stays within 64 bits.
+    int64_t x[PBIO_SYSID_NUM_PARAMETERS];
+    for (int8_t i = n - 1; i >= 0; i--) {
+        if (a[i][i] <= 0) {
+            return PBIO_ERROR_FAILED;
+        }
+        int64_t sum = b[i] * PBIO_OBSERVER_FIRST_ORDER_ONE;
+        for (uint8_t k = i + 1; k < n; k++) {
+            sum -= a[i][k] * x[k];
+        }
+        x[i] = sum / a[i][i];
+        if (x[i] > 4 * PBIO_OBSERVER_FIRST_ORDER_ONE || x[i] < -4 * PBIO_OBSERVER_FIRST_ORDER_ONE) {
+            return PBIO_ERROR_FAILED;
+        }
+    }
+
+    // Undo the scaling of the regressors.
+    *alpha = x[0];
+    *beta = x[1] * SYSID_INCREMENT_MAX / SYSID_VOLTAGE_MAX;
+    *gamma = -x[2] * SYSID_INCREMENT_MAX;
+    return PBIO_SUCCESS;
+}
+
+#if PBIO_CONFIG_SYSID
+
+// Number of control loop iterations for each level of the excitation.
+#define SYSID_SEGMENT_ITERATIONS (25)
+
+// Excitation levels, as a fraction of the amplitude (per mille). This varies
+// both the speed and the direction, so that speed, voltage, and friction
+// can be told apart.
+static const int16_t excitation[] = {
+    500, 1000, 250, 750, -250, -1000, -500, -750,
+    1000, 500, -500, -250, 750, 250, -1000, -750,
+};
+
+#define SYSID_NUM_ITERATIONS (SYSID_SEGMENT_ITERATIONS * PBIO_ARRAY_SIZE(excitation))
+
+// Identification state for each port.
+static pbio_sysid_t sysids[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+
+static pbio_sysid_t *pbio_sysid_get(pbio_servo_t *srv) {
+    return &sysids[srv->dcmotor->port - PBDRV_CONFIG_FIRST_MOTOR_PORT];
+}
+
+/**
+ * Ends the identification and releases the servo.
+ */
+static pbio_error_t pbio_sysid_finish(pbio_sysid_t *sysid, pbio_error_t status) {
+    sysid->status = status;
+    pbio_parent_set(&sysid->srv->parent, NULL, NULL);
+    return pbio_dcmotor_coast(sysid->srv->dcmotor);
+}
+
+/**
+ * Identification stop function that can be called from a servo.
+ *
+ * When a new command is issued to the servo, the identification is canceled.
+ *
+ * @param [in]  sysid           Void pointer to the identification state.
+ * @param [in]  clear_parent    Unused. The servo is always released.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_sysid_stop_from_servo(void *sysid, bool clear_parent) {
+    return pbio_sysid_finish(sysid, PBIO_ERROR_CANCELED);
+}
+
+/**
+ * Starts identifying the motor model of a servo.
+ *
+ * This applies voltage steps for about two seconds, so the motor must be
+ * able to rotate freely with its usual load. When done, the identified
+ * model is used by the observer and for feedforward until the servo is set
+ * up again.
+ *
+ * Any other command given to the servo cancels the identification.
+ *
+ * The lowest excitation level is a quarter of @p voltage, which should be
+ * well above the voltage needed to overcome friction.
+ *
+ * @param [in]  srv         The servo instance.
+ * @param [in]  voltage     Largest voltage applied to the motor in mV.
+ * @return                  Error code.
+ */
+pbio_error_t pbio_sysid_start(pbio_servo_t *srv, int32_t voltage) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_servo_update_loop_is_running(srv)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // The model is discretized with the base loop time, so it must be
+    // identified at the same time step.
+    if (pbio_control_settings_get_loop_time() != PBIO_CONFIG_CONTROL_LOOP_TIME_MS) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    if (voltage <= 0 || voltage > SYSID_VOLTAGE_MAX) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Stop the servo and anything using it, such as a drive base.
+    pbio_error_t err = pbio_servo_stop(srv, PBIO_CONTROL_ON_COMPLETION_COAST);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    if (pbio_parent_exists(&srv->parent)) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    pbio_sysid_t *sysid = pbio_sysid_get(srv);
+    sysid->srv = srv;
+    sysid->voltage = voltage;
+    sysid->count = 0;
+    sysid->voltage_applied = 0;
+    pbio_sysid_fit_reset(&sysid->fit);
+    err = pbio_tacho_get_angle(srv->tacho, &sysid->angle);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Claim the servo, so new commands cancel the identification.
+    sysid->status = PBIO_ERROR_AGAIN;
+    pbio_parent_set(&srv->parent, sysid, pbio_sysid_stop_from_servo);
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Gets the status of the identification of a servo.
+ *
+ * @param [in]  srv         The servo instance.
+ * @return                  ::PBIO_ERROR_AGAIN while running, ::PBIO_SUCCESS
+ *                          if the identified model is installed, or the
+ *                          error that ended the identification.
+ */
+pbio_error_t pbio_sysid_get_status(pbio_servo_t *srv) {
+    pbio_sysid_t *sysid = pbio_sysid_get(srv);
+    if (sysid->srv != srv) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+    return sysid->status;
+}
+
+static pbio_error_t pbio_sysid_update(pbio_sysid_t *sysid) {
+
+    pbio_servo_t *srv = sysid->srv;
+
+    // Get the angle increment due to the previously applied voltage.
+    pbio_angle_t angle;
+    pbio_error_t err = pbio_tacho_get_angle(srv->tacho, &angle);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    int32_t increment = pbio_angle_diff_mdeg(&angle, &sysid->angle);
+    sysid->angle = angle;
+
+    // Store the increment along with the voltage that caused it.
+    const uint32_t size = PBIO_ARRAY_SIZE(sysid->increments);
+    sysid->increments[sysid->count % size] = increment;
+    sysid->voltages[sysid->count % size] = sysid->voltage_applied;
+
+    // Once the buffer is full, add the sums over the two windows.
+    if (sysid->count >= PBIO_SYSID_WINDOW) {
+        int32_t angle_change = 0;
+        int32_t angle_change_next = 0;
+        int32_t voltage_sum = 0;
+        int32_t direction_sum = 0;
+        for (uint32_t i = 0; i < PBIO_SYSID_WINDOW; i++) {
+            uint32_t earlier = (sysid->count + 1 + i) % size;
+            uint32_t later = (sysid->count + 2 + i) % size;
+            angle_change += sysid->increments[earlier];
+            direction_sum += pbio_int_math_sign(sysid->increments[earlier]);
+            angle_change_next += sysid->increments[later];
+            voltage_sum += sysid->voltages[later];
+        }
+        pbio_sysid_fit_add(&sysid->fit, angle_change, voltage_sum, direction_sum, angle_change_next);
+    }
+
+    // When done, fit the model and install it.
+    if (sysid->count == SYSID_NUM_ITERATIONS) {
+        int64_t alpha, beta, gamma;
+        err = pbio_sysid_fit_solve(&sysid->fit, &alpha, &beta, &gamma);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        pbio_observer_model_t model;
+        err = pbio_observer_model_from_first_order(&model, srv->observer.model, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, alpha, beta, gamma);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        sysid->model = model;
+        srv->observer.model = &sysid->model;
+        return pbio_sysid_finish(sysid, PBIO_SUCCESS);
+    }
+
+    // Apply the next excitation level.
+    sysid->voltage_applied = sysid->voltage * excitation[sysid->count / SYSID_SEGMENT_ITERATIONS] / 1000;
+    sysid->count++;
+    return pbio_servo_actuate(srv, PBIO_DCMOTOR_ACTUATION_VOLTAGE, sysid->voltage_applied);
+}
+
+/**
+ * Updates all ongoing identifications.
+ *
+ * This runs after the servo update, so it overrides its actuation.
+ */
+void pbio_sysid_update_all(void) {
+    for (uint8_t i = 0; i < PBDRV_CONFIG_NUM_MOTOR_CONTROLLER; i++) {
+        pbio_sysid_t *sysid = &sysids[i];
+
+        if (sysid->status != PBIO_ERROR_AGAIN) {
+            continue;
+        }
+
+        // Stop if the servo was unplugged or updates fail.
+        if (!pbio_servo_update_loop_is_running(sysid->srv)) {
+            pbio_sysid_finish(sysid, PBIO_ERROR_NO_DEV);
+            continue;
+        }
+        pbio_error_t err = pbio_sysid_update(sysid);
+        if (err != PBIO_SUCCESS) {
+            pbio_sysid_finish(sysid, err);
+        }
+    }
+}
+
+#endif // PBIO_CONFIG_SYSID
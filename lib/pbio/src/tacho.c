@@ -7,9 +7,11 @@
 
 #include <inttypes.h>
 
+#include <pbdrv/clock.h>
 #include <pbdrv/counter.h>
 
 #include <pbio/angle.h>
+#include <pbio/differentiator.h>
 #include <pbio/int_math.h>
 #include <pbio/port.h>
 #include <pbio/tacho.h>
@@ -78,6 +80,53 @@ pbio_error_t pbio_tacho_get_angle(pbio_tacho_t *tacho, pbio_angle_t *angle) {
     return PBIO_SUCCESS;
 }
 
+/**
+ * Gets the tacho angle along with the time since it last changed.
+ *
+ * The edge time is read before and after the angle, so that the age belongs
+ * to the edge that the angle includes. If an edge arrives in between, the
+ * angle is read again.
+ *
+ * @param [in]  tacho       The tacho instance.
+ * @param [out] angle       Angle in millidegrees.
+ * @param [out] age         Time since the most recent encoder edge in us, or
+ *                          ::PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN if the
+ *                          counter does not record edge times or edges keep
+ *                          arriving while reading.
+ * @return                  Error code.
+ */
+pbio_error_t pbio_tacho_get_angle_and_edge_age(pbio_tacho_t *tacho, pbio_angle_t *angle, uint32_t *age) {
+
+    *age = PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN;
+
+    // Not all counters record when the angle last changed.
+    uint32_t edge_time;
+    if (pbdrv_counter_get_edge_time(tacho->counter, &edge_time) != PBIO_SUCCESS) {
+        return pbio_tacho_get_angle(tacho, angle);
+    }
+
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        pbio_error_t err = pbio_tacho_get_angle(tacho, angle);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+
+        uint32_t edge_time_after;
+        err = pbdrv_counter_get_edge_time(tacho->counter, &edge_time_after);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+        if (edge_time_after == edge_time) {
+            *age = pbdrv_clock_get_us() - edge_time;
+            return PBIO_SUCCESS;
+        }
+        edge_time = edge_time_after;
+    }
+
+    // Edges arrive so fast that the edge time isn't needed for the speed.
+    return PBIO_SUCCESS;
+}
+
 /**
  * Resets the tacho angle to a given value.
  *
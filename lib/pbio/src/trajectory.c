@@ -77,6 +77,24 @@ static int32_t to_trajectory_accel(int32_t control_accel) {
     return pbio_int_math_bind(control_accel / 1000, ACCELERATION_MIN, ACCELERATION_MAX);
 }
 
+/**
+ * Gets the acceleration used to compute the ramps of a trajectory. For
+ * S-curves, this is the average acceleration, chosen such that the peak
+ * acceleration equals the given value.
+ */
+static int32_t to_trajectory_ramp_accel(int32_t control_accel, pbio_trajectory_profile_t profile) {
+    if (profile == PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+        control_accel = control_accel / 3 * 2;
+    }
+    return to_trajectory_accel(control_accel);
+}
+
+/**
+ * S-curve ramps are evaluated using fractions of the ramp duration, where
+ * this value represents the full duration.
+ */
+#define S_CURVE_ONE ((int64_t)1 << 30)
+
 /**
  * Time is unsigned everywhere except in the trajectory module.
  */
@@ -202,6 +220,45 @@ static int32_t mul_a_by_t2(int32_t a, int32_t t) {
     return mul_w_by_t(mul_a_by_t(a, t), t) / 2;
 }
 
+// Evaluates an S-curve ramp from start speed to end speed (ddeg/s) with
+// given duration (s e-4) at a time (s e-4) since the start of the ramp. The
+// speed follows 3s^2 - 2s^3, where s is the fraction of the duration, so the
+// acceleration is zero at both ends. The angle (mdeg) and average speed are
+// the same as for a ramp with constant acceleration.
+static void get_s_curve_reference(int32_t w_start, int32_t w_end, int32_t duration, int32_t time, int32_t *th, int32_t *w, int32_t *a) {
+
+    assert_accel_time(duration);
+    assert(time >= 0 && time <= duration);
+
+    int32_t dw = w_end - w_start;
+    assert_speed_rel(dw);
+
+    // Ramps achieved in zero time have no shape.
+    if (duration == 0) {
+        *th = 0;
+        *w = w_end;
+        *a = 0;
+        return;
+    }
+
+    // Get the fraction of the ramp that has passed and its powers. These use
+    // 64-bit intermediates because long ramps need a fine resolution to get
+    // a smooth position. All fractions are at most S_CURVE_ONE.
+    int64_t s = ((int64_t)time * S_CURVE_ONE) / duration;
+    int64_t s2 = s * s / S_CURVE_ONE;
+    int64_t s3 = s2 * s / S_CURVE_ONE;
+    int64_t s4 = s3 * s / S_CURVE_ONE;
+
+    // Speed is w_start + dw * (3s^2 - 2s^3).
+    *w = w_start + (int32_t)(dw * (3 * s2 - 2 * s3) / S_CURVE_ONE);
+
+    // Angle is the integral of speed: w_start * t + dw * T * (s^3 - s^4 / 2).
+    *th = mul_w_by_t(w_start, time) + (int32_t)(mul_w_by_t(dw, duration) * (s3 - s4 / 2) / S_CURVE_ONE);
+
+    // Acceleration is the derivative of speed: 6 * dw / T * (s - s^2).
+    *a = (int32_t)(div_w_by_t(dw, duration) * 6 * (s - s2) / S_CURVE_ONE);
+}
+
 // Gets starting speed (ddeg/s) to reach end speed (ddeg/s) within given
 // angle (mdeg) and acceleration (deg/s^2). Inverse of div_w2_by_a.
 static int32_t bind_w0(int32_t w_end, int32_t a, int32_t th) {
@@ -249,6 +306,7 @@ static pbio_error_t pbio_trajectory_new_forward_time_command(pbio_trajectory_t *
 
     // Fill out starting point based on user command.
     pbio_trajectory_set_start(&trj->start, c);
+    trj->profile = c->profile;
 
     // Save duration.
     trj->t3 = TO_TRAJECTORY_TIME(c->duration);
@@ -257,8 +315,8 @@ static pbio_error_t pbio_trajectory_new_forward_time_command(pbio_trajectory_t *
     trj->w3 = c->continue_running ? to_trajectory_speed(c->speed_target) : 0;
     trj->w0 = to_trajectory_speed(c->speed_start);
     int32_t wt = to_trajectory_speed(c->speed_target);
-    int32_t accel = to_trajectory_accel(c->acceleration);
-    int32_t decel = to_trajectory_accel(c->deceleration);
+    int32_t accel = to_trajectory_ramp_accel(c->acceleration, c->profile);
+    int32_t decel = to_trajectory_ramp_accel(c->deceleration, c->profile);
 
     // Return error if approximate angle too long.
     if (mul_w_by_t(wt, trj->t3) > ANGLE_MAX) {
@@ -358,6 +416,7 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
 
     // Fill out starting point based on user command.
     pbio_trajectory_set_start(&trj->start, c);
+    trj->profile = c->profile;
 
     // Get angle to travel.
     trj->th3 = pbio_angle_diff_mdeg((pbio_angle_t *)&c->position_end, (pbio_angle_t *)&c->position_start);
@@ -366,8 +425,8 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
     trj->w3 = c->continue_running ? to_trajectory_speed(c->speed_target) : 0;
     trj->w0 = to_trajectory_speed(c->speed_start);
     int32_t wt = to_trajectory_speed(c->speed_target);
-    int32_t accel = to_trajectory_accel(c->acceleration);
-    int32_t decel = to_trajectory_accel(c->deceleration);
+    int32_t accel = to_trajectory_ramp_accel(c->acceleration, c->profile);
+    int32_t decel = to_trajectory_ramp_accel(c->deceleration, c->profile);
 
     // Bind initial speed to make solution feasible. Do the larger-than check
     // using quadratic terms to avoid square root evaluations in most cases.
@@ -501,6 +560,9 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
 
 void pbio_trajectory_stretch(pbio_trajectory_t *trj, pbio_trajectory_t *leader) {
 
+    // Previously evaluated points are no longer valid.
+    trj->cache.valid = false;
+
     // Synchronize timestamps with leading trajectory.
     trj->t1 = leader->t1;
     trj->t2 = leader->t2;
@@ -534,8 +596,43 @@ void pbio_trajectory_stretch(pbio_trajectory_t *trj, pbio_trajectory_t *leader)
     trj->th2 = trj->th1 + mul_w_by_t(trj->w1, trj->t2 - trj->t1);
 }
 
+/**
+ * Stretches trajectories that start at the same time, so that all of them
+ * take as long as the longest one.
+ *
+ * If none of them start or end with a nonzero speed, they all progress
+ * proportionally, so the combined motion is a straight line in joint space.
+ *
+ * @param [in]  trajectories      The trajectories.
+ * @param [in]  num_trajectories  Number of trajectories.
+ */
+void pbio_trajectory_synchronize(pbio_trajectory_t **trajectories, uint8_t num_trajectories) {
+
+    if (num_trajectories == 0) {
+        return;
+    }
+
+    // Find the trajectory that takes the longest, so it takes the lead.
+    pbio_trajectory_t *leader = trajectories[0];
+    for (uint8_t i = 1; i < num_trajectories; i++) {
+        if (pbio_trajectory_get_duration(trajectories[i]) > pbio_trajectory_get_duration(leader)) {
+            leader = trajectories[i];
+        }
+    }
+
+    // Revise all others so they take as long as the leader.
+    for (uint8_t i = 0; i < num_trajectories; i++) {
+        if (trajectories[i] != leader) {
+            pbio_trajectory_stretch(trajectories[i], leader);
+        }
+    }
+}
+
 pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command) {
 
+    // Previously evaluated points are no longer valid.
+    trj->cache.valid = false;
+
     // Copy the command so we can modify it.
     pbio_trajectory_command_t c = *command;
 
@@ -574,6 +671,9 @@ pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio
 
 pbio_error_t pbio_trajectory_new_angle_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command) {
 
+    // Previously evaluated points are no longer valid.
+    trj->cache.valid = false;
+
     // Copy the command so we can modify it.
     pbio_trajectory_command_t c = *command;
 
@@ -675,66 +775,211 @@ uint32_t pbio_trajectory_get_duration(pbio_trajectory_t *trj) {
     return TO_CONTROL_TIME(trj->t3);
 }
 
-// Evaluate the reference speed and velocity at the (shifted) time
-void pbio_trajectory_get_reference(pbio_trajectory_t *trj, uint32_t time_ref, pbio_trajectory_reference_t *ref) {
+/**
+ * Cached angles are stored with this many fractional parts per mdeg. This
+ * makes the angle along a ramp an integer polynomial of the time (s e-4),
+ * since (w * t / 100 + a * t^2 / 200000) * 200000 = 2000 * w * t + a * t^2.
+ */
+#define CACHE_TH_DIV (200000)
 
-    // Time within maneuver since start.
-    int32_t time = TO_TRAJECTORY_TIME(time_ref - trj->start.time);
-    assert_time(time);
+/**
+ * The speed change along a ramp is stored with this many fractional parts per
+ * ddeg/s, since a * t / 1000 is the change in speed. Like elsewhere in this
+ * module, the change is rounded towards zero.
+ */
+#define CACHE_W_DIV (1000)
+
+/**
+ * Increments are only precomputed for time steps up to this value (s e-4),
+ * which keeps them within numerical bounds. This is well above the control
+ * loop time.
+ */
+#define CACHE_TIME_STEP_MAX (1000)
+
+// Splits value into quotient and remainder, rounding the quotient down so
+// that the remainder is always positive.
+static void divmod(int64_t value, int32_t div, int32_t *quotient, int32_t *remainder) {
+    int64_t q = value / div;
+    int64_t r = value % div;
+    if (r < 0) {
+        q--;
+        r += div;
+    }
+    *quotient = q;
+    *remainder = r;
+}
+
+// Adds quotient and remainder to another, carrying the remainder over.
+static void add_with_carry(int32_t *quotient, int32_t *remainder, int32_t dq, int32_t dr, int32_t div) {
+    *quotient += dq;
+    *remainder += dr;
+    if (*remainder >= div) {
+        *remainder -= div;
+        *quotient += 1;
+    }
+}
+
+// Evaluates the trajectory exactly at the given time (s e-4), and stores the
+// result in the cache along with increments for advancing it by time_step.
+static void pbio_trajectory_cache_sync(pbio_trajectory_t *trj, int32_t time, int32_t time_step) {
+
+    pbio_trajectory_cache_t *cache = &trj->cache;
 
-    // Get angle, speed, and acceleration along reference
-    int32_t th, w, a;
+    // Starting point of the phase (time, angle, speed), and its acceleration.
+    int32_t t0, th0, w0, w_end, a;
+    bool s_curve = false;
+    bool rebase = false;
 
     if (time - trj->t1 < 0 || (trj->t1 == 0 && time == 0)) {
         // If we are here, then we are still in the acceleration phase.
-        // Includes conversion from microseconds to seconds, in two steps to
-        // avoid overflows and round off errors
-        w = trj->w0 + mul_a_by_t(trj->a0, time);
-        th = mul_w_by_t(trj->w0, time) + mul_a_by_t2(trj->a0, time);
+        t0 = 0;
+        th0 = 0;
+        w0 = trj->w0;
+        w_end = trj->w1;
         a = trj->a0;
+        cache->time_end = trj->t1;
+        s_curve = trj->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE;
     } else if (time - trj->t2 < 0) {
         // If we are here, then we are in the constant speed phase
-        w = trj->w1;
-        th = trj->th1 + mul_w_by_t(trj->w1, time - trj->t1);
+        t0 = trj->t1;
+        th0 = trj->th1;
+        w0 = trj->w1;
+        w_end = trj->w1;
         a = 0;
+        cache->time_end = trj->t2;
     } else if (time - trj->t3 < 0) {
         // If we are here, then we are in the deceleration phase
-        w = trj->w1 + mul_a_by_t(trj->a2, time - trj->t2);
-        th = trj->th2 + mul_w_by_t(trj->w1, time - trj->t2) + mul_a_by_t2(trj->a2, time - trj->t2);
+        t0 = trj->t2;
+        th0 = trj->th2;
+        w0 = trj->w1;
+        w_end = trj->w3;
         a = trj->a2;
+        cache->time_end = trj->t3;
+        s_curve = trj->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE;
     } else {
         // If we are here, we are in the constant speed phase after the
-        // maneuver completes
-        w = trj->w3;
-        th = trj->th3 + mul_w_by_t(trj->w3, time - trj->t3);
+        // maneuver completes. It is rebased below after a long time.
+        t0 = trj->t3;
+        th0 = trj->th3;
+        w0 = trj->w3;
+        w_end = trj->w3;
         a = 0;
+        cache->time_end = PBIO_TRAJECTORY_DURATION_FOREVER_MS * PBIO_TRAJECTORY_TICKS_PER_MS + 1;
+        rebase = time - cache->time_end >= 0;
+    }
 
-        // To avoid any overflows of the aforementioned time comparisons,
-        // rebase the trajectory if it has been running a long time.
-        if (time > PBIO_TRAJECTORY_DURATION_FOREVER_MS * PBIO_TRAJECTORY_TICKS_PER_MS) {
-            pbio_angle_t start = trj->start.position;
-            pbio_angle_add_mdeg(&start, th);
-
-            pbio_trajectory_command_t command = {
-                .time_start = time_ref,
-                .speed_target = to_control_speed(trj->w3),
-                .continue_running = true,
-                .position_start = start,
-            };
-            pbio_trajectory_make_constant(trj, &command);
-
-            // w, and a are already set above. Time and angle are 0, since this
-            // is the start of the new maneuver with its new starting point.
-            time = 0;
-            th = 0;
-        }
+    // Time since start of this phase.
+    int32_t t = time - t0;
+    assert_time(t);
+
+    cache->valid = true;
+    cache->time = time;
+    cache->time_step = 0;
+
+    if (s_curve) {
+        // S-curve ramps are always evaluated exactly, without increments.
+        get_s_curve_reference(w0, w_end, cache->time_end - t0, t, &cache->th, &cache->w, &cache->a);
+        cache->th += th0;
+        return;
     }
 
-    // Assert that results are bounded
+    if (a != 0) {
+        assert_accel_small(a);
+        assert_accel_time(t);
+    }
+
+    // Get angle and speed along the phase, including their remainders.
+    divmod((int64_t)2000 * w0 * t + (int64_t)a * t * t, CACHE_TH_DIV, &cache->th, &cache->th_rem);
+    divmod((int64_t)pbio_int_math_abs(a) * t, CACHE_W_DIV, &cache->w, &cache->w_rem);
+    cache->w = w0 + pbio_int_math_sign(a) * cache->w;
+    cache->th += th0;
+    cache->a = a;
+
+    // To avoid any overflows of the aforementioned time comparisons,
+    // rebase the trajectory if it has been running a long time.
+    if (rebase) {
+        pbio_angle_t start = trj->start.position;
+        pbio_angle_add_mdeg(&start, cache->th);
+
+        pbio_trajectory_command_t command = {
+            .time_start = trj->start.time + TO_CONTROL_TIME(time),
+            .speed_target = to_control_speed(trj->w3),
+            .continue_running = true,
+            .position_start = start,
+        };
+        pbio_trajectory_make_constant(trj, &command);
+
+        // This is the start of the new maneuver with its new starting point.
+        pbio_trajectory_cache_sync(trj, 0, time_step);
+        return;
+    }
+
+    // Precompute increments if the next point is expected to be in this phase.
+    if (time_step > 0 && time_step <= CACHE_TIME_STEP_MAX && time + time_step - cache->time_end < 0) {
+        cache->time_step = time_step;
+        divmod((int64_t)2000 * w0 * time_step + (int64_t)a * (2 * t + time_step) * time_step, CACHE_TH_DIV, &cache->dth, &cache->dth_rem);
+        divmod((int64_t)2 * a * time_step * time_step, CACHE_TH_DIV, &cache->ddth, &cache->ddth_rem);
+        divmod((int64_t)pbio_int_math_abs(a) * time_step, CACHE_W_DIV, &cache->dw, &cache->dw_rem);
+    }
+}
+
+// Advances the cached point by one time step using additions only.
+static void pbio_trajectory_cache_advance(pbio_trajectory_cache_t *cache) {
+
+    add_with_carry(&cache->th, &cache->th_rem, cache->dth, cache->dth_rem, CACHE_TH_DIV);
+    add_with_carry(&cache->dth, &cache->dth_rem, cache->ddth, cache->ddth_rem, CACHE_TH_DIV);
+
+    // The speed changes by a magnitude in the direction of the acceleration.
+    int32_t dw = cache->dw;
+    cache->w_rem += cache->dw_rem;
+    if (cache->w_rem >= CACHE_W_DIV) {
+        cache->w_rem -= CACHE_W_DIV;
+        dw++;
+    }
+    cache->w += cache->a < 0 ? -dw : dw;
+    cache->time += cache->time_step;
+
+    // Stop advancing if the next step would be in the next phase.
+    if (cache->time + cache->time_step - cache->time_end >= 0) {
+        cache->time_step = 0;
+    }
+}
+
+/**
+ * Gets the reference point on the trajectory at the given time.
+ *
+ * The result is cached. If the next call is one constant time step later
+ * within the same phase of the trajectory, such as in a control loop, the
+ * reference is advanced without multiplications or divisions. The result is
+ * the same as when evaluating the trajectory from scratch.
+ *
+ * A long-running trajectory may be rebased to a new starting point.
+ *
+ * @param [in]  trj             The trajectory.
+ * @param [in]  time_ref        The time on the trajectory (ticks).
+ * @param [out] ref             Reference point at the given time.
+ */
+void pbio_trajectory_get_reference(pbio_trajectory_t *trj, uint32_t time_ref, pbio_trajectory_reference_t *ref) {
+
+    // Time within maneuver since start.
+    int32_t time = TO_TRAJECTORY_TIME(time_ref - trj->start.time);
     assert_time(time);
-    assert_angle(th);
-    assert_speed(w);
+
+    pbio_trajectory_cache_t *cache = &trj->cache;
+
+    if (cache->valid && cache->time_step != 0 && time - cache->time == cache->time_step) {
+        // Advance cached point by one step in the same phase.
+        pbio_trajectory_cache_advance(cache);
+    } else if (!cache->valid || time != cache->time) {
+        // Evaluate from scratch. Expect the next call after the same interval.
+        pbio_trajectory_cache_sync(trj, time, cache->valid ? time - cache->time : 0);
+    }
+
+    // Assert that results are bounded
+    assert_time(cache->time);
+    assert_angle(cache->th);
+    assert_speed(cache->w);
 
     // Convert back to absolute points by adding starting point.
-    pbio_trajectory_offset_start(ref, &trj->start, time, th, w, a);
+    pbio_trajectory_offset_start(ref, &trj->start, cache->time, cache->th, cache->w, cache->a);
 }
@@ -32,6 +32,7 @@
 #include <contiki.h>
 #include <lego_uart.h>
 
+#include "pbdrv/clock.h"
 #include "pbdrv/config.h"
 #include "pbdrv/ioport.h"
 #include "pbdrv/uart.h"
@@ -51,7 +52,11 @@
 #define EV3_UART_TYPE_MAX           101
 #define EV3_UART_SPEED_MIN          2400
 #define EV3_UART_SPEED_LPF2         115200  // standard baud rate for Powered Up
-#define EV3_UART_SPEED_MAX          460800  // in practice 115200 is max
+#define EV3_UART_SPEED_MAX          460800  // highest rate in the protocol
+
+// First byte of a LUMP_CMD_WRITE message that selects a mode combination on
+// Powered Up devices. The lower bits give the index of the combination.
+#define EV3_UART_WRITE_COMBI_MODE   0x20
 
 #define EV3_UART_DATA_KEEP_ALIVE_TIMEOUT    100 /* msec */
 #define EV3_UART_IO_TIMEOUT                 250 /* msec */
@@ -131,7 +136,6 @@ typedef enum {
  * struct ev3_uart_port_data - Data for EV3/LPF2 UART Sensor communication
  * @iodev: The I/O device state information struct
  * @pt: Protothread for main communication protocol
- * @data_pt: Protothread for receiving sensor data
  * @speed_pt: Protothread for setting the baud rate
  * @timer: Timer for sending keepalive messages and other delays.
  * @uart: Pointer to the UART device to use for communications
@@ -149,6 +153,7 @@ typedef enum {
  * @tx_msg: Buffer to hold messages transmitted to the device
  * @rx_msg: Buffer to hold messages received from the device
  * @rx_msg_size: Size of the current message being received
+ * @rx_msg_pos: Number of bytes in rx_msg while receiving data messages
  * @ext_mode: Extra mode adder for Powered Up devices (for modes > LUMP_MAX_MODE)
  * @write_cmd_size: The size parameter received from a WRITE command
  * @last_err: data->msg to be printed in case of an error.
@@ -160,11 +165,16 @@ typedef enum {
  * @mode_change_tx_done: Flag to keep ev3_uart_set_mode_end() blocked until
  * mode has actually changed
  * @speed_payload: Buffer for holding baud rate change message data
+ * @combi_modes: Modes streamed together in a mode combination, in the order
+ *      of their data in DATA messages
+ * @num_combi_modes: Number of modes in @combi_modes
+ * @combi_size: Payload size of DATA messages of the mode combination
+ * @combi_active: Flag that indicates that the mode combination was sent to
+ *      the device, so DATA messages of its first mode are combined data
  */
 typedef struct {
     pbio_iodev_t iodev;
     struct pt pt;
-    struct pt data_pt;
     struct pt speed_pt;
     struct etimer timer;
     pbdrv_uart_dev_t *uart;
@@ -179,6 +189,7 @@ typedef struct {
     uint8_t *tx_msg;
     uint8_t *rx_msg;
     uint8_t rx_msg_size;
+    uint8_t rx_msg_pos;
     uint8_t ext_mode;
     uint8_t write_cmd_size;
     DBG_ERR(const char *last_err);
@@ -188,6 +199,12 @@ typedef struct {
     bool tx_busy;
     bool mode_change_tx_done;
     uint8_t speed_payload[4];
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    uint8_t combi_modes[PBIO_IODEV_MAX_COMBI_MODES];
+    uint8_t num_combi_modes;
+    uint8_t combi_size;
+    bool combi_active;
+    #endif
 } uartdev_port_data_t;
 
 enum {
@@ -271,6 +288,85 @@ static uint8_t ev3_uart_get_msg_size(uint8_t header) {
     return size;
 }
 
+static bool ev3_uart_is_data_header(uint8_t header) {
+    uint8_t size = ev3_uart_get_msg_size(header);
+    if (size < 3 || size > EV3_UART_MAX_MESSAGE_SIZE) {
+        return false;
+    }
+
+    // Only DATA messages and a few commands are sent after the INFO phase.
+    uint8_t msg_type = header & LUMP_MSG_TYPE_MASK;
+    uint8_t cmd = header & LUMP_MSG_CMD_MASK;
+    return msg_type == LUMP_MSG_TYPE_DATA ||
+           (msg_type == LUMP_MSG_TYPE_CMD && (cmd == LUMP_CMD_WRITE || cmd == LUMP_CMD_EXT_MODE));
+}
+
+static bool pbio_uartdev_checksum_ok(uartdev_port_data_t *data, uint8_t msg_size) {
+    uint8_t checksum = 0xFF;
+    for (int i = 0; i < msg_size - 1; i++) {
+        checksum ^= data->rx_msg[i];
+    }
+    if (checksum == data->rx_msg[msg_size - 1]) {
+        return true;
+    }
+
+    // The LEGO EV3 color sensor sends bad checksums for RGB-RAW data
+    // (mode 4). The check here could be improved if someone can find a
+    // pattern.
+    return data->status == PBIO_UARTDEV_STATUS_DATA &&
+           data->type_id == PBIO_IODEV_TYPE_ID_EV3_COLOR_SENSOR &&
+           data->rx_msg[0] == (LUMP_MSG_TYPE_DATA | LUMP_MSG_SIZE_8 | 4);
+}
+
+#if PBIO_CONFIG_IODEV_MODE_DATA
+
+/**
+ * Invalidates the data of all modes, such as after changing modes.
+ */
+static void pbio_uartdev_reset_mode_data(uartdev_port_data_t *data) {
+    for (uint8_t i = 0; i < PBIO_IODEV_MAX_NUM_MODES; i++) {
+        data->iodev.mode_data[i].valid = false;
+    }
+}
+
+/**
+ * Stores the data of a DATA message with the modes it belongs to, and adds
+ * it to the history as one sample per mode.
+ */
+static void pbio_uartdev_store_mode_data(uartdev_port_data_t *data, uint8_t mode, uint8_t size) {
+    uint32_t time = pbdrv_clock_get_ms();
+    const uint8_t *payload = data->rx_msg + 1;
+
+    // Data of a mode combination is the data of each mode, one after the
+    // other. It is sent as data of the first mode. Data of that mode that
+    // doesn't have the combined size was sent before the device processed
+    // the combination, so it is dropped.
+    uint8_t num_modes = 1;
+    if (data->combi_active && mode == data->combi_modes[0]) {
+        if (size != data->combi_size) {
+            return;
+        }
+        num_modes = data->num_combi_modes;
+    }
+
+    for (uint8_t i = 0; i < num_modes; i++) {
+        if (num_modes > 1) {
+            mode = data->combi_modes[i];
+            pbio_iodev_mode_t *mode_info = &data->info->mode_info[mode];
+            size = mode_info->num_values * pbio_iodev_size_of(mode_info->data_type);
+        }
+        pbio_iodev_mode_data_t *mode_data = &data->iodev.mode_data[mode];
+        memcpy(mode_data->bin_data, payload, size);
+        mode_data->time = time;
+        mode_data->valid = true;
+        #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+        pbio_iodev_add_sample(&data->iodev, mode, payload, size, time);
+        #endif
+        payload += size;
+    }
+}
+
+#endif // PBIO_CONFIG_IODEV_MODE_DATA
 
 static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
     uint32_t speed;
@@ -293,28 +389,14 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
         mode += data->ext_mode;
     }
 
-    if (msg_size > 1) {
-        uint8_t checksum = 0xFF;
-        for (int i = 0; i < msg_size - 1; i++) {
-            checksum ^= data->rx_msg[i];
-        }
-        if (checksum != data->rx_msg[msg_size - 1]) {
-            DBG_ERR(data->last_err = "Bad checksum");
-            // if INFO messages are done and we are now receiving data, it is
-            // OK to occasionally have a bad checksum
-            if (data->status == PBIO_UARTDEV_STATUS_DATA) {
-
-                // The LEGO EV3 color sensor sends bad checksums
-                // for RGB-RAW data (mode 4). The check here could be
-                // improved if someone can find a pattern.
-                if (data->type_id != PBIO_IODEV_TYPE_ID_EV3_COLOR_SENSOR
-                    || data->rx_msg[0] != (LUMP_MSG_TYPE_DATA | LUMP_MSG_SIZE_8 | 4)) {
-                    return;
-                }
-            } else {
-                goto err;
-            }
+    if (msg_size > 1 && !pbio_uartdev_checksum_ok(data, msg_size)) {
+        DBG_ERR(data->last_err = "Bad checksum");
+        // if INFO messages are done and we are now receiving data, it is
+        // OK to occasionally have a bad checksum
+        if (data->status == PBIO_UARTDEV_STATUS_DATA) {
+            return;
         }
+        goto err;
     }
 
     switch (msg_type) {
@@ -506,7 +588,8 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
                     }
 
                     // REVISIT: this is potentially an array of combos
-                    debug_pr("mode combos: %04x\n", data->rx_msg[3] << 8 | data->rx_msg[2]);
+                    data->info->mode_combos = data->rx_msg[3] << 8 | data->rx_msg[2];
+                    debug_pr("mode combos: %04x\n", data->info->mode_combos);
 
                     break;
                 case LUMP_INFO_UNK9:
@@ -582,7 +665,13 @@ static void pbio_uartdev_parse_msg(uartdev_port_data_t *data) {
             data->iodev.mode = mode;
             if (mode == data->new_mode) {
                 memcpy(data->iodev.bin_data, data->rx_msg + 1, msg_size - 2);
+                data->iodev.time = pbdrv_clock_get_ms();
             }
+            #if PBIO_CONFIG_IODEV_MODE_DATA
+            pbio_uartdev_store_mode_data(data, mode, msg_size - 2);
+            #elif PBIO_CONFIG_IODEV_HISTORY_SIZE
+            pbio_iodev_add_sample(&data->iodev, mode, data->rx_msg + 1, msg_size - 2, pbdrv_clock_get_ms());
+            #endif
 
 
             // setting type_id in info struct lets external modules know a device is connected and receiving good data
@@ -729,7 +818,18 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     // reset state for new device
     data->info->type_id = PBIO_IODEV_TYPE_ID_NONE;
     data->info->capability_flags = PBIO_IODEV_CAPABILITY_FLAG_NONE;
+    data->info->mode_combos = 0;
     data->ext_mode = 0;
+    // a mode change that was not finished for the previous device would
+    // otherwise block all messages to the new one
+    data->mode_change_tx_done = false;
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    data->combi_active = false;
+    pbio_uartdev_reset_mode_data(data);
+    #endif
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    data->iodev.history_count = 0;
+    #endif
     data->status = PBIO_UARTDEV_STATUS_WAITING;
 
     // block until pbio_uartdev_ready() is called
@@ -737,7 +837,9 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
 
     pbdrv_uart_flush(data->uart);
 
-    // Send SPEED command at 115200 baud
+    // Send SPEED command at 115200 baud. All Powered Up devices sync at this
+    // rate. Other devices don't reply, so they sync at the slowest rate.
+    data->new_baud_rate = EV3_UART_SPEED_LPF2;
     PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, EV3_UART_SPEED_LPF2));
     debug_pr("set baud: %d\n", EV3_UART_SPEED_LPF2);
     PT_SPAWN(&data->pt, &data->speed_pt, pbio_uartdev_send_speed_msg(data, EV3_UART_SPEED_LPF2));
@@ -752,6 +854,7 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     PBIO_PT_WAIT_READY(&data->pt, err = pbdrv_uart_read_end(data->uart));
     if ((err == PBIO_SUCCESS && data->rx_msg[0] != LUMP_SYS_ACK) || err == PBIO_ERROR_TIMEDOUT) {
         // if we did not get ACK within 100ms, then switch to slow baud rate for sync
+        data->new_baud_rate = EV3_UART_SPEED_MIN;
         PBIO_PT_WAIT_READY(&data->pt, pbdrv_uart_set_baud_rate(data->uart, EV3_UART_SPEED_MIN));
         debug_pr("set baud: %d\n", EV3_UART_SPEED_MIN);
     } else if (err != PBIO_SUCCESS) {
@@ -759,6 +862,10 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
         goto err;
     }
 
+    // The device gives the baud rate it sends data at in the SPEED entry of
+    // its INFO messages, which replaces the sync rate set above. Without a
+    // SPEED entry, data is sent at the same rate as the INFO.
+
     // To get in sync with the data stream from the sensor, we look for a valid TYPE command.
     for (;;) {
         PBIO_PT_WAIT_READY(&data->pt, err = pbdrv_uart_read_begin(data->uart, data->rx_msg, 1, EV3_UART_IO_TIMEOUT));
@@ -885,8 +992,8 @@ static PT_THREAD(pbio_uartdev_update(uartdev_port_data_t * data)) {
     debug_pr("set baud: %" PRIu32 "\n", data->new_baud_rate);
 
     data->status = PBIO_UARTDEV_STATUS_DATA;
-    // reset data rx thread
-    PT_INIT(&data->data_pt);
+    // start parsing data at the next message header
+    data->rx_msg_pos = 0;
 
     // Turn on power for devices that need it
     if (data->motor_driver) {
@@ -951,58 +1058,59 @@ err:
     PT_END(&data->pt);
 }
 
-// REVISIT: This is not the greatest. We can easily get a buffer overrun and
-// loose data. For now, the retry after bad message size helps get back into
-// sync with the data stream.
-static PT_THREAD(pbio_uartdev_receive_data(uartdev_port_data_t * data)) {
-    pbio_error_t err;
-
-    PT_BEGIN(&data->data_pt);
-
-    while (true) {
-        PBIO_PT_WAIT_READY(&data->data_pt,
-            err = pbdrv_uart_read_begin(data->uart, data->rx_msg, 1, EV3_UART_IO_TIMEOUT));
-        if (err != PBIO_SUCCESS) {
-            DBG_ERR(data->last_err = "UART Rx data header begin error");
-            break;
-        }
-        PBIO_PT_WAIT_READY(&data->data_pt, err = pbdrv_uart_read_end(data->uart));
-        if (err != PBIO_SUCCESS) {
-            DBG_ERR(data->last_err = "UART Rx data header end error");
-            break;
-        }
+// Drops bytes from the start of the data message buffer, keeping the rest.
+static void pbio_uartdev_drop_bytes(uartdev_port_data_t *data, uint8_t count) {
+    data->rx_msg_pos -= count;
+    memmove(data->rx_msg, data->rx_msg + count, data->rx_msg_pos);
+}
 
-        data->rx_msg_size = ev3_uart_get_msg_size(data->rx_msg[0]);
-        if (data->rx_msg_size < 3 || data->rx_msg_size > EV3_UART_MAX_MESSAGE_SIZE) {
-            DBG_ERR(data->last_err = "Bad data message size");
+/**
+ * Parses data messages from the bytes received so far.
+ *
+ * Bytes are taken straight from the UART receive buffer as they arrive, so
+ * there is no read operation to wait for per message. Instead, messages are
+ * framed here: the header gives the size, and the message is parsed as soon
+ * as it is complete.
+ *
+ * If a byte gets lost, the checksum of the message that lost it is wrong,
+ * and the next message may have started inside it. So instead of dropping
+ * the whole message, framing resumes at the next byte that can be a header.
+ * This way, one lost byte costs one message.
+ *
+ * @param [in]  data    The port data.
+ */
+static void pbio_uartdev_receive_data(uartdev_port_data_t *data) {
+    for (;;) {
+        // Skip bytes that can't start a message.
+        if (data->rx_msg_pos && !ev3_uart_is_data_header(data->rx_msg[0])) {
+            DBG_ERR(data->last_err = "Bad data message header");
+            pbio_uartdev_drop_bytes(data, 1);
             continue;
         }
 
-        uint8_t msg_type = data->rx_msg[0] & LUMP_MSG_TYPE_MASK;
-        uint8_t cmd = data->rx_msg[0] & LUMP_MSG_CMD_MASK;
-        if (msg_type != LUMP_MSG_TYPE_DATA && (msg_type != LUMP_MSG_TYPE_CMD ||
-                                               (cmd != LUMP_CMD_WRITE && cmd != LUMP_CMD_EXT_MODE))) {
-            DBG_ERR(data->last_err = "Bad msg type");
+        // Read the header first, then the rest of the message.
+        uint8_t msg_size = data->rx_msg_pos ? ev3_uart_get_msg_size(data->rx_msg[0]) : 1;
+        if (data->rx_msg_pos < msg_size) {
+            uint8_t count;
+            pbio_error_t err = pbdrv_uart_read_stream(data->uart, data->rx_msg + data->rx_msg_pos, msg_size - data->rx_msg_pos, &count);
+            if (err != PBIO_SUCCESS || count == 0) {
+                // Wait for more data.
+                return;
+            }
+            data->rx_msg_pos += count;
             continue;
         }
 
-        PBIO_PT_WAIT_READY(&data->data_pt,
-            err = pbdrv_uart_read_begin(data->uart, data->rx_msg + 1, data->rx_msg_size - 1, EV3_UART_IO_TIMEOUT));
-        if (err != PBIO_SUCCESS) {
-            DBG_ERR(data->last_err = "UART Rx data begin error");
-            break;
-        }
-        PBIO_PT_WAIT_READY(&data->data_pt, err = pbdrv_uart_read_end(data->uart));
-        if (err != PBIO_SUCCESS) {
-            DBG_ERR(data->last_err = "UART Rx data end error");
-            break;
+        if (!pbio_uartdev_checksum_ok(data, msg_size)) {
+            DBG_ERR(data->last_err = "Bad data checksum");
+            pbio_uartdev_drop_bytes(data, 1);
+            continue;
         }
 
         // at this point, we have a full data->msg that can be parsed
         pbio_uartdev_parse_msg(data);
+        pbio_uartdev_drop_bytes(data, msg_size);
     }
-
-    PT_END(&data->data_pt);
 }
 
 static pbio_error_t ev3_uart_set_mode_begin(pbio_iodev_t *iodev, uint8_t mode) {
@@ -1018,6 +1126,12 @@ static pbio_error_t ev3_uart_set_mode_begin(pbio_iodev_t *iodev, uint8_t mode) {
     port_data->new_mode = mode;
     port_data->mode_change_tx_done = false;
 
+    // Selecting a single mode ends any mode combination.
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    port_data->combi_active = false;
+    pbio_uartdev_reset_mode_data(port_data);
+    #endif
+
     return PBIO_SUCCESS;
 }
 
@@ -1088,6 +1202,60 @@ static void ev3_uart_write_cancel(pbio_iodev_t *iodev) {
     pbdrv_uart_write_cancel(port_data->uart);
 }
 
+#if PBIO_CONFIG_IODEV_MODE_DATA
+static pbio_error_t ev3_uart_set_combi_mode_begin(pbio_iodev_t *iodev, const uint8_t *modes, uint8_t num_modes) {
+    uartdev_port_data_t *port_data = PBIO_CONTAINER_OF(iodev, uartdev_port_data_t, iodev);
+    uint8_t payload[LUMP_MAX_MSG_SIZE];
+    uint8_t len = 0;
+    uint8_t size = 0;
+    pbio_error_t err;
+
+    // The first byte selects the mode combination. It is followed by one byte
+    // for each value of each mode, giving the mode and the index of the value.
+    payload[len++] = EV3_UART_WRITE_COMBI_MODE;
+    for (uint8_t i = 0; i < num_modes; i++) {
+        pbio_iodev_mode_t *mode_info = &port_data->info->mode_info[modes[i]];
+        size += mode_info->num_values * pbio_iodev_size_of(mode_info->data_type);
+        if (size > LUMP_MAX_MSG_SIZE || len + mode_info->num_values > LUMP_MAX_MSG_SIZE) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+        for (uint8_t j = 0; j < mode_info->num_values; j++) {
+            payload[len++] = modes[i] << 4 | j;
+        }
+    }
+
+    err = ev3_uart_begin_tx_msg(port_data, LUMP_MSG_TYPE_CMD, LUMP_CMD_WRITE, payload, len);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    memcpy(port_data->combi_modes, modes, num_modes);
+    port_data->num_combi_modes = num_modes;
+    port_data->combi_active = false;
+    pbio_uartdev_reset_mode_data(port_data);
+
+    // Messages can only have payloads that are a power of 2 in size.
+    for (port_data->combi_size = 1; port_data->combi_size < size; port_data->combi_size <<= 1) {
+    }
+
+    return PBIO_SUCCESS;
+}
+
+static pbio_error_t ev3_uart_set_combi_mode_end(pbio_iodev_t *iodev) {
+    uartdev_port_data_t *port_data = PBIO_CONTAINER_OF(iodev, uartdev_port_data_t, iodev);
+    pbio_error_t err;
+
+    err = ev3_uart_write_end(iodev);
+
+    // From now on, the device may send combined data.
+    if (err == PBIO_SUCCESS) {
+        port_data->combi_active = true;
+    }
+
+    return err;
+}
+#endif // PBIO_CONFIG_IODEV_MODE_DATA
+
 static const pbio_iodev_ops_t pbio_uartdev_ops = {
     .set_mode_begin = ev3_uart_set_mode_begin,
     .set_mode_end = ev3_uart_set_mode_end,
@@ -1098,6 +1266,11 @@ static const pbio_iodev_ops_t pbio_uartdev_ops = {
     .write_begin = ev3_uart_write_begin,
     .write_end = ev3_uart_write_end,
     .write_cancel = ev3_uart_write_cancel,
+    #if PBIO_CONFIG_IODEV_MODE_DATA
+    .set_combi_mode_begin = ev3_uart_set_combi_mode_begin,
+    .set_combi_mode_end = ev3_uart_set_combi_mode_end,
+    .set_combi_mode_cancel = ev3_uart_write_cancel,
+    #endif
 };
 
 static PT_THREAD(pbio_uartdev_init(struct pt *pt, uint8_t id)) {
@@ -18,6 +18,7 @@
 #include <pbdrv/bluetooth.h>
 #include <pbio/error.h>
 #include <pbio/event.h>
+#include <pbio/logger.h>
 #include <pbio/protocol.h>
 #include <pbio/util.h>
 #include <pbsys/bluetooth.h>
@@ -295,9 +296,55 @@ static PT_THREAD(pbsys_bluetooth_monitor_status(struct pt *pt)) {
     PT_END(pt);
 }
 
+#if PBIO_CONFIG_LOGGER
+
+// Log data events must fit in the same payload as the other messages.
+_Static_assert(4 + PBIO_PYBRICKS_EVENT_LOG_DATA_MAX_VALUES * 4 <= NUS_CHAR_SIZE,
+    "log data event does not fit in message payload");
+
+// Interval at which we check for new streamed log data, in ms.
+#define LOG_STREAM_POLL_INTERVAL (20)
+
+static PT_THREAD(pbsys_bluetooth_monitor_log(struct pt *pt)) {
+    static struct etimer timer;
+    static send_msg_t msg;
+    static pbio_log_t *log;
+
+    PT_BEGIN(pt);
+
+    etimer_set(&timer, LOG_STREAM_POLL_INTERVAL);
+
+    for (;;) {
+        // The control loops don't notify us about new data, so check periodically.
+        PT_WAIT_UNTIL(pt, etimer_expired(&timer));
+        etimer_restart(&timer);
+
+        // Drain everything that has been logged so far.
+        while ((log = pbio_logger_get_stream()) && pbio_logger_get_num_rows_used(log) > 0) {
+            int32_t values[PBIO_PYBRICKS_EVENT_LOG_DATA_MAX_VALUES];
+            uint32_t index;
+            uint32_t num_values = pbio_logger_read_stream(log, values, PBIO_ARRAY_SIZE(values), &index);
+
+            msg.context.size = pbio_pybricks_event_log_data(&msg.payload[0], log->num_cols, index, values, num_values);
+            msg.context.connection = PBDRV_BLUETOOTH_CONNECTION_PYBRICKS;
+            list_add(send_queue, &msg);
+            msg.is_queued = true;
+
+            PT_WAIT_WHILE(pt, msg.is_queued);
+        }
+    }
+
+    PT_END(pt);
+}
+
+#endif // PBIO_CONFIG_LOGGER
+
 PROCESS_THREAD(pbsys_bluetooth_process, ev, data) {
     static struct etimer timer;
     static struct pt status_monitor_pt;
+    #if PBIO_CONFIG_LOGGER
+    static struct pt log_monitor_pt;
+    #endif
 
     PROCESS_BEGIN();
 
@@ -359,6 +406,9 @@ PROCESS_THREAD(pbsys_bluetooth_process, ev, data) {
         pbsys_status_clear(PBIO_PYBRICKS_STATUS_BLE_ADVERTISING);
 
         PT_INIT(&status_monitor_pt);
+        #if PBIO_CONFIG_LOGGER
+        PT_INIT(&log_monitor_pt);
+        #endif
 
         while (pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_LE)
                && !pbsys_status_test(PBIO_PYBRICKS_STATUS_SHUTDOWN)) {
@@ -367,10 +417,16 @@ PROCESS_THREAD(pbsys_bluetooth_process, ev, data) {
                 // Since pbsys status events are broadcast to all processes, this
                 // will get triggered right away if there is a status change event.
                 pbsys_bluetooth_monitor_status(&status_monitor_pt);
+                #if PBIO_CONFIG_LOGGER
+                pbsys_bluetooth_monitor_log(&log_monitor_pt);
+                #endif
             } else {
                 // REVISIT: this is probably a bit inefficient since it only
                 // needs to be called once each time notifications are enabled
                 PT_INIT(&status_monitor_pt);
+                #if PBIO_CONFIG_LOGGER
+                PT_INIT(&log_monitor_pt);
+                #endif
             }
 
             if (!send_busy) {
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Micro-benchmarks for pbio on the host, such as the virtual hub.
+//
+// Absolute numbers depend on the host, but the relative cost of operations
+// shows whether a change makes a difference for the per-tick control cost.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bench.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PBIO_BENCH_UNIT "cycles"
+#else
+#define PBIO_BENCH_UNIT "ns"
+#endif
+
+/**
+ * Gets the cycle counter, or nanoseconds if there is no cycle counter.
+ */
+uint64_t pbio_bench_cycles(void) {
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    #endif
+}
+
+/**
+ * Gets a random number in the range [min, max].
+ */
+int32_t pbio_bench_random(int32_t min, int32_t max) {
+    return min + (int32_t)(((uint64_t)rand() * ((int64_t)max - min + 1)) / ((uint64_t)RAND_MAX + 1));
+}
+
+/**
+ * Prints the cost of one operation.
+ *
+ * @param [in]  name    Name of the operation.
+ * @param [in]  cycles  Cycles spent on ::PBIO_BENCH_ITERATIONS operations.
+ */
+void pbio_bench_report(const char *name, uint64_t cycles) {
+    printf("%-48s %8.2f " PBIO_BENCH_UNIT "/op\n", name, (double)cycles / PBIO_BENCH_ITERATIONS);
+}
+
+int main(int argc, char **argv) {
+    srand(0);
+    pbio_bench_int_math();
+    pbio_bench_differentiator();
+    return 0;
+}
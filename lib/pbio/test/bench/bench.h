@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#ifndef _PBIO_TEST_BENCH_H_
+#define _PBIO_TEST_BENCH_H_
+
+#include <stdint.h>
+
+// Number of times each operation is repeated.
+#define PBIO_BENCH_ITERATIONS (1 << 20)
+
+// Number of distinct inputs, cycled through to defeat constant folding.
+#define PBIO_BENCH_NUM_INPUTS (1 << 10)
+
+uint64_t pbio_bench_cycles(void);
+int32_t pbio_bench_random(int32_t min, int32_t max);
+void pbio_bench_report(const char *name, uint64_t cycles);
+
+// Benchmarks
+
+void pbio_bench_differentiator(void);
+void pbio_bench_int_math(void);
+
+#endif // _PBIO_TEST_BENCH_H_
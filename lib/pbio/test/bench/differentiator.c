@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <pbio/angle.h>
+#include <pbio/control_settings.h>
+#include <pbio/differentiator.h>
+#include <pbio/util.h>
+
+#include "bench.h"
+
+// The motion below is synthetic, not a trace recorded on a hub. The only
+// measurement error it models is whole degree encoder resolution, so there
+// is no backlash, load disturbance, sample jitter, or edge time error. The
+// results compare the estimators with each other, but real motors will be
+// noisier than this.
+
+// Number of simulated control loop iterations (20 s).
+#define NUM_SAMPLES (4000)
+
+// Largest lag that is searched for, in samples.
+#define LAG_MAX (40)
+
+// Segments of the simulation where lag and noise are evaluated.
+#define CONSTANT_FAST_START (700)
+#define SINE_START (2000)
+#define SINE_END (3000)
+#define CONSTANT_SLOW_START (3200)
+
+// True speed (mdeg/s) and measured angle of a simulated motor.
+static int32_t speeds[NUM_SAMPLES];
+static pbio_angle_t angles[NUM_SAMPLES];
+
+// Time since the measured angle last changed (us).
+static uint32_t edge_ages[NUM_SAMPLES];
+
+// Estimated speeds (mdeg/s).
+static int32_t estimates[NUM_SAMPLES];
+
+// Results are accumulated here so the operations are not optimized away.
+static volatile int32_t sink;
+
+/**
+ * Simulates an ideal motor that accelerates, runs at constant speed, follows
+ * a sine wave, and then runs slowly. Angles are measured in whole degrees,
+ * like the encoders of most motors, along with the exact time of the last
+ * edge.
+ */
+static void simulate(void) {
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+    double angle = 0;
+    int32_t measured = 0;
+    uint32_t edge_age = 0;
+    for (uint32_t k = 0; k < NUM_SAMPLES; k++) {
+        double speed;
+        if (k < 200) {
+            speed = 0;
+        } else if (k < 400) {
+            speed = 487000.0 * (k - 200) / 200;
+        } else if (k < SINE_START) {
+            speed = 487000;
+        } else if (k < SINE_END) {
+            speed = 200000 * sin(2 * M_PI * 2 * k * loop_time / 1000.0);
+        } else {
+            speed = 23000;
+        }
+        angle += speed * loop_time / 1000;
+        speeds[k] = speed;
+
+        // If the measured angle changed, find when it crossed the last edge.
+        int32_t measured_next = floor(angle / 1000) * 1000;
+        if (measured_next != measured) {
+            double edge = speed > 0 ? measured_next : measured_next + 1000;
+            edge_age = (angle - edge) / speed * 1000000;
+        } else {
+            edge_age += loop_time * 1000;
+        }
+        measured = measured_next;
+        edge_ages[k] = edge_age;
+        pbio_angle_from_low_res(&angles[k], measured / 1000, 1000);
+    }
+}
+
+/**
+ * Estimates the speed of the simulated motor and prints the lag, noise, and
+ * cost of the estimate, optionally using edge times.
+ */
+static void bench_filter(const char *name, pbio_differentiator_filter_t filter, uint32_t time_ms, bool edges) {
+
+    pbio_differentiator_t dif = {0};
+    pbio_differentiator_set_filter(&dif, filter, time_ms);
+    pbio_differentiator_reset(&dif, &angles[0]);
+    for (uint32_t k = 0; k < NUM_SAMPLES; k++) {
+        estimates[k] = pbio_differentiator_get_speed(&dif, &angles[k], edges ? edge_ages[k] : PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN);
+    }
+
+    // Find the delay at which the estimate best matches the sine wave.
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+    uint32_t lag = 0;
+    double error_min = INFINITY;
+    for (uint32_t l = 0; l <= LAG_MAX; l++) {
+        double error = 0;
+        for (uint32_t k = SINE_START; k < SINE_END; k++) {
+            double e = estimates[k] - speeds[k - l];
+            error += e * e;
+        }
+        if (error < error_min) {
+            error_min = error;
+            lag = l;
+        }
+    }
+
+    // Noise while running at constant fast and slow speeds, after settling.
+    double noise_fast = 0;
+    for (uint32_t k = CONSTANT_FAST_START; k < SINE_START; k++) {
+        double e = estimates[k] - speeds[k];
+        noise_fast += e * e;
+    }
+    double noise_slow = 0;
+    for (uint32_t k = CONSTANT_SLOW_START; k < NUM_SAMPLES; k++) {
+        double e = estimates[k] - speeds[k];
+        noise_slow += e * e;
+    }
+    printf("%-32s lag %3" PRIu32 " ms, noise %5.1f deg/s rms fast, %5.1f deg/s rms slow\n", name, lag * loop_time,
+        sqrt(noise_fast / (SINE_START - CONSTANT_FAST_START)) / 1000,
+        sqrt(noise_slow / (NUM_SAMPLES - CONSTANT_SLOW_START)) / 1000);
+
+    // Cost of one update.
+    int32_t sum = 0;
+    uint64_t start = pbio_bench_cycles();
+    for (uint32_t n = 0; n < PBIO_BENCH_ITERATIONS; n++) {
+        sum += pbio_differentiator_get_speed(&dif, &angles[n % NUM_SAMPLES], edges ? edge_ages[n % NUM_SAMPLES] : PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN);
+    }
+    pbio_bench_report(name, pbio_bench_cycles() - start);
+    sink = sum;
+}
+
+void pbio_bench_differentiator(void) {
+
+    simulate();
+
+    bench_filter("window 125 ms", PBIO_DIFFERENTIATOR_FILTER_WINDOW, 125, false);
+    bench_filter("window 50 ms", PBIO_DIFFERENTIATOR_FILTER_WINDOW, 50, false);
+    bench_filter("window 20 ms", PBIO_DIFFERENTIATOR_FILTER_WINDOW, 20, false);
+    bench_filter("alpha-beta 40 ms", PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 40, false);
+    bench_filter("alpha-beta 20 ms", PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 20, false);
+    bench_filter("alpha-beta 10 ms", PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 10, false);
+    bench_filter("window 125 ms with edges", PBIO_DIFFERENTIATOR_FILTER_WINDOW, 125, true);
+    bench_filter("alpha-beta 20 ms with edges", PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 20, true);
+}
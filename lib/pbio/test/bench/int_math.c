@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/control_settings.h>
+#include <pbio/int_math.h>
+
+#include "bench.h"
+
+// Cycles are counted on the host, which divides in hardware. This does not
+// show how the division methods compare on hubs without a divider.
+
+// Results are accumulated here so the operations are not optimized away.
+static volatile int32_t sink;
+
+static int32_t a[PBIO_BENCH_NUM_INPUTS];
+static int32_t b[PBIO_BENCH_NUM_INPUTS];
+static int32_t c[PBIO_BENCH_NUM_INPUTS];
+
+// Runs an expression for all iterations and reports the cost of one.
+#define BENCH(name, expr) do { \
+        int32_t sum = 0; \
+        uint64_t start = pbio_bench_cycles(); \
+        for (uint32_t n = 0; n < PBIO_BENCH_ITERATIONS; n++) { \
+            uint32_t i = n % PBIO_BENCH_NUM_INPUTS; \
+            sum += (expr); \
+        } \
+        pbio_bench_report(name, pbio_bench_cycles() - start); \
+        sink = sum; \
+} while (0)
+
+void pbio_bench_int_math(void) {
+
+    // Typical control values: errors in mdeg and gains in uNm/deg.
+    for (uint32_t i = 0; i < PBIO_BENCH_NUM_INPUTS; i++) {
+        a[i] = pbio_bench_random(-100000, 100000);
+        b[i] = pbio_bench_random(1, 40000);
+        c[i] = pbio_bench_random(1, 100000000);
+    }
+
+    pbio_int_math_reciprocal_t r;
+    pbio_int_math_reciprocal_init(&r, 17500);
+
+    pbio_control_settings_t s = {
+        .ctl_steps_per_app_step = 1000,
+        .pid_kp = 17500,
+        .pid_ki = 1200,
+        .actuation_max = 200000,
+    };
+
+    BENCH("baseline (sum of inputs)", a[i]);
+    BENCH("a / b", a[i] / b[i]);
+    BENCH("pbio_int_math_div_by_reciprocal", pbio_int_math_div_by_reciprocal(a[i], &r));
+    BENCH("pbio_int_math_mult_then_div", pbio_int_math_mult_then_div(a[i], 1000, 17500));
+    BENCH("pbio_int_math_mult_then_div_by_reciprocal", pbio_int_math_mult_then_div_by_reciprocal(a[i], 1000, &r));
+    BENCH("pbio_int_math_sqrt", pbio_int_math_sqrt(c[i]));
+    BENCH("pbio_int_math_atan2", pbio_int_math_atan2(a[i], b[i]));
+    BENCH("pbio_control_settings_mul_by_gain", pbio_control_settings_mul_by_gain(a[i], b[i]));
+    BENCH("pbio_control_settings_div_by_kp", pbio_control_settings_div_by_kp(&s, a[i], s.pid_kp));
+    BENCH("pbio_control_settings_mul_by_loop_time", pbio_control_settings_mul_by_loop_time(a[i]));
+    BENCH("pbio_control_settings_ctl_to_app", pbio_control_settings_ctl_to_app(&s, a[i]));
+}
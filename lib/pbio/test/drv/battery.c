@@ -6,11 +6,17 @@
 #include <pbdrv/battery.h>
 #include <pbio/error.h>
 
+static uint16_t pbio_test_battery_voltage = 7200;
+
+void pbio_test_battery_set_voltage(uint16_t voltage) {
+    pbio_test_battery_voltage = voltage;
+}
+
 void pbdrv_battery_init(void) {
 }
 
 pbio_error_t pbdrv_battery_get_voltage_now(uint16_t *value) {
-    *value = 7200;
+    *value = pbio_test_battery_voltage;
     return PBIO_SUCCESS;
 }
 
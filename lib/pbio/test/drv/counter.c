@@ -15,19 +15,29 @@
 typedef struct {
     int32_t rotations;
     int32_t millidegrees;
+    uint32_t edge_time;
 } test_private_data_t;
 
-static test_private_data_t test_private_data;
+static test_private_data_t test_private_data[PBDRV_CONFIG_COUNTER_NUM_DEV];
 
-// Functions for tests to poke counter state
+// Functions for tests to poke counter state. Unless a device is given, they
+// apply to the first one.
+
+void pbio_test_counter_set_dev_angle(uint8_t id, int32_t rotations, int32_t millidegrees) {
+    test_private_data[id].rotations = rotations;
+    test_private_data[id].millidegrees = millidegrees;
+}
 
 void pbio_test_counter_set_angle(int32_t rotations, int32_t millidegrees) {
-    test_private_data.rotations = rotations;
-    test_private_data.millidegrees = millidegrees;
+    pbio_test_counter_set_dev_angle(0, rotations, millidegrees);
 }
 
 void pbio_test_counter_set_abs_count(int32_t millidegrees) {
-    test_private_data.millidegrees = millidegrees;
+    test_private_data[0].millidegrees = millidegrees;
+}
+
+void pbio_test_counter_set_edge_time(uint32_t time_us) {
+    test_private_data[0].edge_time = time_us;
 }
 
 // Counter driver implementation
@@ -45,14 +55,23 @@ static pbio_error_t test_get_abs_angle(pbdrv_counter_dev_t *dev, int32_t *millid
     return PBIO_SUCCESS;
 }
 
+static pbio_error_t test_get_edge_time(pbdrv_counter_dev_t *dev, uint32_t *time_us) {
+    test_private_data_t *priv = dev->priv;
+    *time_us = priv->edge_time;
+    return PBIO_SUCCESS;
+}
+
 static const pbdrv_counter_funcs_t test_funcs = {
     .get_angle = test_get_angle,
     .get_abs_angle = test_get_abs_angle,
+    .get_edge_time = test_get_edge_time,
 };
 
 void pbdrv_counter_test_init(pbdrv_counter_dev_t *devs) {
-    devs[0].funcs = &test_funcs;
-    devs[0].priv = &test_private_data;
+    for (uint8_t i = 0; i < PBDRV_CONFIG_COUNTER_NUM_DEV; i++) {
+        devs[i].funcs = &test_funcs;
+        devs[i].priv = &test_private_data[i];
+    }
 }
 
 // Tests
@@ -64,12 +83,12 @@ static void test_counter_get(void *env) {
     tt_want(pbdrv_counter_get_dev(0, &dev) == PBIO_ERROR_AGAIN);
 
     // bad id
-    tt_want(pbdrv_counter_get_dev(1, &dev) == PBIO_ERROR_NO_DEV);
+    tt_want(pbdrv_counter_get_dev(PBDRV_CONFIG_COUNTER_NUM_DEV, &dev) == PBIO_ERROR_NO_DEV);
 
     // proper usage
     pbdrv_counter_init();
     tt_want(pbdrv_counter_get_dev(0, &dev) == PBIO_SUCCESS);
-    tt_want(dev->priv == &test_private_data);
+    tt_want(dev->priv == &test_private_data[0]);
 }
 
 struct testcase_t pbdrv_counter_tests[] = {
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+// Simulated motor that turns the test counters in response to the voltage
+// applied by the motor driver.
+
+#include <math.h>
+#include <stdint.h>
+
+#include <pbio/dcmotor.h>
+#include <test-pbio.h>
+
+void pbio_test_motor_step(pbio_test_motor_t *motor, uint8_t id, pbio_dcmotor_t *dcmotor) {
+
+    // Get the voltage that was applied in this step.
+    pbio_dcmotor_actuation_t actuation;
+    int32_t voltage;
+    pbio_dcmotor_get_state(dcmotor, &actuation, &voltage);
+    if (actuation != PBIO_DCMOTOR_ACTUATION_VOLTAGE) {
+        voltage = 0;
+    }
+
+    double friction = motor->increment > 0 ? PBIO_TEST_MOTOR_GAMMA : motor->increment < 0 ? -PBIO_TEST_MOTOR_GAMMA : 0;
+    motor->increment = PBIO_TEST_MOTOR_ALPHA * motor->increment + PBIO_TEST_MOTOR_BETA * voltage - friction;
+    motor->angle += motor->increment;
+
+    // Angles are measured with a resolution of one degree, like most motors.
+    int32_t measured = (int32_t)floor(motor->angle / 1000) * 1000;
+    int32_t rotations = (int32_t)floor(measured / 360000.0);
+    pbio_test_counter_set_dev_angle(id, rotations, measured - rotations * 360000);
+}
@@ -10,7 +10,7 @@
 #define PBDRV_CONFIG_BLUETOOTH_BTSTACK_HUB_KIND     0xff
 
 #define PBDRV_CONFIG_COUNTER                        (1)
-#define PBDRV_CONFIG_COUNTER_NUM_DEV                (1)
+#define PBDRV_CONFIG_COUNTER_NUM_DEV                (2)
 #define PBDRV_CONFIG_COUNTER_TEST                   (1)
 
 #define PBDRV_CONFIG_LED                            (1)
@@ -23,7 +23,7 @@
 #define PBDRV_CONFIG_IOPORT_TEST                    (1)
 
 #define PBDRV_CONFIG_MOTOR_DRIVER                   (1)
-#define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV           (1)
+#define PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV           (2)
 #define PBDRV_CONFIG_MOTOR_DRIVER_TEST              (1)
 
 #define PBDRV_CONFIG_PWM                            (1)
@@ -33,6 +33,7 @@
 #define PBDRV_CONFIG_UART                           (1)
 
 #define PBDRV_CONFIG_HAS_PORT_A                     (1)
+#define PBDRV_CONFIG_HAS_PORT_B                     (1)
 #define PBDRV_CONFIG_FIRST_MOTOR_PORT               PBIO_PORT_ID_A
-#define PBDRV_CONFIG_LAST_MOTOR_PORT                PBIO_PORT_ID_A
+#define PBDRV_CONFIG_LAST_MOTOR_PORT                PBIO_PORT_ID_B
 #define PBDRV_CONFIG_NUM_MOTOR_CONTROLLER           (2)
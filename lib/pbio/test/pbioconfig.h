@@ -1,16 +1,23 @@
 
 #define PBIO_CONFIG_BATTERY                 (1)
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MIN_MS (1)
+#define PBIO_CONFIG_CONTROL_QUEUE_SIZE      (4)
 #define PBIO_CONFIG_DCMOTOR                 (1)
 #define PBIO_CONFIG_DRIVEBASE_SPIKE         (0)
 
 #define PBIO_CONFIG_LIGHT                   (1)
 #define PBIO_CONFIG_LOGGER                  (1)
+#define PBIO_CONFIG_MOTOR_PROCESS_PROFILER  (1)
+#define PBIO_CONFIG_IODEV_HISTORY_SIZE      (16)
+#define PBIO_CONFIG_IODEV_MODE_DATA         (1)
+#define PBIO_CONFIG_MOTION_GROUP            (1)
 #define PBIO_CONFIG_LIGHT_MATRIX            (1)
 
 #define PBIO_CONFIG_SERVO                   (1)
 #define PBIO_CONFIG_SERVO_EV3_NXT           (1)
 #define PBIO_CONFIG_SERVO_PUP               (1)
 #define PBIO_CONFIG_SERVO_PUP_MOVE_HUB      (1)
+#define PBIO_CONFIG_SYSID                   (1)
 #define PBIO_CONFIG_TACHO                   (1)
 
 #define PBIO_CONFIG_UARTDEV                 (1)
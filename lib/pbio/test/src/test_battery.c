@@ -9,7 +9,7 @@
 #include <pbio/battery.h>
 #include <test-pbio.h>
 
-// pbdrv_battery_get_voltage_now() always returns this value
+// pbdrv_battery_get_voltage_now() returns this value unless changed
 #define TEST_BATTERY_VOLTAGE 7200
 
 static void test_battery_voltage_to_duty(void *env) {
@@ -36,9 +36,27 @@ static void test_battery_voltage_from_duty_pct(void *env) {
     tt_want_int_op(pbio_battery_get_voltage_from_duty_pct(-100), ==, -TEST_BATTERY_VOLTAGE);
 }
 
+static void test_battery_voltage_sag(void *env) {
+    pbio_battery_init();
+
+    // Voltage sags under heavy load.
+    pbio_test_battery_set_voltage(TEST_BATTERY_VOLTAGE - 1200);
+    for (int i = 0; i < 20; i++) {
+        pbio_battery_update();
+    }
+
+    // Motor duty cycle compensates for the sag within a few updates...
+    tt_want_int_op(pbio_battery_get_duty_from_voltage(6000), >=, PBIO_BATTERY_MAX_DUTY * 99 / 100);
+    tt_want_int_op(pbio_battery_get_duty_from_voltage(3000), >=, PBIO_BATTERY_MAX_DUTY * 49 / 100);
+
+    // ...while the average voltage reported to the user stays steady.
+    tt_want_int_op(pbio_battery_get_average_voltage(), >, TEST_BATTERY_VOLTAGE - 300);
+}
+
 struct testcase_t pbio_battery_tests[] = {
     PBIO_TEST(test_battery_voltage_to_duty),
     PBIO_TEST(test_battery_voltage_from_duty),
     PBIO_TEST(test_battery_voltage_from_duty_pct),
+    PBIO_TEST(test_battery_voltage_sag),
     END_OF_TESTCASES
 };
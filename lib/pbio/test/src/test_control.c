@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/angle.h>
+#include <pbio/control.h>
+#include <pbio/control_settings.h>
+#include <pbio/int_math.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+#include <pbio/util.h>
+
+#include <test-pbio.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Gets the distance in degrees from the start to the end of the trajectory
+// that runs last.
+static int32_t get_last_target(pbio_control_t *ctl) {
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(pbio_control_get_last_trajectory(ctl), &end);
+    pbio_angle_t zero = {0};
+    return pbio_angle_diff_mdeg(&end.position, &zero) / 1000;
+}
+
+static void test_control_queue_relative(void *env) {
+
+    static pbio_control_t ctl;
+    const pbio_observer_model_t *model;
+    tt_want_int_op(pbio_servo_load_settings(&ctl.settings, &model, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR), ==, PBIO_SUCCESS);
+    // Millidegrees per degree, as for a servo without gears.
+    ctl.settings.ctl_steps_per_app_step = 1000;
+    pbio_control_reset(&ctl);
+
+    pbio_control_state_t state = {0};
+    uint32_t time_now = 0;
+
+    // Nothing is running, so the first move starts right away.
+    tt_want(!pbio_control_queue_must_wait(&ctl, time_now));
+    tt_want_int_op(pbio_control_queue_position_control_relative(&ctl, time_now, &state, 360, 500, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_want(pbio_control_is_active(&ctl));
+    tt_want_int_op(get_last_target(&ctl), ==, 360);
+
+    // While it runs, moves are queued, each relative to where the one
+    // before it ends.
+    time_now += 100;
+    tt_want(pbio_control_queue_must_wait(&ctl, time_now));
+    for (int32_t i = 1; i <= PBIO_CONFIG_CONTROL_QUEUE_SIZE; i++) {
+        tt_want_int_op(pbio_control_queue_position_control_relative(&ctl, time_now, &state, -90, 500, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+        tt_want_int_op(get_last_target(&ctl), ==, 360 - 90 * i);
+    }
+
+    // Once the queue is full, nothing else is queued.
+    tt_want(pbio_control_queue_is_full(&ctl));
+    tt_want_int_op(pbio_control_queue_position_control_relative(&ctl, time_now, &state, 90, 500, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_BUSY);
+    tt_want_int_op(get_last_target(&ctl), ==, 360 - 90 * PBIO_CONFIG_CONTROL_QUEUE_SIZE);
+
+    // Removing the last segment makes the one before it run last.
+    tt_want_int_op(pbio_control_queue_remove_last(&ctl), ==, PBIO_SUCCESS);
+    tt_want(!pbio_control_queue_is_full(&ctl));
+    tt_want_int_op(get_last_target(&ctl), ==, 360 - 90 * (PBIO_CONFIG_CONTROL_QUEUE_SIZE - 1));
+
+    // A new command replaces everything that was queued.
+    tt_want_int_op(pbio_control_start_position_control_relative(&ctl, time_now, &state, 180, 500, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_control_queue_remove_last(&ctl), ==, PBIO_ERROR_INVALID_OP);
+}
+
+static void test_control_queue_update(void *env) {
+
+    static pbio_control_t ctl;
+    const pbio_observer_model_t *model;
+    tt_want_int_op(pbio_servo_load_settings(&ctl.settings, &model, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR), ==, PBIO_SUCCESS);
+    ctl.settings.ctl_steps_per_app_step = 1000;
+    pbio_control_reset(&ctl);
+
+    // The system follows the reference exactly, so only the transition
+    // between segments is tested.
+    pbio_control_state_t state = {0};
+    uint32_t loop_time = pbio_control_time_ms_to_ticks(pbio_control_settings_get_loop_time());
+
+    // Run one segment that keeps going at speed, and queue another after it.
+    uint32_t time_now = 0;
+    tt_want_int_op(pbio_control_queue_position_control_relative(&ctl, time_now, &state, 360, 500, PBIO_CONTROL_ON_COMPLETION_CONTINUE), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_control_queue_position_control_relative(&ctl, time_now, &state, 360, 500, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    pbio_trajectory_reference_t end_first;
+    pbio_trajectory_get_endpoint(&ctl.trajectory, &end_first);
+    pbio_trajectory_reference_t end_last;
+    pbio_trajectory_get_endpoint(pbio_control_get_last_trajectory(&ctl), &end_last);
+    tt_want_int_op(end_first.speed, ==, 500000);
+
+    // The speed may change by at most the acceleration in one loop, plus
+    // some rounding.
+    int32_t speed_step_max = pbio_int_math_max(ctl.settings.acceleration, ctl.settings.deceleration) *
+        (int32_t)pbio_control_settings_get_loop_time() / 1000 + 100;
+
+    pbio_trajectory_reference_t ref = {0};
+    pbio_dcmotor_actuation_t actuation;
+    int32_t control;
+    bool switched = false;
+    while (!pbio_control_time_is_later(time_now, end_last.time)) {
+        time_now += loop_time;
+        int32_t speed_before = ref.speed;
+        pbio_control_update(&ctl, time_now, &state, &ref, &actuation, &control);
+        state.position = ref.position;
+        state.position_estimate = ref.position;
+        state.speed = ref.speed;
+        state.speed_estimate = ref.speed;
+
+        // The second segment takes over in the loop in which the first one
+        // ends, without a jump in the speed reference.
+        tt_want_int_op(pbio_int_math_abs(ref.speed - speed_before), <=, speed_step_max);
+        if (!switched && pbio_control_time_is_later(time_now, end_first.time)) {
+            tt_want_int_op(ctl.queue_size, ==, 0);
+            tt_want_int_op(ctl.trajectory.start.time, ==, end_first.time);
+            switched = true;
+        }
+
+        // It does not complete or stop in between.
+        tt_want(pbio_control_is_active(&ctl));
+        tt_want_int_op(actuation, ==, PBIO_DCMOTOR_ACTUATION_TORQUE);
+        if (!pbio_control_time_is_later(time_now, end_last.time)) {
+            tt_want(!pbio_control_is_done(&ctl));
+        }
+    }
+    tt_want(switched);
+
+    // Once the last segment has ended, it holds at the final target.
+    time_now += loop_time;
+    pbio_control_update(&ctl, time_now, &state, &ref, &actuation, &control);
+    tt_want(pbio_control_is_done(&ctl));
+    tt_want_int_op(get_last_target(&ctl), ==, 720);
+}
+
+static void test_control_gain_schedule(void *env) {
+
+    pbio_control_settings_t s = {
+        .ctl_steps_per_app_step = 1000,
+        .actuation_max = 200000,
+        .pid_kp = 10000,
+        .pid_ki = 2000,
+        .pid_kd = 1000,
+    };
+    int32_t kp, ki, kd;
+
+    // Without schedules, the configured gains are used.
+    tt_want(!pbio_control_settings_gain_schedule_is_active(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED));
+    tt_want(!pbio_control_settings_gain_schedule_is_active(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD));
+    pbio_control_settings_get_scheduled_pid(&s, 300000, 50000, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 10000);
+    tt_want_int_op(ki, ==, 2000);
+    tt_want_int_op(kd, ==, 1000);
+
+    // Points must be sorted and there may not be too many.
+    static const pbio_int_math_point_t unsorted[] = {
+        { .x = 500, .y = 1000 },
+        { .x = 0, .y = 2000 },
+    };
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, unsorted, 2), ==, PBIO_ERROR_INVALID_ARG);
+    static const pbio_int_math_point_t many[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX + 1];
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, many, PBIO_ARRAY_SIZE(many)), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(!pbio_control_settings_gain_schedule_is_active(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED));
+
+    // Twice as stiff at standstill as at 500 deg/s and above.
+    static const pbio_int_math_point_t speed[] = {
+        { .x = 0, .y = 2000 },
+        { .x = 500, .y = 1000 },
+    };
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, speed, 2), ==, PBIO_SUCCESS);
+    tt_want(pbio_control_settings_gain_schedule_is_active(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED));
+
+    pbio_int_math_point_t points[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX];
+    tt_want_int_op(pbio_control_settings_get_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, points), ==, 2);
+    tt_want_int_op(points[1].x, ==, 500);
+    tt_want_int_op(points[1].y, ==, 1000);
+
+    // Speed is given in control units, and its sign is ignored.
+    pbio_control_settings_get_scheduled_pid(&s, 0, 0, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 20000);
+    tt_want_int_op(ki, ==, 4000);
+    tt_want_int_op(kd, ==, 2000);
+    pbio_control_settings_get_scheduled_pid(&s, -250000, 0, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 15000);
+    pbio_control_settings_get_scheduled_pid(&s, 1000000, 0, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 10000);
+
+    // Halve the gains at a load of 100 mNm. Load is given in uNm.
+    static const pbio_int_math_point_t load[] = {
+        { .x = 0, .y = 1000 },
+        { .x = 100, .y = 500 },
+    };
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD, load, 2), ==, PBIO_SUCCESS);
+    pbio_control_settings_get_scheduled_pid(&s, 1000000, -50000, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 7500);
+
+    // Factors of both schedules are multiplied.
+    pbio_control_settings_get_scheduled_pid(&s, 250000, 50000, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 11250);
+    tt_want_int_op(ki, ==, 2250);
+    tt_want_int_op(kd, ==, 1125);
+
+    // Anti-windup bounds follow the scheduled gains.
+    tt_want_int_op(pbio_control_settings_div_by_kp(&s, s.actuation_max, kp), ==, 200000 * 1000 / 11250);
+    tt_want_int_op(pbio_control_settings_div_by_ki(&s, s.actuation_max, ki), ==, 200000 * 1000 / 2250);
+    tt_want_int_op(pbio_control_settings_div_by_ki(&s, s.actuation_max, 0), ==, 0);
+
+    // Scheduled gains don't replace the reciprocals of the configured gains,
+    // so these aren't rebuilt in every control loop iteration.
+    tt_want_int_op(s.pid_kp_reciprocal.divisor, !=, kp);
+    tt_want_int_op(s.pid_ki_reciprocal.divisor, !=, ki);
+    for (int32_t speed = 0; speed < 500000; speed += 1000) {
+        pbio_control_settings_get_scheduled_pid(&s, speed, 50000, &kp, &ki, &kd);
+        tt_want_int_op(pbio_control_settings_div_by_kp(&s, s.actuation_max, kp), ==, s.actuation_max * 1000 / kp);
+        tt_want_int_op(pbio_control_settings_div_by_ki(&s, s.actuation_max, ki), ==, s.actuation_max * 1000 / ki);
+        tt_want(s.pid_kp_reciprocal.divisor == 0 || s.pid_kp_reciprocal.divisor == s.pid_kp);
+        tt_want(s.pid_ki_reciprocal.divisor == 0 || s.pid_ki_reciprocal.divisor == s.pid_ki);
+    }
+    pbio_control_settings_get_scheduled_pid(&s, 1000000, 0, &kp, &ki, &kd);
+    tt_want_int_op(pbio_control_settings_div_by_kp(&s, s.actuation_max, kp), ==, 200000 * 1000 / 10000);
+    tt_want_int_op(s.pid_kp_reciprocal.divisor, ==, 10000);
+    tt_want_int_op(pbio_control_settings_div_by_ki(&s, s.actuation_max, ki), ==, 200000 * 1000 / 2000);
+    tt_want_int_op(s.pid_ki_reciprocal.divisor, ==, 2000);
+
+    // Scheduled gains may be too large for the divisor of a reciprocal.
+    static const pbio_int_math_point_t stiff[] = {
+        { .x = 0, .y = 30000 },
+        { .x = 500, .y = 30000 },
+    };
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, stiff, 2), ==, PBIO_SUCCESS);
+    pbio_control_settings_get_scheduled_pid(&s, 0, 0, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 300000);
+    tt_want_int_op(pbio_control_settings_div_by_kp(&s, s.actuation_max, kp), ==, 200000 * 1000 / 300000);
+    tt_want_int_op(pbio_control_settings_div_by_kp(&s, -s.actuation_max, kp), ==, -200000 * 1000 / 300000);
+
+    // Giving no points stops scheduling.
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_SPEED, NULL, 0), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_control_settings_set_gain_schedule(&s, PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_LOAD, NULL, 0), ==, PBIO_SUCCESS);
+    pbio_control_settings_get_scheduled_pid(&s, 250000, 50000, &kp, &ki, &kd);
+    tt_want_int_op(kp, ==, 10000);
+}
+
+struct testcase_t pbio_control_tests[] = {
+    PBIO_TEST(test_control_gain_schedule),
+    PBIO_TEST(test_control_queue_relative),
+    PBIO_TEST(test_control_queue_update),
+    END_OF_TESTCASES
+};
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/angle.h>
+#include <pbio/control_settings.h>
+#include <pbio/differentiator.h>
+#include <pbio/util.h>
+
+#include <test-pbio.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+// Simulates a motor that turns at a constant slow speed, measured in whole
+// degrees, and returns the speed estimate after a few seconds.
+static int32_t get_speed_at_constant_speed(pbio_differentiator_t *dif, int32_t speed, bool edges) {
+
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    pbio_angle_t angle = {0};
+    pbio_differentiator_reset(dif, &angle);
+
+    int32_t estimate = 0;
+    uint32_t edge_age = 0;
+    int32_t measured = 0;
+    for (uint32_t time = loop_time; time <= 3000; time += loop_time) {
+
+        // Exact angle in mdeg, and the time of the last edge before it.
+        int32_t exact = speed * time / 1000;
+        if (exact / 1000 * 1000 != measured) {
+            measured = exact / 1000 * 1000;
+            edge_age = (int64_t)(exact - measured) * 1000000 / speed;
+        } else {
+            edge_age += loop_time * 1000;
+        }
+
+        pbio_angle_from_low_res(&angle, measured / 1000, 1000);
+        estimate = pbio_differentiator_get_speed(dif, &angle, edges ? edge_age : PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN);
+    }
+    return estimate;
+}
+
+static void test_differentiator_edges(void *env) {
+
+    pbio_differentiator_t dif = {0};
+
+    // At 23 deg/s, there are only about 3 edges in the default window, so the
+    // window estimate is off by several deg/s.
+    int32_t speed = get_speed_at_constant_speed(&dif, 23000, false);
+    tt_want_int_op(speed, !=, 23000);
+
+    // Timing the edges gives the speed almost exactly.
+    speed = get_speed_at_constant_speed(&dif, 23000, true);
+    tt_want_int_op(speed, >=, 22900);
+    tt_want_int_op(speed, <=, 23100);
+
+    // Same for the alpha-beta filter.
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 20), ==, PBIO_SUCCESS);
+    speed = get_speed_at_constant_speed(&dif, 7000, true);
+    tt_want_int_op(speed, >=, 6950);
+    tt_want_int_op(speed, <=, 7050);
+
+    // When the motor stops, the speed drops as no more edges arrive.
+    pbio_angle_t angle = dif.edge_angle;
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+    uint32_t edge_age = dif.edge_elapsed;
+    for (uint32_t time = 0; time < 1000; time += loop_time) {
+        edge_age += loop_time * 1000;
+        speed = pbio_differentiator_get_speed(&dif, &angle, edge_age);
+    }
+    tt_want_int_op(speed, >, 0);
+    tt_want_int_op(speed, <=, 1000);
+
+    // Fast motors get many edges per loop, so the filter is used instead.
+    speed = get_speed_at_constant_speed(&dif, 500000, true);
+    tt_want_int_op(speed, >=, 495000);
+    tt_want_int_op(speed, <=, 505000);
+}
+
+static void test_differentiator_edges_reversal(void *env) {
+
+    pbio_differentiator_t dif = {0};
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    // An encoder that jitters back and forth between two edges at standstill
+    // gives no speed.
+    pbio_angle_t angle = {0};
+    pbio_differentiator_reset(&dif, &angle);
+    uint32_t edge_age = 0;
+    for (uint32_t i = 1; i <= 200; i++) {
+        edge_age += loop_time * 1000;
+        if (i % 10 == 0) {
+            pbio_angle_from_low_res(&angle, (i / 10) % 2, 1000);
+            edge_age = 1000;
+        }
+        int32_t speed = pbio_differentiator_get_speed(&dif, &angle, edge_age);
+        tt_want_int_op(speed, ==, 0);
+    }
+
+    // When the motor reverses, the time since the last edge in the other
+    // direction is no speed either, so timing starts over at the first edge
+    // in the new direction.
+    int32_t speed = get_speed_at_constant_speed(&dif, 23000, true);
+    tt_want_int_op(speed, >, 0);
+    angle = dif.edge_angle;
+    edge_age = dif.edge_elapsed;
+    for (uint32_t i = 1; i <= 100; i++) {
+        edge_age += loop_time * 1000;
+        bool edge = i % 9 == 0;
+        if (edge) {
+            pbio_angle_add_mdeg(&angle, -1000);
+            edge_age = 1000;
+        }
+        speed = pbio_differentiator_get_speed(&dif, &angle, edge_age);
+        if (edge && i == 9) {
+            tt_want_int_op(speed, ==, 0);
+        }
+    }
+
+    // After that, edges in the new direction give the speed.
+    int32_t expected = -1000 * 1000 / (9 * (int32_t)loop_time);
+    tt_want_int_op(speed, >=, expected - 100);
+    tt_want_int_op(speed, <=, expected + 100);
+}
+
+static void test_differentiator_edges_after_standstill(void *env) {
+
+    pbio_differentiator_t dif = {0};
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    // The first edge sets the direction.
+    pbio_angle_t angle = {0};
+    pbio_differentiator_reset(&dif, &angle);
+    pbio_angle_add_mdeg(&angle, 1000);
+    tt_want_int_op(pbio_differentiator_get_speed(&dif, &angle, 0), ==, 0);
+
+    // Stand still for a while so the time since that edge grows.
+    uint32_t edge_age = 0;
+    for (uint32_t time = 0; time < 1000; time += loop_time) {
+        edge_age += loop_time * 1000;
+        pbio_differentiator_get_speed(&dif, &angle, edge_age);
+    }
+
+    // Then several degrees at once in the same direction give the average
+    // speed across the whole standstill.
+    int32_t interval = dif.edge_elapsed + loop_time * 1000;
+    pbio_angle_add_mdeg(&angle, 5000);
+    int32_t speed = pbio_differentiator_get_speed(&dif, &angle, 0);
+    int32_t expected = (int64_t)5000 * 1000000 / interval;
+    tt_want_int_op(expected, >, 4500);
+    tt_want_int_op(speed, ==, expected);
+}
+
+// Feeds the differentiator an angle that increases by the same amount in
+// every loop, and gets the speed estimate after each sample.
+static void get_speeds_at_constant_speed(pbio_differentiator_t *dif, int32_t speed, int32_t *estimates, uint32_t num_estimates) {
+
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    pbio_angle_t angle = {0};
+    pbio_differentiator_reset(dif, &angle);
+
+    for (uint32_t i = 0; i < num_estimates; i++) {
+        pbio_angle_add_mdeg(&angle, speed * loop_time / 1000);
+        estimates[i] = pbio_differentiator_get_speed(dif, &angle, PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN);
+    }
+}
+
+static void test_differentiator_filters(void *env) {
+
+    pbio_differentiator_t dif = {0};
+    int32_t speeds[200];
+    const uint32_t loop_time = pbio_control_settings_get_loop_time();
+
+    // Windows must fit in the buffer, and response times must be sensible.
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_WINDOW, 0), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_WINDOW, PBIO_CONFIG_DIFFERENTIATOR_WINDOW_MS + 1), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 0), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 1001), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA + 1, 20), ==, PBIO_ERROR_INVALID_ARG);
+
+    // The window average rises linearly until the window is full, and is
+    // exact after that.
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_WINDOW, 50), ==, PBIO_SUCCESS);
+    get_speeds_at_constant_speed(&dif, 100000, speeds, PBIO_ARRAY_SIZE(speeds));
+    uint32_t window = 50 / loop_time;
+    tt_want_int_op(speeds[0], ==, 100000 / window);
+    tt_want_int_op(speeds[window / 2 - 1], ==, 100000 / 2);
+    tt_want_int_op(speeds[window - 1], ==, 100000);
+    tt_want_int_op(speeds[PBIO_ARRAY_SIZE(speeds) - 1], ==, 100000);
+
+    // The alpha-beta filter first corrects the speed by beta times the
+    // angle error. With a 20 ms response time, beta is (loop / (20 + loop))**2.
+    tt_want_int_op(pbio_differentiator_set_filter(&dif, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, 20), ==, PBIO_SUCCESS);
+    get_speeds_at_constant_speed(&dif, 100000, speeds, PBIO_ARRAY_SIZE(speeds));
+    int32_t first = 100000 * loop_time * loop_time / ((20 + loop_time) * (20 + loop_time));
+    tt_want_int_op(speeds[0], >=, first - 1);
+    tt_want_int_op(speeds[0], <=, first);
+
+    // It settles like two low pass filters with a 20 ms time constant, so
+    // it is close after 80 ms, without overshooting by much.
+    int32_t settled = speeds[80 / loop_time - 1];
+    tt_want_int_op(settled, >=, 85000);
+    tt_want_int_op(settled, <=, 95000);
+    for (uint32_t i = 0; i < PBIO_ARRAY_SIZE(speeds); i++) {
+        tt_want_int_op(speeds[i], <=, 101000);
+    }
+
+    // At constant speed, it has no lag.
+    tt_want_int_op(speeds[PBIO_ARRAY_SIZE(speeds) - 1], >=, 99900);
+    tt_want_int_op(speeds[PBIO_ARRAY_SIZE(speeds) - 1], <=, 100100);
+}
+
+struct testcase_t pbio_differentiator_tests[] = {
+    PBIO_TEST(test_differentiator_filters),
+    PBIO_TEST(test_differentiator_edges),
+    PBIO_TEST(test_differentiator_edges_reversal),
+    PBIO_TEST(test_differentiator_edges_after_standstill),
+    END_OF_TESTCASES
+};
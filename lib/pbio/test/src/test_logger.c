@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <stdint.h>
+
+#include <pbio/logger.h>
+#include <pbio/util.h>
+
+#include <test-pbio.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#define TEST_NUM_ROWS (4)
+#define TEST_NUM_COLS (PBIO_LOGGER_NUM_DEFAULT_COLS + 2)
+
+static void add_test_row(pbio_log_t *log, int32_t value) {
+    int32_t row_data[] = { value, -value };
+    pbio_logger_add_row(log, row_data);
+}
+
+/**
+ * Test that a regular log stops when full.
+ */
+static void test_logger_full(void *env) {
+    static pbio_log_t log;
+    int32_t buf[TEST_NUM_ROWS * TEST_NUM_COLS];
+
+    pbio_logger_start(&log, buf, TEST_NUM_ROWS, TEST_NUM_COLS, 1);
+    tt_want(pbio_logger_is_active(&log));
+
+    for (int32_t i = 0; i < TEST_NUM_ROWS + 1; i++) {
+        add_test_row(&log, i);
+    }
+
+    tt_want(!pbio_logger_is_active(&log));
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, TEST_NUM_ROWS);
+
+    for (int32_t i = 0; i < TEST_NUM_ROWS; i++) {
+        int32_t *row = pbio_logger_get_row_data(&log, i);
+        tt_want_int_op(row[1], ==, i);
+        tt_want_int_op(row[2], ==, -i);
+    }
+}
+
+/**
+ * Test that a streamed log keeps running and is read in order.
+ */
+static void test_logger_stream(void *env) {
+    static pbio_log_t log;
+    int32_t buf[TEST_NUM_ROWS * TEST_NUM_COLS];
+    int32_t values[TEST_NUM_COLS * TEST_NUM_ROWS];
+    uint32_t index;
+
+    pbio_logger_start_stream(&log, buf, TEST_NUM_ROWS, TEST_NUM_COLS, 1);
+    tt_want(pbio_logger_get_stream() == &log);
+
+    // Overfill the buffer. The newest rows are dropped but logging continues.
+    for (int32_t i = 0; i < TEST_NUM_ROWS + 2; i++) {
+        add_test_row(&log, i);
+    }
+    tt_want(pbio_logger_is_active(&log));
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, TEST_NUM_ROWS);
+    tt_want_uint_op(log.num_rows_dropped, ==, 2);
+
+    // Read part of the first row and the rest of it in the next read.
+    tt_want_uint_op(pbio_logger_read_stream(&log, values, 2, &index), ==, 2);
+    tt_want_uint_op(index, ==, 0);
+    tt_want_int_op(values[1], ==, 0);
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, TEST_NUM_ROWS);
+
+    tt_want_uint_op(pbio_logger_read_stream(&log, values, 1, &index), ==, 1);
+    tt_want_uint_op(index, ==, 2);
+    tt_want_int_op(values[0], ==, 0);
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, TEST_NUM_ROWS - 1);
+
+    // New rows wrap around to the start of the buffer.
+    add_test_row(&log, 10);
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, TEST_NUM_ROWS);
+    tt_want(pbio_logger_get_row_data(&log, TEST_NUM_ROWS - 1) == &buf[0]);
+
+    // Everything that is left can be read in order.
+    tt_want_uint_op(pbio_logger_read_stream(&log, values, PBIO_ARRAY_SIZE(values), &index), ==, TEST_NUM_ROWS * TEST_NUM_COLS);
+    tt_want_uint_op(index, ==, TEST_NUM_COLS);
+    tt_want_int_op(values[1], ==, 1);
+    tt_want_int_op(values[TEST_NUM_COLS + 1], ==, 2);
+    tt_want_int_op(values[TEST_NUM_COLS * 2 + 1], ==, 3);
+    tt_want_int_op(values[TEST_NUM_COLS * 3 + 1], ==, 10);
+    tt_want_int_op(values[TEST_NUM_COLS * 3 + 2], ==, -10);
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, 0);
+    tt_want_uint_op(pbio_logger_read_stream(&log, values, PBIO_ARRAY_SIZE(values), &index), ==, 0);
+
+    // Stopping the log stops the stream.
+    pbio_logger_stop(&log);
+    tt_want(pbio_logger_get_stream() == NULL);
+}
+
+/**
+ * Test that a compressed log holds more rows and reads back exactly.
+ */
+static void test_logger_compressed(void *env) {
+    static pbio_log_t log;
+    int32_t buf[TEST_NUM_ROWS * TEST_NUM_COLS * 2];
+    int32_t expected[TEST_NUM_ROWS * 8];
+
+    pbio_logger_start_compressed(&log, buf, TEST_NUM_ROWS * 2, TEST_NUM_COLS, 1);
+
+    // Small changes take one byte per value, so twice as many rows fit easily.
+    uint32_t num_rows = 0;
+    while (num_rows < TEST_NUM_ROWS * 4) {
+        expected[num_rows] = num_rows * 3 - 5;
+        add_test_row(&log, expected[num_rows++]);
+    }
+    tt_want(pbio_logger_is_active(&log));
+
+    // Large jumps need more bytes per value, until the log is full.
+    while (pbio_logger_is_active(&log) && num_rows < PBIO_ARRAY_SIZE(expected)) {
+        expected[num_rows] = num_rows % 2 ? INT32_MAX : -INT32_MAX;
+        add_test_row(&log, expected[num_rows++]);
+    }
+    tt_want(!pbio_logger_is_active(&log));
+    tt_want_uint_op(pbio_logger_get_num_rows_used(&log), ==, num_rows - 1);
+
+    for (uint32_t i = 0; i < pbio_logger_get_num_rows_used(&log); i++) {
+        int32_t *row = pbio_logger_get_row_data(&log, i);
+        tt_want_int_op(row[1], ==, expected[i]);
+        tt_want_int_op(row[2], ==, -expected[i]);
+    }
+
+    // Reading an earlier row starts decoding from the beginning.
+    int32_t *row = pbio_logger_get_row_data(&log, 1);
+    tt_want_int_op(row[1], ==, expected[1]);
+}
+
+struct testcase_t pbio_logger_tests[] = {
+    PBIO_TEST(test_logger_compressed),
+    PBIO_TEST(test_logger_full),
+    PBIO_TEST(test_logger_stream),
+    END_OF_TESTCASES
+};
@@ -6,6 +6,7 @@
 #include <math.h>
 
 #include <pbio/int_math.h>
+#include <pbio/util.h>
 #include <test-pbio.h>
 
 #include <tinytest.h>
@@ -82,6 +83,37 @@ static void test_atan2(void *env) {
     }
 }
 
+static void test_interpolate(void *env) {
+
+    static const pbio_int_math_point_t points[] = {
+        { .x = 100, .y = 2000 },
+        { .x = 500, .y = 1000 },
+        { .x = 1500, .y = 500 },
+    };
+    const size_t len = PBIO_ARRAY_SIZE(points);
+
+    // Held constant beyond the end points.
+    tt_want_int_op(pbio_int_math_interpolate(points, len, -100), ==, 2000);
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 100), ==, 2000);
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 1500), ==, 500);
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 100000), ==, 500);
+
+    // Linear in between.
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 300), ==, 1500);
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 500), ==, 1000);
+    tt_want_int_op(pbio_int_math_interpolate(points, len, 1000), ==, 750);
+
+    // A single point is a constant.
+    tt_want_int_op(pbio_int_math_interpolate(points, 1, 1000), ==, 2000);
+
+    // Full range of both coordinates does not overflow.
+    static const pbio_int_math_point_t wide[] = {
+        { .x = INT16_MIN, .y = INT16_MIN },
+        { .x = INT16_MAX, .y = INT16_MAX },
+    };
+    tt_want_int_op(pbio_int_math_interpolate(wide, 2, 32000), ==, 32000);
+}
+
 static void test_mult_and_scale(void *env) {
 
     // Number of values to test for each input. Higher means more testing,
@@ -120,10 +152,81 @@ static void test_mult_and_scale(void *env) {
     }
 }
 
+static void test_reciprocal(void *env) {
+
+    // Test divisors of all magnitudes, including powers of two and their
+    // neighbors, which are edge cases for the rounding of the reciprocal.
+    const int32_t divisors[] = {
+        1, 2, 3, 5, 7, 10, 127, 128, 129, 1000, 1023, 1024, 1025, 3000,
+        17500, 65535, 65536, 100003, 1 << 20, (1 << 20) + 1, INT32_MAX - 1, INT32_MAX,
+    };
+
+    for (size_t i = 0; i < sizeof(divisors) / sizeof(divisors[0]); i++) {
+        pbio_int_math_reciprocal_t r;
+        pbio_int_math_reciprocal_init(&r, divisors[i]);
+
+        // Numbers near the extremes and near multiples of the divisor.
+        const int32_t inputs[] = {
+            0, 1, -1, INT32_MAX, INT32_MIN + 1, INT32_MIN, divisors[i], -divisors[i],
+            divisors[i] - 1, divisors[i] + 1, 1000 * divisors[i], 1000 * divisors[i] - 1,
+        };
+        for (size_t j = 0; j < sizeof(inputs) / sizeof(inputs[0]); j++) {
+            tt_want_int_op(pbio_int_math_div_by_reciprocal(inputs[j], &r), ==, inputs[j] / divisors[i]);
+        }
+
+        // Numbers across the full range.
+        for (int64_t a = INT32_MIN + 1; a < INT32_MAX; a += INT32_MAX / 4099) {
+            tt_want_int_op(pbio_int_math_div_by_reciprocal(a, &r), ==, a / divisors[i]);
+        }
+    }
+
+    // Constant initializer must match the computed reciprocal.
+    const pbio_int_math_reciprocal_t constant = PBIO_INT_MATH_RECIPROCAL(1000, 10);
+    pbio_int_math_reciprocal_t computed;
+    pbio_int_math_reciprocal_init(&computed, 1000);
+    tt_want_int_op(constant.multiplier, ==, computed.multiplier);
+    tt_want_int_op(constant.shift, ==, computed.shift);
+}
+
+static void test_mult_and_scale_by_reciprocal(void *env) {
+
+    // Same as test_mult_and_scale, but only for positive divisors.
+    const int32_t steps = 256;
+
+    const int64_t input_max = INT32_MAX;
+    const int64_t result_max = INT32_MAX;
+    const int64_t scale_max = UINT16_MAX;
+    const int64_t product_max = (((int64_t)1) << 47) - 1;
+
+    for (int64_t c = 1; c < scale_max; c += scale_max / steps) {
+        pbio_int_math_reciprocal_t r;
+        pbio_int_math_reciprocal_init(&r, c);
+
+        for (int64_t a = -input_max; a < input_max; a += input_max / steps) {
+            for (int64_t b = -input_max; b < input_max; b += input_max / steps) {
+
+                // Get the long result.
+                int64_t result = a * b / c;
+
+                // Skip pairs too big for testing.
+                if (a * b > product_max || a * b < -product_max ||
+                    result > result_max || result < -result_max) {
+                    continue;
+                }
+
+                tt_want_int_op(result, ==, pbio_int_math_mult_then_div_by_reciprocal(a, b, &r));
+            }
+        }
+    }
+}
+
 struct testcase_t pbio_int_math_tests[] = {
     PBIO_TEST(test_atan2),
     PBIO_TEST(test_clamp),
+    PBIO_TEST(test_interpolate),
     PBIO_TEST(test_mult_and_scale),
+    PBIO_TEST(test_mult_and_scale_by_reciprocal),
+    PBIO_TEST(test_reciprocal),
     PBIO_TEST(test_sqrt),
     END_OF_TESTCASES
 };
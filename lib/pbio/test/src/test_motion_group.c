@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <contiki.h>
+
+#include <pbdrv/counter.h>
+#include <pbio/battery.h>
+#include <pbio/control.h>
+#include <pbio/dcmotor.h>
+#include <pbio/motion_group.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#include <test-pbio.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include "../drv/counter/counter.h"
+
+#define NUM_AXES (2)
+
+// Simulated motor of each axis.
+static pbio_test_motor_t sim_motors[NUM_AXES];
+
+// Runs one control loop iteration, with the counters and motor drivers
+// replaced by the simulated motors, just like the motor process does.
+static void simulate_step(pbio_servo_t **axes) {
+    pbio_test_clock_tick(PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    pbio_battery_update();
+    pbio_servo_update_all();
+
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        pbio_test_motor_step(&sim_motors[i], i, axes[i]->dcmotor);
+    }
+}
+
+static void test_motion_group_run(void *env) {
+
+    pbdrv_counter_init();
+    tt_want_int_op(pbio_battery_init(), ==, PBIO_SUCCESS);
+
+    pbio_servo_t *axes[NUM_AXES];
+    tt_want_int_op(pbio_servo_get_servo(PBIO_PORT_ID_A, &axes[0]), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_servo_get_servo(PBIO_PORT_ID_B, &axes[1]), ==, PBIO_SUCCESS);
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        tt_want_int_op(pbio_servo_setup(axes[i], PBIO_DIRECTION_CLOCKWISE, 1000, false), ==, PBIO_SUCCESS);
+    }
+
+    // A group needs distinct servos.
+    pbio_motion_group_t *group;
+    pbio_servo_t *same[] = { axes[0], axes[0] };
+    tt_want_int_op(pbio_motion_group_get_motion_group(&group, same, NUM_AXES), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_motion_group_get_motion_group(&group, axes, NUM_AXES), ==, PBIO_SUCCESS);
+
+    // The second axis travels four times as far, so it sets the pace.
+    const int32_t angles[] = { 90, 360 };
+    tt_want_int_op(pbio_motion_group_run_angle(group, 500, angles, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_want_int_op(axes[0]->control.trajectory.t3, ==, axes[1]->control.trajectory.t3);
+    tt_want_int_op(axes[0]->control.trajectory.start.time, ==, axes[1]->control.trajectory.start.time);
+
+    // Run until done, checking that the references move along a straight
+    // line in joint space.
+    uint32_t k;
+    for (k = 0; k < 1000 && !pbio_motion_group_is_done(group); k++) {
+        simulate_step(axes);
+
+        pbio_trajectory_reference_t ref[NUM_AXES];
+        for (uint8_t i = 0; i < NUM_AXES; i++) {
+            uint32_t time_ref = pbio_control_get_ref_time(&axes[i]->control, pbio_control_get_time_ticks());
+            pbio_trajectory_get_reference(&axes[i]->control.trajectory, time_ref, &ref[i]);
+        }
+        int32_t progress_0 = pbio_control_settings_ctl_to_app_long(&axes[0]->control.settings, &ref[0].position);
+        int32_t progress_1 = pbio_control_settings_ctl_to_app_long(&axes[1]->control.settings, &ref[1].position);
+        tt_want_int_op(abs(progress_0 * 4 - progress_1), <=, 4);
+    }
+    tt_want(pbio_motion_group_is_done(group));
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        tt_want_int_op(fabs(sim_motors[i].angle - angles[i] * 1000), <=, axes[i]->control.settings.position_tolerance);
+    }
+
+    // Mixed speed profiles can't be synchronized, so nothing starts and the
+    // servos keep holding.
+    simulate_step(axes);
+    uint32_t time_start = axes[0]->control.trajectory.start.time;
+    axes[1]->control.settings.profile = PBIO_TRAJECTORY_PROFILE_S_CURVE;
+    tt_want_int_op(pbio_motion_group_run_angle(group, 500, angles, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_INVALID_OP);
+    tt_want_int_op(axes[0]->control.trajectory.start.time, ==, time_start);
+    tt_want(pbio_control_is_active(&axes[0]->control));
+    axes[1]->control.settings.profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
+
+    // If a later axis fails to start, the ones that started are stopped too.
+    const int32_t too_far[] = { 90, 3000000 };
+    tt_want_int_op(pbio_motion_group_run_angle(group, 500, too_far, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(!pbio_control_is_active(&axes[0]->control));
+    tt_want(!pbio_control_is_active(&axes[1]->control));
+
+    // A command to one servo ends the group command and stops the others.
+    tt_want_int_op(pbio_motion_group_run_angle(group, 500, angles, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    simulate_step(axes);
+    tt_want_int_op(pbio_servo_run_forever(axes[0], 100), ==, PBIO_SUCCESS);
+    tt_want(!group->active);
+    tt_want(!pbio_control_is_active(&axes[1]->control));
+}
+
+struct testcase_t pbio_motion_group_tests[] = {
+    PBIO_TEST(test_motion_group_run),
+    END_OF_TESTCASES
+};
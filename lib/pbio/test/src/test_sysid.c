@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <contiki.h>
+
+#include <pbdrv/counter.h>
+#include <pbio/battery.h>
+#include <pbio/control_settings.h>
+#include <pbio/dcmotor.h>
+#include <pbio/observer.h>
+#include <pbio/parent.h>
+#include <pbio/servo.h>
+#include <pbio/sysid.h>
+#include <pbio/util.h>
+
+#include <test-pbio.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include "../drv/counter/counter.h"
+
+// Runs the identification of a servo whose counter and motor driver are
+// replaced by the simulated motor, just like the motor process does.
+static pbio_error_t identify_simulated_motor(pbio_servo_t *srv, int32_t voltage) {
+
+    pbio_error_t err = pbio_sysid_start(srv, voltage);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    pbio_test_motor_t motor = {0};
+
+    for (uint32_t k = 0; k < 1000 && pbio_sysid_get_status(srv) == PBIO_ERROR_AGAIN; k++) {
+        pbio_test_clock_tick(PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+        pbio_battery_update();
+        pbio_servo_update_all();
+        pbio_sysid_update_all();
+        pbio_test_motor_step(&motor, 0, srv->dcmotor);
+    }
+    return pbio_sysid_get_status(srv);
+}
+
+static void test_sysid_update(void *env) {
+
+    pbdrv_counter_init();
+    tt_want_int_op(pbio_battery_init(), ==, PBIO_SUCCESS);
+
+    pbio_servo_t *srv;
+    tt_want_int_op(pbio_servo_get_servo(PBIO_PORT_ID_A, &srv), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_servo_setup(srv, PBIO_DIRECTION_CLOCKWISE, 1000, false), ==, PBIO_SUCCESS);
+    const pbio_observer_model_t *base = srv->observer.model;
+
+    // Voltage out of range.
+    tt_want_int_op(pbio_sysid_start(srv, 0), ==, PBIO_ERROR_INVALID_ARG);
+
+    // The identified model replaces the tabulated one.
+    tt_want_int_op(identify_simulated_motor(srv, 6000), ==, PBIO_SUCCESS);
+    tt_want(srv->observer.model != base);
+
+    // The servo is released, so it accepts commands again.
+    tt_want(!pbio_parent_exists(&srv->parent));
+
+    // Compare to the model of the exact parameters, which is tested below.
+    const double one = PBIO_OBSERVER_FIRST_ORDER_ONE;
+    pbio_observer_model_t expected;
+    tt_want_int_op(pbio_observer_model_from_first_order(&expected, base, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, PBIO_TEST_MOTOR_ALPHA * one, PBIO_TEST_MOTOR_BETA * one, PBIO_TEST_MOTOR_GAMMA * one), ==, PBIO_SUCCESS);
+
+    int32_t speed = 500000;
+    double voltage = pbio_observer_torque_to_voltage(srv->observer.model, pbio_observer_get_feedforward_torque(srv->observer.model, speed, 0));
+    double voltage_expected = pbio_observer_torque_to_voltage(&expected, pbio_observer_get_feedforward_torque(&expected, speed, 0));
+    tt_want_int_op(fabs(voltage / voltage_expected - 1) * 100, <, 5);
+
+    int32_t acceleration = 1000000;
+    voltage = pbio_observer_torque_to_voltage(srv->observer.model, pbio_observer_get_feedforward_torque(srv->observer.model, 0, acceleration));
+    voltage_expected = pbio_observer_torque_to_voltage(&expected, pbio_observer_get_feedforward_torque(&expected, 0, acceleration));
+    tt_want_int_op(fabs(voltage / voltage_expected - 1) * 100, <, 10);
+
+    // A new command to the servo cancels the identification.
+    tt_want_int_op(pbio_sysid_start(srv, 6000), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_sysid_get_status(srv), ==, PBIO_ERROR_AGAIN);
+    tt_want_int_op(pbio_servo_stop(srv, PBIO_CONTROL_ON_COMPLETION_COAST), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_sysid_get_status(srv), ==, PBIO_ERROR_CANCELED);
+}
+
+static void test_sysid_fit(void *env) {
+
+    int64_t alpha, beta, gamma;
+
+    // Without enough samples, there is no solution.
+    pbio_sysid_fit_t fit;
+    pbio_sysid_fit_reset(&fit);
+    pbio_sysid_fit_add(&fit, 10000, 50000, 16, 10000);
+    tt_want_int_op(pbio_sysid_fit_solve(&fit, &alpha, &beta, &gamma), ==, PBIO_ERROR_FAILED);
+
+    // Without any voltage, the voltage gain can't be identified.
+    pbio_sysid_fit_reset(&fit);
+    for (uint32_t k = 0; k < 100; k++) {
+        pbio_sysid_fit_add(&fit, 10000, 0, 16, 10000);
+    }
+    tt_want_int_op(pbio_sysid_fit_solve(&fit, &alpha, &beta, &gamma), ==, PBIO_ERROR_FAILED);
+}
+
+static void test_sysid_model(void *env) {
+
+    // Start from the tabulated model of the same motor type.
+    pbio_control_settings_t settings;
+    const pbio_observer_model_t *base;
+    tt_want_int_op(pbio_servo_load_settings(&settings, &base, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR), ==, PBIO_SUCCESS);
+
+    const double one = PBIO_OBSERVER_FIRST_ORDER_ONE;
+    pbio_observer_model_t model;
+    pbio_error_t err = pbio_observer_model_from_first_order(&model, base, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, PBIO_TEST_MOTOR_ALPHA * one, PBIO_TEST_MOTOR_BETA * one, PBIO_TEST_MOTOR_GAMMA * one);
+    tt_want_int_op(err, ==, PBIO_SUCCESS);
+
+    // Steady state speed per voltage (mdeg/s per mV) and time constant (s).
+    const double h = PBIO_CONFIG_CONTROL_LOOP_TIME_MS / 1000.0;
+    const double speed_per_volt = PBIO_TEST_MOTOR_BETA / (1 - PBIO_TEST_MOTOR_ALPHA) / h;
+    const double time_constant = -h / log(PBIO_TEST_MOTOR_ALPHA);
+
+    // Feedforward voltage at constant speed must account for back EMF and
+    // friction.
+    int32_t speed = 500000;
+    int32_t voltage = pbio_observer_torque_to_voltage(&model, pbio_observer_get_feedforward_torque(&model, speed, 0));
+    double expected = speed / speed_per_volt + PBIO_TEST_MOTOR_FRICTION_VOLTAGE;
+    tt_want_int_op(fabs(voltage / expected - 1) * 100, <, 3);
+
+    // Feedforward voltage when accelerating from standstill.
+    int32_t acceleration = 1000000;
+    voltage = pbio_observer_torque_to_voltage(&model, pbio_observer_get_feedforward_torque(&model, 0, acceleration));
+    expected = acceleration * time_constant / speed_per_volt;
+    tt_want_int_op(fabs(voltage / expected - 1) * 100, <, 5);
+
+    // Unstable or reversed models are rejected.
+    tt_want_int_op(pbio_observer_model_from_first_order(&model, base, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, one, PBIO_TEST_MOTOR_BETA * one, 0), ==, PBIO_ERROR_FAILED);
+    tt_want_int_op(pbio_observer_model_from_first_order(&model, base, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, PBIO_TEST_MOTOR_ALPHA * one, -PBIO_TEST_MOTOR_BETA * one, 0), ==, PBIO_ERROR_FAILED);
+}
+
+static void test_sysid_model_for_step(void *env) {
+
+    // Loop times shorter than the model step are allowed, but longer ones
+    // must be a multiple of it.
+    tt_want_int_op(pbio_control_settings_set_loop_time(0), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_control_settings_set_loop_time(2), ==, PBIO_SUCCESS);
+    tt_want_int_op(pbio_control_settings_set_loop_time(7), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_int_op(pbio_control_settings_set_loop_time(10), ==, PBIO_SUCCESS);
+
+    pbio_control_settings_t settings;
+    const pbio_observer_model_t *base;
+    tt_want_int_op(pbio_servo_load_settings(&settings, &base, PBIO_IODEV_TYPE_ID_SPIKE_M_MOTOR), ==, PBIO_SUCCESS);
+
+    const double one = PBIO_OBSERVER_FIRST_ORDER_ONE;
+    pbio_observer_model_t model;
+    tt_want_int_op(pbio_observer_model_from_first_order(&model, base, PBIO_CONFIG_CONTROL_LOOP_TIME_MS, PBIO_TEST_MOTOR_ALPHA * one, PBIO_TEST_MOTOR_BETA * one, PBIO_TEST_MOTOR_GAMMA * one), ==, PBIO_SUCCESS);
+
+    // A model made for a shorter step gives the same feedforward.
+    pbio_observer_model_t fast;
+    tt_want_int_op(pbio_observer_model_for_step(&fast, &model, 1), ==, PBIO_SUCCESS);
+    int32_t expected = pbio_observer_torque_to_voltage(&model, pbio_observer_get_feedforward_torque(&model, 500000, 1000000));
+    int32_t voltage = pbio_observer_torque_to_voltage(&fast, pbio_observer_get_feedforward_torque(&fast, 500000, 1000000));
+    tt_want_int_op(abs(voltage - expected), <, expected / 100);
+
+    // Steady state speed and time constant of the simulated motor.
+    const double h = PBIO_CONFIG_CONTROL_LOOP_TIME_MS / 1000.0;
+    const double speed_per_volt = PBIO_TEST_MOTOR_BETA / (1 - PBIO_TEST_MOTOR_ALPHA) / h;
+    const double time_constant = -h / log(PBIO_TEST_MOTOR_ALPHA);
+
+    // Without feedback, the observer speed follows a voltage step at each
+    // loop time like the motor does.
+    static const uint32_t loop_times[] = { 1, 2, 5 };
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(loop_times); i++) {
+        uint32_t loop_time = loop_times[i];
+        tt_want_int_op(pbio_control_settings_set_loop_time(loop_time), ==, PBIO_SUCCESS);
+
+        pbio_observer_t obs = { .model = &model };
+        pbio_angle_t angle = {0};
+        pbio_observer_reset(&obs, &settings, &angle);
+
+        const int32_t step_voltage = 6000;
+        const double speed_final = (step_voltage - PBIO_TEST_MOTOR_FRICTION_VOLTAGE) * speed_per_volt;
+        int32_t speed_num, speed;
+        for (uint32_t time = 0; time < 500; time += loop_time) {
+            pbio_observer_get_estimated_state(&obs, &speed_num, &angle, &speed);
+            if (time == 50) {
+                double speed_expected = speed_final * (1 - exp(-0.05 / time_constant));
+                tt_want_int_op(fabs(speed / speed_expected - 1) * 100, <, 5);
+            }
+            pbio_observer_update(&obs, time, &angle, PBIO_DIFFERENTIATOR_EDGE_AGE_UNKNOWN, PBIO_DCMOTOR_ACTUATION_VOLTAGE, step_voltage);
+        }
+        tt_want_int_op(fabs(speed / speed_final - 1) * 100, <, 3);
+    }
+
+    pbio_control_settings_set_loop_time(PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+}
+
+struct testcase_t pbio_sysid_tests[] = {
+    PBIO_TEST(test_sysid_fit),
+    PBIO_TEST(test_sysid_update),
+    PBIO_TEST(test_sysid_model),
+    PBIO_TEST(test_sysid_model_for_step),
+    END_OF_TESTCASES
+};
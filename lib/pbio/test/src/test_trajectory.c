@@ -148,6 +148,75 @@ static void walk_trajectory(pbio_trajectory_t *trj) {
     }
 }
 
+/**
+ * Tests that S-curve ramps take 1.5 times as long as trapezoidal ramps with
+ * the same peak acceleration, and that the acceleration changes smoothly.
+ */
+static void test_s_curve_trajectory(void *env) {
+
+    // Command: Run for 10000 degrees at 1000 deg/s with a peak acceleration
+    // of 3000 deg/s/s. The average acceleration is 2000 deg/s/s, so this
+    // has the same vertices as the simple trajectory above.
+    pbio_angle_t start = {
+        .rotations = 0,
+        .millidegrees = 0,
+    };
+
+    pbio_angle_t end = {
+        .rotations = 27,
+        .millidegrees = 280 * MDEG_PER_DEG,
+    };
+
+    pbio_trajectory_command_t command = {
+        .time_start = 0,
+        .position_start = start,
+        .position_end = end,
+        .speed_start = 0,
+        .speed_target = 1000 * MDEG_PER_DEG,
+        .speed_max = 1000 * MDEG_PER_DEG,
+        .acceleration = 3000 * MDEG_PER_DEG,
+        .deceleration = 3000 * MDEG_PER_DEG,
+        .continue_running = false,
+        .profile = PBIO_TRAJECTORY_PROFILE_S_CURVE,
+    };
+
+    pbio_trajectory_t trj;
+    pbio_error_t err = pbio_trajectory_new_angle_command(&trj, &command);
+    tt_want_int_op(err, ==, PBIO_SUCCESS);
+
+    tt_want_int_op(trj.t1, ==, 500 * 10);
+    tt_want_int_op(trj.t2, ==, 10000 * 10);
+    tt_want_int_op(trj.t3, ==, 10500 * 10);
+    tt_want_int_op(trj.th1, ==, 250 * MDEG_PER_DEG);
+    tt_want_int_op(trj.th2, ==, 9750 * MDEG_PER_DEG);
+
+    // Acceleration starts and ends at zero, and peaks halfway the ramp.
+    pbio_trajectory_reference_t ref;
+    pbio_trajectory_get_reference(&trj, 0, &ref);
+    tt_want_int_op(ref.acceleration, ==, 0);
+    tt_want_int_op(ref.speed, ==, 0);
+
+    pbio_trajectory_get_reference(&trj, trj.t1 / 2, &ref);
+    tt_want_int_op(ref.acceleration, ==, command.acceleration);
+    tt_want_int_op(ref.speed, ==, command.speed_target / 2);
+    tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &start), ==, 46875);
+
+    pbio_trajectory_get_reference(&trj, trj.t1 - 1, &ref);
+    tt_want_int_op(pbio_int_math_abs(ref.acceleration), <, command.acceleration / 100);
+    tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &start), <=, trj.th1);
+
+    pbio_trajectory_get_reference(&trj, trj.t2 + (trj.t3 - trj.t2) / 2, &ref);
+    tt_want_int_op(ref.acceleration, ==, -command.deceleration);
+
+    pbio_trajectory_get_reference(&trj, trj.t3, &ref);
+    tt_want_int_op(ref.acceleration, ==, 0);
+    tt_want_int_op(ref.speed, ==, 0);
+    tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &end), ==, 0);
+
+    // Walk the whole trajectory.
+    walk_trajectory(&trj);
+}
+
 // Start and end angles in millidegrees.
 static const pbio_angle_t angles[] = {
     {.rotations = 0,             .millidegrees = 0 },
@@ -190,6 +259,7 @@ static void get_infinite_command(uint32_t index, pbio_trajectory_command_t *c) {
 
     c->duration = DURATION_FOREVER_TICKS;
     c->speed_max = 1000 * MDEG_PER_DEG;
+    c->profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
     c->continue_running = true;
 
     c->position_start = angles[index % PBIO_ARRAY_SIZE(angles)];
@@ -287,6 +357,7 @@ static const uint32_t num_position_trajectories =
 static void get_position_command(uint32_t index, pbio_trajectory_command_t *c) {
 
     c->speed_max = 1000 * MDEG_PER_DEG;
+    c->profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
 
     c->continue_running = index % 2;
     index /= 2;
@@ -370,9 +441,130 @@ static void test_position_trajectory(void *env) {
     }
 }
 
+/**
+ * Tests that evaluating a trajectory in constant time steps, as in the control
+ * loop, gives the same result as evaluating each point from scratch.
+ */
+static void test_incremental_reference(void *env) {
+
+    pbio_trajectory_command_t command;
+
+    // Check a subset of all position trajectories.
+    for (uint32_t i = 0; i < num_position_trajectories; i += 7) {
+        get_position_command(i, &command);
+
+        // Also check some S-curve trajectories.
+        if (i % 3 == 0) {
+            command.profile = PBIO_TRAJECTORY_PROFILE_S_CURVE;
+        }
+
+        pbio_trajectory_t trj;
+        if (pbio_trajectory_new_angle_command(&trj, &command) != PBIO_SUCCESS) {
+            continue;
+        }
+
+        // Copy of the trajectory that is never advanced incrementally.
+        const pbio_trajectory_t exact = trj;
+
+        // Use the default loop time, with a different step now and then.
+        uint32_t increment = i % 5 == 0 ? 30 : 50;
+        uint32_t duration = pbio_trajectory_get_duration(&trj) + 2 * increment;
+
+        for (uint32_t t = 0; t < duration; t += increment) {
+
+            // Get reference incrementally.
+            pbio_trajectory_reference_t ref;
+            pbio_trajectory_get_reference(&trj, command.time_start + t, &ref);
+
+            // Get reference from scratch.
+            pbio_trajectory_t scratch = exact;
+            pbio_trajectory_reference_t ref_exact;
+            pbio_trajectory_get_reference(&scratch, command.time_start + t, &ref_exact);
+
+            tt_want_int_op(ref.time, ==, ref_exact.time);
+            tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &ref_exact.position), ==, 0);
+            tt_want_int_op(ref.speed, ==, ref_exact.speed);
+            tt_want_int_op(ref.acceleration, ==, ref_exact.acceleration);
+
+            // Getting the same point twice gives the same result.
+            if (t % 1000 == 0) {
+                pbio_trajectory_get_reference(&trj, command.time_start + t, &ref_exact);
+                tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &ref_exact.position), ==, 0);
+            }
+        }
+    }
+}
+
+/**
+ * Tests that several trajectories that start together are stretched to end
+ * together, moving in a straight line in joint space.
+ */
+static void test_synchronized_trajectories(void *env) {
+
+    // Three axes with different distances and accelerations, all starting
+    // and ending at rest.
+    const int32_t distances[] = { 360, -90, 1500 };
+    const int32_t accelerations[] = { 500, 2000, 1000 };
+
+    pbio_trajectory_t trajectories[PBIO_ARRAY_SIZE(distances)];
+    pbio_trajectory_t *axes[PBIO_ARRAY_SIZE(distances)];
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(distances); i++) {
+        pbio_trajectory_command_t command = {
+            .time_start = 1000,
+            .position_start = {
+                .rotations = 0,
+                .millidegrees = 0,
+            },
+            .position_end = {
+                .rotations = 0,
+                .millidegrees = distances[i] * MDEG_PER_DEG,
+            },
+            .speed_start = 0,
+            .speed_target = 500 * MDEG_PER_DEG,
+            .speed_max = 1000 * MDEG_PER_DEG,
+            .acceleration = accelerations[i] * MDEG_PER_DEG,
+            .deceleration = accelerations[i] * MDEG_PER_DEG,
+            .profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID,
+            .continue_running = false,
+        };
+        tt_want_int_op(pbio_trajectory_new_angle_command(&trajectories[i], &command), ==, PBIO_SUCCESS);
+        axes[i] = &trajectories[i];
+    }
+
+    pbio_trajectory_synchronize(axes, PBIO_ARRAY_SIZE(axes));
+
+    // All axes take as long as the longest one, and still reach their target.
+    uint32_t duration = pbio_trajectory_get_duration(axes[2]);
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(axes); i++) {
+        tt_want_int_op(pbio_trajectory_get_duration(axes[i]), ==, duration);
+
+        pbio_trajectory_reference_t end;
+        pbio_trajectory_get_endpoint(axes[i], &end);
+        tt_want_int_op(pbio_angle_to_low_res(&end.position, MDEG_PER_DEG), ==, distances[i]);
+    }
+
+    // All axes travel the same fraction of their distance at any time.
+    for (uint32_t t = 0; t <= duration; t += 50) {
+        pbio_trajectory_reference_t ref_lead;
+        pbio_trajectory_get_reference(axes[2], 1000 + t, &ref_lead);
+        int32_t position_lead = pbio_angle_to_low_res(&ref_lead.position, 1);
+
+        for (uint8_t i = 0; i < 2; i++) {
+            pbio_trajectory_reference_t ref;
+            pbio_trajectory_get_reference(axes[i], 1000 + t, &ref);
+            int32_t position_expected = position_lead * distances[i] / distances[2];
+            tt_want(pbio_int_math_abs(pbio_angle_to_low_res(&ref.position, 1) - position_expected) < 100);
+        }
+    }
+}
+
 struct testcase_t pbio_trajectory_tests[] = {
     PBIO_TEST(test_simple_trajectory),
+    PBIO_TEST(test_s_curve_trajectory),
     PBIO_TEST(test_position_trajectory),
     PBIO_TEST(test_infinite_trajectory),
+    PBIO_TEST(test_incremental_reference),
+    PBIO_TEST(test_synchronized_trajectories),
     END_OF_TESTCASES
 };
@@ -12,6 +12,7 @@
 #include <tinytest.h>
 #include <tinytest_macros.h>
 
+#include <pbdrv/clock.h>
 #include <pbdrv/uart.h>
 #include <pbio/iodev.h>
 #include <pbio/main.h>
@@ -33,7 +34,9 @@ static struct {
     struct etimer rx_timer;
     uint8_t *rx_msg;
     uint8_t rx_msg_length;
-    pbio_error_t rx_msg_result;
+    const uint8_t *rx_stream;
+    uint8_t rx_stream_length;
+    uint8_t rx_stream_pos;
     uint8_t *tx_msg;
     struct etimer tx_timer;
     uint8_t tx_msg_length;
@@ -43,37 +46,20 @@ static struct {
 PT_THREAD(simulate_rx_msg(struct pt *pt, const uint8_t *msg, uint8_t length, bool *ok)) {
     PT_BEGIN(pt);
 
-    // First uartdev reads one byte header
-    PT_WAIT_UNTIL(pt, ({
-        pbio_test_clock_tick(1);
-        test_uart_dev.rx_msg_result == PBIO_ERROR_AGAIN;
-    }));
-    tt_uint_op(test_uart_dev.rx_msg_length, ==, 1);
-    memcpy(test_uart_dev.rx_msg, msg, 1);
-    test_uart_dev.rx_msg_result = PBIO_SUCCESS;
+    // The bytes arrive all at once, and uartdev may read them in any pieces.
+    test_uart_dev.rx_stream = msg;
+    test_uart_dev.rx_stream_length = length;
+    test_uart_dev.rx_stream_pos = 0;
     process_poll(&pbio_uartdev_process);
 
-    if (length == 1) {
-        *ok = true;
-        PT_EXIT(pt);
-    }
-
-    // then read rest of message
+    // wait until uartdev has read the whole message
     PT_WAIT_UNTIL(pt, ({
         pbio_test_clock_tick(1);
-        test_uart_dev.rx_msg_result == PBIO_ERROR_AGAIN;
+        test_uart_dev.rx_stream_pos == test_uart_dev.rx_stream_length;
     }));
-    tt_uint_op(test_uart_dev.rx_msg_length, ==, length - 1);
-    memcpy(test_uart_dev.rx_msg, &msg[1], length - 1);
-    test_uart_dev.rx_msg_result = PBIO_SUCCESS;
-    process_poll(&pbio_uartdev_process);
 
     *ok = true;
     PT_END(pt);
-
-end:
-    *ok = false;
-    PT_EXIT(pt);
 }
 
 PT_THREAD(simulate_tx_msg(struct pt *pt, const uint8_t *msg, uint8_t length, bool *ok)) {
@@ -206,6 +192,7 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     // mode 0 DATA message captured from BOOST Color and Distance Sensor
     static const uint8_t msg85[] = { 0x46, 0x00, 0xB9 }; // extened mode info
     static const uint8_t msg86[] = { 0xC0, 0xFF, 0xC0 }; // mode 0 data
+    static const uint8_t msg86b[] = { 0x46, 0xB9, 0xC0, 0x05, 0x3A }; // lost byte, then mode 0 data
 
     static const uint8_t msg87[] = { 0x43, 0x01, 0xBD }; // set mode 1
     static const uint8_t msg88[] = { 0xC1, 0x00, 0x3E }; // mode 1 data
@@ -214,6 +201,10 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     static const uint8_t msg90[] = { 0x46, 0x08, 0xB1 }; // extened mode info
     static const uint8_t msg91[] = { 0xD0, 0x00, 0x00, 0x00, 0x00, 0x2F }; // mode 8 data
 
+    static const uint8_t msg92[] = { 0x54, 0x20, 0x00, 0x10, 0x00, 0x9B }; // combine modes 0 and 1
+    static const uint8_t msg93[] = { 0xC8, 0x03, 0x07, 0x33 }; // mode 0 and 1 data
+    static const uint8_t msg94[] = { 0x43, 0x00, 0xBC }; // set mode 0
+
     // used in SIMULATE_RX/TX_MSG macros
     static struct pt child;
     static bool ok;
@@ -384,6 +375,38 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_want_uint_op(iodev->info->mode_info[10].num_values, ==, 8);
     tt_want_uint_op(iodev->info->mode_info[10].data_type, ==, PBIO_IODEV_DATA_TYPE_INT16);
 
+    // a message with a lost byte is dropped, but the next one is received
+    tt_want_uint_op(iodev->bin_data[0], ==, 0xFF);
+    SIMULATE_RX_MSG(msg86b);
+    tt_want_uint_op(iodev->bin_data[0], ==, 0x05);
+
+    // all samples are kept until they are read, oldest first
+    static uint8_t history[PBIO_CONFIG_IODEV_HISTORY_SIZE * 5];
+    static size_t written;
+    static uint32_t last_time;
+    tt_uint_op(pbio_iodev_read_history(iodev, 0, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_uint_op(written, ==, 11 * 5);
+    last_time = 0;
+    for (i = 0; i < 10; i++) {
+        tt_want_uint_op(history[i * 5 + 4], ==, 0xFF);
+        tt_want_uint_op(pbio_get_uint32_le(&history[i * 5]), >=, last_time);
+        last_time = pbio_get_uint32_le(&history[i * 5]);
+    }
+    tt_want_uint_op(history[10 * 5 + 4], ==, 0x05);
+    tt_want_uint_op(pbio_get_uint32_le(&history[10 * 5]), >, last_time);
+    last_time = pbio_get_uint32_le(&history[10 * 5]);
+    tt_want_uint_op(iodev->time, ==, last_time);
+
+    // samples that don't fit are kept for the next read
+    SIMULATE_RX_MSG(msg86);
+    SIMULATE_RX_MSG(msg86);
+    tt_uint_op(pbio_iodev_read_history(iodev, 0, history, 9, &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 5);
+    tt_uint_op(pbio_iodev_read_history(iodev, 0, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 5);
+    tt_uint_op(pbio_iodev_read_history(iodev, 0, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 0);
+    last_time = iodev->time;
 
     // test changing the mode
 
@@ -403,8 +426,12 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(pbio_iodev_set_mode_end(iodev), ==, PBIO_ERROR_AGAIN);
     tt_uint_op(iodev->mode, !=, 1);
 
+    // data of the old mode is kept until data with the new mode arrives
+    tt_want_uint_op(iodev->time, ==, last_time);
+
     // data message with new mode
     SIMULATE_RX_MSG(msg88);
+    tt_want_uint_op(iodev->time, >, last_time);
 
     PT_WAIT_WHILE(pt, ({
         pbio_test_clock_tick(1);
@@ -440,6 +467,86 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(err, ==, PBIO_SUCCESS);
     tt_uint_op(iodev->mode, ==, 8);
 
+
+    // stream modes 0 and 1 at the same time
+
+    static const uint8_t bad_combi_modes[] = { 0, 8 };
+    tt_uint_op(pbio_iodev_set_combi_mode_begin(iodev, bad_combi_modes, 2), ==, PBIO_ERROR_INVALID_ARG);
+
+    static const uint8_t combi_modes[] = { 0, 1 };
+    PT_WAIT_WHILE(pt, ({
+        pbio_test_clock_tick(1);
+        (err = pbio_iodev_set_combi_mode_begin(iodev, combi_modes, 2)) == PBIO_ERROR_AGAIN;
+    }));
+    tt_uint_op(err, ==, PBIO_SUCCESS);
+
+    SIMULATE_TX_MSG(msg92);
+
+    PT_WAIT_WHILE(pt, ({
+        pbio_test_clock_tick(1);
+        (err = pbio_iodev_set_combi_mode_end(iodev)) == PBIO_ERROR_AGAIN;
+    }));
+    tt_uint_op(err, ==, PBIO_SUCCESS);
+
+    // data from before the mode combination is not used
+    static uint8_t *mode_data;
+    static uint32_t time;
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 1, &mode_data, &time), ==, PBIO_ERROR_AGAIN);
+
+    // data of the first mode sent before the device switched is dropped
+    SIMULATE_RX_MSG(msg85);
+    SIMULATE_RX_MSG(msg86);
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 0, &mode_data, &time), ==, PBIO_ERROR_AGAIN);
+
+    SIMULATE_RX_MSG(msg85);
+    SIMULATE_RX_MSG(msg93);
+
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 0, &mode_data, &time), ==, PBIO_SUCCESS);
+    tt_want_uint_op(mode_data[0], ==, 3);
+    tt_want_uint_op(time, <=, pbdrv_clock_get_ms());
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 1, &mode_data, &time), ==, PBIO_SUCCESS);
+    tt_want_uint_op(mode_data[0], ==, 7);
+
+    // combined data is kept in the history as one sample per mode, and
+    // reading samples of one mode keeps the samples of other modes
+    tt_uint_op(pbio_iodev_read_history(iodev, 1, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 10);
+    tt_want_uint_op(history[4], ==, 0x00);
+    tt_want_uint_op(pbio_get_uint32_le(&history[5]), ==, time);
+    tt_want_uint_op(history[9], ==, 7);
+    tt_uint_op(pbio_iodev_read_history(iodev, 1, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 0);
+    tt_uint_op(pbio_iodev_read_history(iodev, 0, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 5);
+    tt_want_uint_op(pbio_get_uint32_le(&history[0]), ==, time);
+    tt_want_uint_op(history[4], ==, 3);
+    tt_uint_op(pbio_iodev_read_history(iodev, 8, history, sizeof(history), &written), ==, PBIO_SUCCESS);
+    tt_want_uint_op(written, ==, 8);
+
+    // selecting the first mode of the combination ends the combination
+
+    PT_WAIT_WHILE(pt, ({
+        pbio_test_clock_tick(1);
+        (err = pbio_iodev_set_mode_begin(iodev, 0)) == PBIO_ERROR_AGAIN;
+    }));
+    tt_uint_op(err, ==, PBIO_SUCCESS);
+
+    SIMULATE_TX_MSG(msg94);
+    tt_uint_op(pbio_iodev_set_mode_end(iodev), ==, PBIO_ERROR_AGAIN);
+
+    SIMULATE_RX_MSG(msg85);
+    SIMULATE_RX_MSG(msg86);
+
+    PT_WAIT_WHILE(pt, ({
+        pbio_test_clock_tick(1);
+        (err = pbio_iodev_set_mode_end(iodev)) == PBIO_ERROR_AGAIN;
+    }));
+    tt_uint_op(err, ==, PBIO_SUCCESS);
+
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 0, &mode_data, &time), ==, PBIO_SUCCESS);
+    tt_want_uint_op(mode_data[0], ==, 0xFF);
+    tt_uint_op(pbio_iodev_get_mode_data(iodev, 1, &mode_data, &time), ==, PBIO_ERROR_AGAIN);
+
     PT_YIELD(pt);
 
 end:
@@ -792,7 +899,8 @@ static PT_THREAD(test_technic_xl_motor(struct pt *pt)) {
     // info messages captured from Technic XL Linear Motor with logic analyzer
     static const uint8_t msg2[] = { 0x40, 0x2F, 0x90 };
     static const uint8_t msg3[] = { 0x49, 0x05, 0x03, 0xB0 };
-    static const uint8_t msg4[] = { 0x52, 0x00, 0xC2, 0x01, 0x00, 0x6E };
+    // pretend that this device sends data at 460800 baud
+    static const uint8_t msg4[] = { 0x52, 0x00, 0x08, 0x07, 0x00, 0xA2 };
     static const uint8_t msg5[] = { 0x5F, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0xB4 };
     static const uint8_t msg6[] = { 0xA5, 0x00, 0x53, 0x54, 0x41, 0x54, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x04, 0x00, 0x00, 0x00, 0x00, 0x1A };
     static const uint8_t msg7[] = { 0x9D, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x7F, 0x47, 0xA4 };
@@ -930,6 +1038,12 @@ static PT_THREAD(test_technic_xl_motor(struct pt *pt)) {
     // wait for ACK
     SIMULATE_TX_MSG(msg55);
 
+    // data is sent at the baud rate given in the info
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        test_uart_dev.baud == 460800;
+    }));
+
     PT_YIELD(pt);
 
     // should be synced now are receive regular pings
@@ -1011,7 +1125,6 @@ pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t
 
     test_uart_dev.rx_msg = msg;
     test_uart_dev.rx_msg_length = length;
-    test_uart_dev.rx_msg_result = PBIO_ERROR_AGAIN;
     etimer_set(&test_uart_dev.rx_timer, timeout);
 
     return PBIO_SUCCESS;
@@ -1020,21 +1133,39 @@ pbio_error_t pbdrv_uart_read_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t
 pbio_error_t pbdrv_uart_read_end(pbdrv_uart_dev_t *uart) {
     assert(test_uart_dev.rx_msg);
 
-    if (test_uart_dev.rx_msg_result == PBIO_ERROR_AGAIN && etimer_expired(&test_uart_dev.rx_timer)) {
-        test_uart_dev.rx_msg_result = PBIO_ERROR_TIMEDOUT;
+    if (test_uart_dev.rx_stream_length - test_uart_dev.rx_stream_pos >= test_uart_dev.rx_msg_length) {
+        memcpy(test_uart_dev.rx_msg, &test_uart_dev.rx_stream[test_uart_dev.rx_stream_pos], test_uart_dev.rx_msg_length);
+        test_uart_dev.rx_stream_pos += test_uart_dev.rx_msg_length;
+        test_uart_dev.rx_msg = NULL;
+        return PBIO_SUCCESS;
     }
 
-    if (test_uart_dev.rx_msg_result != PBIO_ERROR_AGAIN) {
+    if (etimer_expired(&test_uart_dev.rx_timer)) {
         test_uart_dev.rx_msg = NULL;
+        return PBIO_ERROR_TIMEDOUT;
     }
 
-    return test_uart_dev.rx_msg_result;
+    return PBIO_ERROR_AGAIN;
 }
 
 void pbdrv_uart_read_cancel(pbdrv_uart_dev_t *uart) {
 
 }
 
+pbio_error_t pbdrv_uart_read_stream(pbdrv_uart_dev_t *uart, uint8_t *buf, uint8_t size, uint8_t *count) {
+    *count = 0;
+
+    if (test_uart_dev.rx_msg) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    while (*count < size && test_uart_dev.rx_stream_pos < test_uart_dev.rx_stream_length) {
+        buf[(*count)++] = test_uart_dev.rx_stream[test_uart_dev.rx_stream_pos++];
+    }
+
+    return PBIO_SUCCESS;
+}
+
 pbio_error_t pbdrv_uart_write_begin(pbdrv_uart_dev_t *uart, uint8_t *msg, uint8_t length, uint32_t timeout) {
     if (test_uart_dev.tx_msg) {
         return PBIO_ERROR_AGAIN;
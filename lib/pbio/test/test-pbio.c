@@ -82,10 +82,15 @@ extern struct testcase_t pbdrv_pwm_tests[];
 extern struct testcase_t pbio_angle_tests[];
 extern struct testcase_t pbio_battery_tests[];
 extern struct testcase_t pbio_color_tests[];
+extern struct testcase_t pbio_control_tests[];
+extern struct testcase_t pbio_differentiator_tests[];
 extern struct testcase_t pbio_light_animation_tests[];
 extern struct testcase_t pbio_color_light_tests[];
 extern struct testcase_t pbio_light_matrix_tests[];
 extern struct testcase_t pbio_int_math_tests[];
+extern struct testcase_t pbio_logger_tests[];
+extern struct testcase_t pbio_motion_group_tests[];
+extern struct testcase_t pbio_sysid_tests[];
 extern struct testcase_t pbio_task_tests[];
 extern struct testcase_t pbio_trajectory_tests[];
 extern struct testcase_t pbio_uartdev_tests[];
@@ -99,10 +104,15 @@ static struct testgroup_t test_groups[] = {
     { "src/angle/", pbio_angle_tests },
     { "src/battery/", pbio_battery_tests },
     { "src/color/", pbio_color_tests },
+    { "src/control/", pbio_control_tests },
+    { "src/differentiator/", pbio_differentiator_tests },
     { "src/light/", pbio_light_animation_tests },
     { "src/light/", pbio_color_light_tests },
     { "src/light/", pbio_light_matrix_tests },
+    { "src/logger/", pbio_logger_tests },
     { "src/math/", pbio_int_math_tests },
+    { "src/motion_group/", pbio_motion_group_tests },
+    { "src/sysid/", pbio_sysid_tests },
     { "src/task/", pbio_task_tests, },
     { "src/trajectory/", pbio_trajectory_tests },
     { "src/uartdev/", pbio_uartdev_tests, },
@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <pbio/button.h>
+#include <pbio/dcmotor.h>
 
 // Use this macro to define tests that _don't_ require a Contiki event loop
 #define PBIO_TEST(name) \
@@ -19,6 +20,9 @@
 void pbio_test_run_thread(void *env);
 extern struct testcase_setup_t pbio_test_setup;
 
+// this can be used by tests that consume the battery driver
+void pbio_test_battery_set_voltage(uint16_t voltage);
+
 // this can be used by tests that consume the button driver
 void pbio_test_button_set_pressed(pbio_button_flags_t flags);
 
@@ -42,6 +46,25 @@ pbio_test_bluetooth_control_state_t pbio_test_bluetooth_get_control_state(void);
 
 // these can be used by tests that consume a counter device
 void pbio_test_counter_set_angle(int32_t rotations, int32_t millidegrees);
+void pbio_test_counter_set_dev_angle(uint8_t id, int32_t rotations, int32_t millidegrees);
 void pbio_test_counter_set_abs_angle(int32_t millidegrees);
+void pbio_test_counter_set_edge_time(uint32_t time_us);
+
+// Parameters of a simulated motor similar to a SPIKE Medium Motor. It runs
+// at about 1000 deg/s at 9 V, with 300 mV needed to overcome friction.
+#define PBIO_TEST_MOTOR_ALPHA (0.9)
+#define PBIO_TEST_MOTOR_BETA (0.0555)
+#define PBIO_TEST_MOTOR_FRICTION_VOLTAGE (300)
+#define PBIO_TEST_MOTOR_GAMMA (PBIO_TEST_MOTOR_BETA * PBIO_TEST_MOTOR_FRICTION_VOLTAGE)
+
+// Exact angle (mdeg) and increment per step of a simulated motor.
+typedef struct {
+    double angle;
+    double increment;
+} pbio_test_motor_t;
+
+// this can be used by tests that run servos, to simulate one motor step with
+// the voltage applied to the motor and update the counter with the given id
+void pbio_test_motor_step(pbio_test_motor_t *motor, uint8_t id, pbio_dcmotor_t *dcmotor);
 
 #endif // _TEST_PBIO_H_
@@ -143,6 +143,61 @@ STATIC mp_obj_t common_Control_pid(size_t n_args, const mp_obj_t *pos_args, mp_m
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Control_pid_obj, 1, common_Control_pid);
 
+// pybricks._common.Control.gain_schedule
+STATIC mp_obj_t common_Control_gain_schedule(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        common_Control_obj_t, self,
+        PB_ARG_DEFAULT_NONE(speed),
+        PB_ARG_DEFAULT_NONE(load));
+
+    // Ordered like pbio_control_settings_gain_schedule_input_t.
+    mp_obj_t schedules_in[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM] = { speed_in, load_in };
+    pbio_int_math_point_t points[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX];
+
+    // If all given values are none, return current values
+    if (speed_in == mp_const_none && load_in == mp_const_none) {
+        mp_obj_t ret[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM];
+        for (uint8_t i = 0; i < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM; i++) {
+            uint8_t num_points = pbio_control_settings_get_gain_schedule(&self->control->settings, i, points);
+            mp_obj_t point_objs[PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX];
+            for (uint8_t j = 0; j < num_points; j++) {
+                mp_obj_t xy[] = { mp_obj_new_int(points[j].x), mp_obj_new_int(points[j].y) };
+                point_objs[j] = mp_obj_new_tuple(2, xy);
+            }
+            ret[i] = mp_obj_new_tuple(num_points, point_objs);
+        }
+        return mp_obj_new_tuple(PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM, ret);
+    }
+
+    // Set the given schedules. Each is a list of (condition, factor) pairs.
+    for (uint8_t i = 0; i < PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_NUM; i++) {
+        if (schedules_in[i] == mp_const_none) {
+            continue;
+        }
+        size_t num_points;
+        mp_obj_t *point_objs;
+        mp_obj_get_array(schedules_in[i], &num_points, &point_objs);
+        if (num_points > PBIO_CONTROL_SETTINGS_GAIN_SCHEDULE_POINTS_MAX) {
+            pb_assert(PBIO_ERROR_INVALID_ARG);
+        }
+        for (size_t j = 0; j < num_points; j++) {
+            mp_obj_t *xy;
+            mp_obj_get_array_fixed_n(point_objs[j], 2, &xy);
+            mp_int_t x = pb_obj_get_int(xy[0]);
+            mp_int_t y = pb_obj_get_int(xy[1]);
+            if (x < 0 || x > INT16_MAX || y < 0 || y > INT16_MAX) {
+                pb_assert(PBIO_ERROR_INVALID_ARG);
+            }
+            points[j] = (pbio_int_math_point_t) { .x = x, .y = y };
+        }
+        pb_assert(pbio_control_settings_set_gain_schedule(&self->control->settings, i, points, num_points));
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Control_gain_schedule_obj, 1, common_Control_gain_schedule);
+
 // pybricks._common.Control.target_tolerances
 STATIC mp_obj_t common_Control_target_tolerances(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -204,6 +259,27 @@ STATIC mp_obj_t common_Control_stall_tolerances(size_t n_args, const mp_obj_t *p
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Control_stall_tolerances_obj, 1, common_Control_stall_tolerances);
 
+// pybricks._common.Control.smooth
+STATIC mp_obj_t common_Control_smooth(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        common_Control_obj_t, self,
+        PB_ARG_DEFAULT_NONE(enabled));
+
+    pbio_control_settings_t *settings = &self->control->settings;
+
+    // If no value is given, return current value
+    if (enabled_in == mp_const_none) {
+        return mp_obj_new_bool(settings->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE);
+    }
+
+    // Set user setting. It applies from the next command onwards.
+    settings->profile = mp_obj_is_true(enabled_in) ? PBIO_TRAJECTORY_PROFILE_S_CURVE : PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Control_smooth_obj, 1, common_Control_smooth);
+
 // pybricks._common.Control.trajectory
 STATIC mp_obj_t common_Control_trajectory(mp_obj_t self_in) {
     common_Control_obj_t *self = MP_OBJ_TO_PTR(self_in);
@@ -269,8 +345,10 @@ MP_DEFINE_CONST_FUN_OBJ_1(common_Control_stalled_obj, common_Control_stalled);
 STATIC const mp_rom_map_elem_t common_Control_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_limits), MP_ROM_PTR(&common_Control_limits_obj) },
     { MP_ROM_QSTR(MP_QSTR_pid), MP_ROM_PTR(&common_Control_pid_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gain_schedule), MP_ROM_PTR(&common_Control_gain_schedule_obj) },
     { MP_ROM_QSTR(MP_QSTR_target_tolerances), MP_ROM_PTR(&common_Control_target_tolerances_obj) },
     { MP_ROM_QSTR(MP_QSTR_stall_tolerances), MP_ROM_PTR(&common_Control_stall_tolerances_obj) },
+    { MP_ROM_QSTR(MP_QSTR_smooth), MP_ROM_PTR(&common_Control_smooth_obj) },
     { MP_ROM_QSTR(MP_QSTR_trajectory), MP_ROM_PTR(&common_Control_trajectory_obj) },
     { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&common_Control_done_obj) },
     { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&common_Control_load_obj) },
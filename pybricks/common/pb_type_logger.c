@@ -50,11 +50,22 @@ STATIC mp_obj_t tools_Logger_start(size_t n_args, const mp_obj_t *pos_args, mp_m
     PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
         tools_Logger_obj_t, self,
         PB_ARG_REQUIRED(duration),
-        PB_ARG_DEFAULT_INT(down_sample, 1));
+        PB_ARG_DEFAULT_INT(down_sample, 1),
+        PB_ARG_DEFAULT_FALSE(stream),
+        PB_ARG_DEFAULT_FALSE(compress));
+
+    // Streamed data is sent as-is, so it can't be compressed.
+    bool stream = mp_obj_is_true(stream_in);
+    bool compress = mp_obj_is_true(compress_in);
+    if (stream && compress) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
 
-    // Log only one row per divisor samples.
+    // Log only one row per divisor samples. When streaming, the duration only
+    // sets how much data can be buffered before it is sent to the host. When
+    // compressing, the same buffer usually lasts several times longer.
     mp_uint_t down_sample = pbio_int_math_max(pb_obj_get_int(down_sample_in), 1);
-    mp_uint_t num_rows = pb_obj_get_int(duration_in) / PBIO_CONFIG_CONTROL_LOOP_TIME_MS / down_sample;
+    mp_uint_t num_rows = pb_obj_get_int(duration_in) / pbio_control_settings_get_loop_time() / down_sample;
 
     // Size is number of rows times column width. All data are int32.
     mp_int_t size = num_rows * self->num_cols;
@@ -62,7 +73,13 @@ STATIC mp_obj_t tools_Logger_start(size_t n_args, const mp_obj_t *pos_args, mp_m
     self->last_size = size;
 
     // Indicates that background control loops may enter data in log.
-    pbio_logger_start(self->log, self->buf, num_rows, self->num_cols, down_sample);
+    if (stream) {
+        pbio_logger_start_stream(self->log, self->buf, num_rows, self->num_cols, down_sample);
+    } else if (compress) {
+        pbio_logger_start_compressed(self->log, self->buf, num_rows, self->num_cols, down_sample);
+    } else {
+        pbio_logger_start(self->log, self->buf, num_rows, self->num_cols, down_sample);
+    }
 
     return mp_const_none;
 }
@@ -10,6 +10,7 @@
 #include <pbio/dcmotor.h>
 #include <pbio/int_math.h>
 #include <pbio/servo.h>
+#include <pbio/sysid.h>
 
 #include "py/mphal.h"
 #include "py/obj.h"
@@ -332,6 +333,49 @@ STATIC mp_obj_t common_Motor_run_target(size_t n_args, const mp_obj_t *pos_args,
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Motor_run_target_obj, 1, common_Motor_run_target);
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+// pybricks._common.Motor.queue_target
+STATIC mp_obj_t common_Motor_queue_target(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        common_Motor_obj_t, self,
+        PB_ARG_REQUIRED(speed),
+        PB_ARG_REQUIRED(target_angle),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj));
+
+    mp_int_t speed = pb_obj_get_int(speed_in);
+    mp_int_t target_angle = pb_obj_get_int(target_angle_in);
+    pbio_control_on_completion_t then = pb_type_enum_get_value(then_in, &pb_enum_type_Stop);
+
+    // Call pbio with parsed user/default arguments. This returns right away.
+    pb_assert(pbio_servo_queue_target(self->srv, speed, target_angle, then));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Motor_queue_target_obj, 1, common_Motor_queue_target);
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+#if PBIO_CONFIG_SYSID
+// pybricks._common.Motor.identify
+STATIC mp_obj_t common_Motor_identify(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        common_Motor_obj_t, self,
+        PB_ARG_DEFAULT_INT(voltage, 6000));
+
+    // Start identifying the motor model. The motor must be free to rotate.
+    pb_assert(pbio_sysid_start(self->srv, pb_obj_get_int(voltage_in)));
+
+    // Wait until the new model is installed or identification fails.
+    pbio_error_t err;
+    while ((err = pbio_sysid_get_status(self->srv)) == PBIO_ERROR_AGAIN) {
+        mp_hal_delay_ms(5);
+    }
+    pb_assert(err);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Motor_identify_obj, 1, common_Motor_identify);
+#endif // PBIO_CONFIG_SYSID
+
 // pybricks._common.Motor.track_target
 STATIC mp_obj_t common_Motor_track_target(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
@@ -371,6 +415,37 @@ STATIC mp_obj_t common_Motor_load(mp_obj_t self_in) {
 }
 MP_DEFINE_CONST_FUN_OBJ_1(common_Motor_load_obj, common_Motor_load);
 
+// pybricks._common.Motor.speed_filter
+STATIC mp_obj_t common_Motor_speed_filter(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        common_Motor_obj_t, self,
+        PB_ARG_DEFAULT_NONE(window),
+        PB_ARG_DEFAULT_NONE(response_time));
+
+    // If no values are given, return current values. Only the value of the
+    // method in use is given, the other is None.
+    if (window_in == mp_const_none && response_time_in == mp_const_none) {
+        pbio_differentiator_filter_t filter;
+        uint32_t time_ms;
+        pb_assert(pbio_servo_get_speed_filter(self->srv, &filter, &time_ms));
+        mp_obj_t ret[] = { mp_const_none, mp_const_none };
+        ret[filter == PBIO_DIFFERENTIATOR_FILTER_WINDOW ? 0 : 1] = mp_obj_new_int_from_uint(time_ms);
+        return mp_obj_new_tuple(2, ret);
+    }
+
+    // Either average over a window, or track with an alpha-beta filter.
+    if (window_in != mp_const_none && response_time_in != mp_const_none) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    if (window_in != mp_const_none) {
+        pb_assert(pbio_servo_set_speed_filter(self->srv, PBIO_DIFFERENTIATOR_FILTER_WINDOW, pb_obj_get_positive_int(window_in)));
+    } else {
+        pb_assert(pbio_servo_set_speed_filter(self->srv, PBIO_DIFFERENTIATOR_FILTER_ALPHA_BETA, pb_obj_get_positive_int(response_time_in)));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(common_Motor_speed_filter_obj, 1, common_Motor_speed_filter);
+
 // dir(pybricks.builtins.Motor)
 STATIC const mp_rom_map_elem_t common_Motor_locals_dict_table[] = {
     //
@@ -396,7 +471,14 @@ STATIC const mp_rom_map_elem_t common_Motor_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_stalled), MP_ROM_PTR(&common_Motor_stalled_obj) },
     { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&common_Motor_done_obj) },
     { MP_ROM_QSTR(MP_QSTR_track_target), MP_ROM_PTR(&common_Motor_track_target_obj) },
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    { MP_ROM_QSTR(MP_QSTR_queue_target), MP_ROM_PTR(&common_Motor_queue_target_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&common_Motor_load_obj) },
+    { MP_ROM_QSTR(MP_QSTR_speed_filter), MP_ROM_PTR(&common_Motor_speed_filter_obj) },
+    #if PBIO_CONFIG_SYSID
+    { MP_ROM_QSTR(MP_QSTR_identify), MP_ROM_PTR(&common_Motor_identify_obj) },
+    #endif
 };
 MP_DEFINE_CONST_DICT(common_Motor_locals_dict, common_Motor_locals_dict_table);
 
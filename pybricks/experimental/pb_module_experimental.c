@@ -11,6 +11,8 @@
 #include "py/runtime.h"
 #include "py/mperrno.h"
 
+#include <pbio/config.h>
+#include <pbio/control_settings.h>
 #include <pbio/util.h>
 
 #include <pybricks/util_mp/pb_obj_helper.h>
@@ -54,6 +56,76 @@ STATIC mp_obj_t mod_experimental_pthread_raise(mp_obj_t thread_id_in, mp_obj_t e
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_experimental_pthread_raise_obj, mod_experimental_pthread_raise);
 #endif // PYBRICKS_HUB_EV3BRICK
 
+#if PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+#include <pbio/motor_process.h>
+
+STATIC mp_obj_t experimental_timing_to_tuple(const pbio_motor_process_timing_t *timing) {
+    mp_obj_t values[] = {
+        mp_obj_new_int(timing->min),
+        mp_obj_new_int(pbio_motor_process_timing_get_mean(timing)),
+        mp_obj_new_int(timing->max),
+    };
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(values), values);
+}
+
+// pybricks.experimental.control_loop_profile
+STATIC mp_obj_t experimental_control_loop_profile(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_DEFAULT_FALSE(reset));
+
+    const pbio_motor_process_profile_t *profile = pbio_motor_process_get_profile();
+
+    // Execution time of each stage and the loop period as (min, mean, max) in microseconds.
+    mp_obj_t timings[PBIO_MOTOR_PROCESS_NUM_STAGES + 1];
+    for (uint8_t i = 0; i < PBIO_MOTOR_PROCESS_NUM_STAGES; i++) {
+        timings[i] = experimental_timing_to_tuple(&profile->stages[i]);
+    }
+    timings[PBIO_MOTOR_PROCESS_NUM_STAGES] = experimental_timing_to_tuple(&profile->period);
+
+    // Jitter histogram with bins of PBIO_MOTOR_PROCESS_JITTER_BIN_US.
+    mp_obj_t jitter[PBIO_MOTOR_PROCESS_JITTER_NUM_BINS];
+    for (uint8_t i = 0; i < PBIO_MOTOR_PROCESS_JITTER_NUM_BINS; i++) {
+        jitter[i] = mp_obj_new_int(profile->jitter[i]);
+    }
+
+    // Returns (battery, drivebase, servo, period, jitter, overruns, late).
+    mp_obj_t ret[] = {
+        timings[PBIO_MOTOR_PROCESS_STAGE_BATTERY],
+        timings[PBIO_MOTOR_PROCESS_STAGE_DRIVEBASE],
+        timings[PBIO_MOTOR_PROCESS_STAGE_SERVO],
+        timings[PBIO_MOTOR_PROCESS_NUM_STAGES],
+        mp_obj_new_tuple(MP_ARRAY_SIZE(jitter), jitter),
+        mp_obj_new_int(profile->num_overruns),
+        mp_obj_new_int(profile->num_late),
+    };
+
+    // Optionally start over, so the next call gives results for a new interval.
+    if (mp_obj_is_true(reset_in)) {
+        pbio_motor_process_profile_reset();
+    }
+
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(ret), ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(experimental_control_loop_profile_obj, 0, experimental_control_loop_profile);
+
+#endif // PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+
+// pybricks.experimental.control_loop_time
+STATIC mp_obj_t experimental_control_loop_time(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
+        PB_ARG_DEFAULT_NONE(time));
+
+    // Set new loop time if given.
+    if (time_in != mp_const_none) {
+        mp_int_t time = pb_obj_get_int(time_in);
+        pb_assert(pbio_control_settings_set_loop_time(time < 0 ? 0 : time));
+    }
+
+    return mp_obj_new_int(pbio_control_settings_get_loop_time());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(experimental_control_loop_time_obj, 0, experimental_control_loop_time);
+
 // pybricks.experimental.hello_world
 STATIC mp_obj_t experimental_hello_world(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_FUNCTION(n_args, pos_args, kw_args,
@@ -101,6 +173,10 @@ STATIC const mp_rom_map_elem_t experimental_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_experimental) },
     #endif // PYBRICKS_HUB_EV3BRICK
     { MP_ROM_QSTR(MP_QSTR_hello_world), MP_ROM_PTR(&experimental_hello_world_obj) },
+    #if PBIO_CONFIG_MOTOR_PROCESS_PROFILER
+    { MP_ROM_QSTR(MP_QSTR_control_loop_profile), MP_ROM_PTR(&experimental_control_loop_profile_obj) },
+    #endif
+    { MP_ROM_QSTR(MP_QSTR_control_loop_time), MP_ROM_PTR(&experimental_control_loop_time_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_experimental_globals, experimental_globals_table);
 
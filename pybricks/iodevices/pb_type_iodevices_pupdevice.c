@@ -44,9 +44,19 @@ STATIC mp_obj_t iodevices_PUPDevice_info(mp_obj_t self_in) {
 
     pbio_iodev_type_id_t id = pb_device_get_id(self->pbdev);
 
-    mp_obj_t info_dict = mp_obj_new_dict(1);
+    mp_obj_t info_dict = mp_obj_new_dict(2);
     mp_obj_dict_store(info_dict, MP_ROM_QSTR(MP_QSTR_id), MP_OBJ_NEW_SMALL_INT(id));
 
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    // Size of one sample of each mode as returned by read_history().
+    uint8_t num_modes = pb_device_get_num_modes(self->pbdev);
+    mp_obj_t sizes[PBIO_IODEV_MAX_NUM_MODES];
+    for (uint8_t i = 0; i < num_modes; i++) {
+        sizes[i] = MP_OBJ_NEW_SMALL_INT(pb_device_get_sample_size(self->pbdev, i));
+    }
+    mp_obj_dict_store(info_dict, MP_ROM_QSTR(MP_QSTR_sample_sizes), mp_obj_new_tuple(num_modes, sizes));
+    #endif
+
     return info_dict;
 }
 MP_DEFINE_CONST_FUN_OBJ_1(iodevices_PUPDevice_info_obj, iodevices_PUPDevice_info);
@@ -60,9 +70,10 @@ STATIC mp_obj_t iodevices_PUPDevice_read(size_t n_args, const mp_obj_t *pos_args
     // Get data already in correct data format
     int32_t data[PBIO_IODEV_MAX_DATA_SIZE];
     mp_obj_t objs[PBIO_IODEV_MAX_DATA_SIZE];
-    pb_device_get_values(self->pbdev, mp_obj_get_int(mode_in), data);
+    uint8_t mode = mp_obj_get_int(mode_in);
+    pb_device_get_values(self->pbdev, mode, data);
 
-    uint8_t num_values = pb_device_get_num_values(self->pbdev);
+    uint8_t num_values = pb_device_get_num_values(self->pbdev, mode);
 
     // Return as MicroPython objects
     for (uint8_t i = 0; i < num_values; i++) {
@@ -73,6 +84,104 @@ STATIC mp_obj_t iodevices_PUPDevice_read(size_t n_args, const mp_obj_t *pos_args
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_read_obj, 1, iodevices_PUPDevice_read);
 
+// pybricks.iodevices.PUPDevice.combine
+STATIC mp_obj_t iodevices_PUPDevice_combine(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_PUPDevice_obj_t, self,
+        PB_ARG_REQUIRED(modes));
+
+    // Unpack the modes
+    mp_obj_t *objs;
+    size_t num_modes;
+    mp_obj_get_array(modes_in, &num_modes, &objs);
+    if (num_modes > PBIO_IODEV_MAX_COMBI_MODES) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    uint8_t modes[PBIO_IODEV_MAX_COMBI_MODES];
+    for (uint8_t i = 0; i < num_modes; i++) {
+        modes[i] = mp_obj_get_int(objs[i]);
+    }
+
+    // Stream the modes together until another mode is read or written, so
+    // that reading any of them does not switch modes.
+    return mp_obj_new_bool(pb_device_set_combi_mode(self->pbdev, modes, num_modes));
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_combine_obj, 1, iodevices_PUPDevice_combine);
+
+// pybricks.iodevices.PUPDevice.read_nowait
+STATIC mp_obj_t iodevices_PUPDevice_read_nowait(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_PUPDevice_obj_t, self,
+        PB_ARG_REQUIRED(mode));
+
+    // Get the most recent fresh data, which may be of another mode while
+    // the device switches to the requested mode.
+    int32_t data[PBIO_IODEV_MAX_DATA_SIZE];
+    mp_obj_t objs[PBIO_IODEV_MAX_DATA_SIZE];
+    uint8_t data_mode;
+    uint32_t age;
+    pb_device_get_values_nowait(self->pbdev, mp_obj_get_int(mode_in), data, &data_mode, &age);
+
+    uint8_t num_values = pb_device_get_num_values(self->pbdev, data_mode);
+
+    for (uint8_t i = 0; i < num_values; i++) {
+        objs[i] = mp_obj_new_int(data[i]);
+    }
+
+    // Return the values along with their mode and age (ms)
+    mp_obj_t ret[] = {
+        mp_obj_new_tuple(num_values, objs),
+        MP_OBJ_NEW_SMALL_INT(data_mode),
+        mp_obj_new_int_from_uint(age),
+    };
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(ret), ret);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_read_nowait_obj, 1, iodevices_PUPDevice_read_nowait);
+
+#if PBIO_CONFIG_IODEV_HISTORY_SIZE
+// Gets the samples of one mode that were received since the previous call.
+STATIC mp_obj_t iodevices_PUPDevice_get_history(iodevices_PUPDevice_obj_t *self, mp_obj_t mode_in) {
+    // Room for all samples that can be kept, each with a 4 byte timestamp.
+    vstr_t vstr;
+    vstr_init_len(&vstr, PBIO_CONFIG_IODEV_HISTORY_SIZE * (4 + PBIO_IODEV_MAX_DATA_SIZE));
+
+    // Get all samples of this mode since the last read
+    vstr.len = pb_device_get_history(self->pbdev, mp_obj_get_int(mode_in), (uint8_t *)vstr.buf, vstr.len);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+
+// pybricks.iodevices.PUPDevice.read_history
+//
+// Returns the samples of the given mode that were received since the
+// previous call, each as a 4 byte timestamp (ms) followed by the raw data.
+// The size of each sample is given by info()["sample_sizes"]. Samples of
+// other modes are kept until their mode is read. Given a list
+// of modes, such as those of a mode combination, this returns a tuple with
+// the samples of each mode.
+STATIC mp_obj_t iodevices_PUPDevice_read_history(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        iodevices_PUPDevice_obj_t, self,
+        PB_ARG_REQUIRED(mode));
+
+    if (mp_obj_is_int(mode_in)) {
+        return iodevices_PUPDevice_get_history(self, mode_in);
+    }
+
+    size_t num_modes;
+    mp_obj_t *modes;
+    mp_obj_get_array(mode_in, &num_modes, &modes);
+    if (num_modes > PBIO_IODEV_MAX_COMBI_MODES) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    mp_obj_t samples[PBIO_IODEV_MAX_COMBI_MODES];
+    for (size_t i = 0; i < num_modes; i++) {
+        samples[i] = iodevices_PUPDevice_get_history(self, modes[i]);
+    }
+    return mp_obj_new_tuple(num_modes, samples);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_read_history_obj, 1, iodevices_PUPDevice_read_history);
+#endif // PBIO_CONFIG_IODEV_HISTORY_SIZE
+
 // pybricks.iodevices.PUPDevice.write
 STATIC mp_obj_t iodevices_PUPDevice_write(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
@@ -104,6 +213,11 @@ MP_DEFINE_CONST_FUN_OBJ_KW(iodevices_PUPDevice_write_obj, 1, iodevices_PUPDevice
 // dir(pybricks.iodevices.PUPDevice)
 STATIC const mp_rom_map_elem_t iodevices_PUPDevice_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_read),       MP_ROM_PTR(&iodevices_PUPDevice_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_read_nowait), MP_ROM_PTR(&iodevices_PUPDevice_read_nowait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_combine),    MP_ROM_PTR(&iodevices_PUPDevice_combine_obj) },
+    #if PBIO_CONFIG_IODEV_HISTORY_SIZE
+    { MP_ROM_QSTR(MP_QSTR_read_history), MP_ROM_PTR(&iodevices_PUPDevice_read_history_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_write),      MP_ROM_PTR(&iodevices_PUPDevice_write_obj)},
     { MP_ROM_QSTR(MP_QSTR_info),       MP_ROM_PTR(&iodevices_PUPDevice_info_obj)},
 };
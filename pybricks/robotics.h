@@ -10,12 +10,17 @@
 
 #include <math.h>
 
+#include <pbio/config.h>
+
 #include "py/obj.h"
 
 #include "pybricks/util_mp/pb_obj_helper.h"
 
 extern const pb_obj_with_attr_type_t pb_type_drivebase;
 extern const pb_obj_with_attr_type_t pb_type_spikebase;
+#if PBIO_CONFIG_MOTION_GROUP
+extern const pb_obj_with_attr_type_t pb_type_motiongroup;
+#endif
 
 #endif // PYBRICKS_PY_ROBOTICS
 
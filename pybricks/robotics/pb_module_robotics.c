@@ -14,6 +14,9 @@ STATIC const mp_rom_map_elem_t robotics_globals_table[] = {
     #if (PYBRICKS_HUB_PRIMEHUB || PYBRICKS_HUB_ESSENTIALHUB)
     { MP_ROM_QSTR(MP_QSTR_SpikeBase),   MP_ROM_PTR(&pb_type_spikebase)  },
     #endif
+    #if PBIO_CONFIG_MOTION_GROUP
+    { MP_ROM_QSTR(MP_QSTR_MotionGroup), MP_ROM_PTR(&pb_type_motiongroup) },
+    #endif
     #endif
 };
 STATIC MP_DEFINE_CONST_DICT(pb_module_robotics_globals, robotics_globals_table);
@@ -157,6 +157,42 @@ STATIC mp_obj_t robotics_DriveBase_curve(size_t n_args, const mp_obj_t *pos_args
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_DriveBase_curve_obj, 1, robotics_DriveBase_curve);
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+// pybricks.robotics.DriveBase.queue_straight
+STATIC mp_obj_t robotics_DriveBase_queue_straight(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        robotics_DriveBase_obj_t, self,
+        PB_ARG_REQUIRED(distance),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj));
+
+    mp_int_t distance = pb_obj_get_int(distance_in);
+    pbio_control_on_completion_t then = pb_type_enum_get_value(then_in, &pb_enum_type_Stop);
+
+    pb_assert(pbio_drivebase_queue_straight(self->db, distance, then));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_DriveBase_queue_straight_obj, 1, robotics_DriveBase_queue_straight);
+
+// pybricks.robotics.DriveBase.queue_curve
+STATIC mp_obj_t robotics_DriveBase_queue_curve(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        robotics_DriveBase_obj_t, self,
+        PB_ARG_REQUIRED(radius),
+        PB_ARG_REQUIRED(angle),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj));
+
+    mp_int_t radius = pb_obj_get_int(radius_in);
+    mp_int_t angle = pb_obj_get_int(angle_in);
+    pbio_control_on_completion_t then = pb_type_enum_get_value(then_in, &pb_enum_type_Stop);
+
+    pb_assert(pbio_drivebase_queue_curve(self->db, radius, angle, then));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_DriveBase_queue_curve_obj, 1, robotics_DriveBase_queue_curve);
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 // pybricks.robotics.DriveBase.drive
 STATIC mp_obj_t robotics_DriveBase_drive(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
@@ -288,6 +324,10 @@ STATIC const mp_rom_map_elem_t robotics_DriveBase_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_curve),            MP_ROM_PTR(&robotics_DriveBase_curve_obj)    },
     { MP_ROM_QSTR(MP_QSTR_straight),         MP_ROM_PTR(&robotics_DriveBase_straight_obj) },
     { MP_ROM_QSTR(MP_QSTR_turn),             MP_ROM_PTR(&robotics_DriveBase_turn_obj)     },
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    { MP_ROM_QSTR(MP_QSTR_queue_curve),      MP_ROM_PTR(&robotics_DriveBase_queue_curve_obj) },
+    { MP_ROM_QSTR(MP_QSTR_queue_straight),   MP_ROM_PTR(&robotics_DriveBase_queue_straight_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_drive),            MP_ROM_PTR(&robotics_DriveBase_drive_obj)    },
     { MP_ROM_QSTR(MP_QSTR_stop),             MP_ROM_PTR(&robotics_DriveBase_stop_obj)     },
     { MP_ROM_QSTR(MP_QSTR_distance),         MP_ROM_PTR(&robotics_DriveBase_distance_obj) },
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 The Pybricks Authors
+
+#include "py/mpconfig.h"
+
+#include <pbio/config.h>
+
+#if PYBRICKS_PY_ROBOTICS && PYBRICKS_PY_COMMON_MOTORS && PBIO_CONFIG_MOTION_GROUP
+
+#include <pbio/motion_group.h>
+
+#include "py/mphal.h"
+
+#include <pybricks/common.h>
+#include <pybricks/parameters.h>
+
+#include <pybricks/util_mp/pb_kwarg_helper.h>
+#include <pybricks/util_mp/pb_obj_helper.h>
+#include <pybricks/util_pb/pb_error.h>
+
+// pybricks.robotics.MotionGroup class object
+typedef struct _robotics_MotionGroup_obj_t {
+    mp_obj_base_t base;
+    pbio_motion_group_t *group;
+    mp_obj_t motors;
+} robotics_MotionGroup_obj_t;
+
+// pybricks.robotics.MotionGroup.__init__
+STATIC mp_obj_t robotics_MotionGroup_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+
+    PB_PARSE_ARGS_CLASS(n_args, n_kw, args,
+        PB_ARG_REQUIRED(motors));
+
+    size_t num_motors;
+    mp_obj_t *motors;
+    mp_obj_get_array(motors_in, &num_motors, &motors);
+    if (num_motors > PBDRV_CONFIG_NUM_MOTOR_CONTROLLER) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+
+    robotics_MotionGroup_obj_t *self = m_new_obj(robotics_MotionGroup_obj_t);
+    self->base.type = (mp_obj_type_t *)type;
+    self->motors = mp_obj_new_tuple(num_motors, motors);
+
+    // Pointers to servos
+    pbio_servo_t *axes[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    for (size_t i = 0; i < num_motors; i++) {
+        axes[i] = ((common_Motor_obj_t *)pb_obj_get_base_class_obj(motors[i], &pb_type_Motor.type))->srv;
+    }
+
+    // Create motion group
+    pb_assert(pbio_motion_group_get_motion_group(&self->group, axes, num_motors));
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Gets one integer per motor in the group.
+STATIC void robotics_MotionGroup_get_values(robotics_MotionGroup_obj_t *self, mp_obj_t values_in, int32_t *values) {
+    size_t num_values;
+    mp_obj_t *values_obj;
+    mp_obj_get_array(values_in, &num_values, &values_obj);
+    if (num_values != self->group->num_axes) {
+        pb_assert(PBIO_ERROR_INVALID_ARG);
+    }
+    for (size_t i = 0; i < num_values; i++) {
+        values[i] = pb_obj_get_int(values_obj[i]);
+    }
+}
+
+STATIC void wait_for_completion_motion_group(pbio_motion_group_t *group) {
+    while (!pbio_motion_group_is_done(group)) {
+        mp_hal_delay_ms(5);
+    }
+    if (!pbio_motion_group_update_loop_is_running(group)) {
+        pb_assert(PBIO_ERROR_NO_DEV);
+    }
+}
+
+// pybricks.robotics.MotionGroup.run_target
+STATIC mp_obj_t robotics_MotionGroup_run_target(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        robotics_MotionGroup_obj_t, self,
+        PB_ARG_REQUIRED(speed),
+        PB_ARG_REQUIRED(target_angles),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj),
+        PB_ARG_DEFAULT_TRUE(wait));
+
+    mp_int_t speed = pb_obj_get_int(speed_in);
+    int32_t targets[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    robotics_MotionGroup_get_values(self, target_angles_in, targets);
+    pbio_control_on_completion_t then = pb_type_enum_get_value(then_in, &pb_enum_type_Stop);
+
+    pb_assert(pbio_motion_group_run_target(self->group, speed, targets, then));
+
+    if (mp_obj_is_true(wait_in)) {
+        wait_for_completion_motion_group(self->group);
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_MotionGroup_run_target_obj, 1, robotics_MotionGroup_run_target);
+
+// pybricks.robotics.MotionGroup.run_angle
+STATIC mp_obj_t robotics_MotionGroup_run_angle(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        robotics_MotionGroup_obj_t, self,
+        PB_ARG_REQUIRED(speed),
+        PB_ARG_REQUIRED(rotation_angles),
+        PB_ARG_DEFAULT_OBJ(then, pb_Stop_HOLD_obj),
+        PB_ARG_DEFAULT_TRUE(wait));
+
+    mp_int_t speed = pb_obj_get_int(speed_in);
+    int32_t angles[PBDRV_CONFIG_NUM_MOTOR_CONTROLLER];
+    robotics_MotionGroup_get_values(self, rotation_angles_in, angles);
+    pbio_control_on_completion_t then = pb_type_enum_get_value(then_in, &pb_enum_type_Stop);
+
+    pb_assert(pbio_motion_group_run_angle(self->group, speed, angles, then));
+
+    if (mp_obj_is_true(wait_in)) {
+        wait_for_completion_motion_group(self->group);
+    }
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(robotics_MotionGroup_run_angle_obj, 1, robotics_MotionGroup_run_angle);
+
+// pybricks.robotics.MotionGroup.stop
+STATIC mp_obj_t robotics_MotionGroup_stop(mp_obj_t self_in) {
+    robotics_MotionGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    pb_assert(pbio_motion_group_stop(self->group, PBIO_CONTROL_ON_COMPLETION_COAST));
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(robotics_MotionGroup_stop_obj, robotics_MotionGroup_stop);
+
+// pybricks.robotics.MotionGroup.done
+STATIC mp_obj_t robotics_MotionGroup_done(mp_obj_t self_in) {
+    robotics_MotionGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(pbio_motion_group_is_done(self->group));
+}
+MP_DEFINE_CONST_FUN_OBJ_1(robotics_MotionGroup_done_obj, robotics_MotionGroup_done);
+
+// pybricks.robotics.MotionGroup.stalled
+STATIC mp_obj_t robotics_MotionGroup_stalled(mp_obj_t self_in) {
+    robotics_MotionGroup_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    bool stalled;
+    uint32_t stall_duration;
+    pb_assert(pbio_motion_group_is_stalled(self->group, &stalled, &stall_duration));
+    return mp_obj_new_bool(stalled);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(robotics_MotionGroup_stalled_obj, robotics_MotionGroup_stalled);
+
+// dir(pybricks.robotics.MotionGroup)
+STATIC const mp_rom_map_elem_t robotics_MotionGroup_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_run_target),       MP_ROM_PTR(&robotics_MotionGroup_run_target_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_angle),        MP_ROM_PTR(&robotics_MotionGroup_run_angle_obj)  },
+    { MP_ROM_QSTR(MP_QSTR_stop),             MP_ROM_PTR(&robotics_MotionGroup_stop_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_done),             MP_ROM_PTR(&robotics_MotionGroup_done_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_stalled),          MP_ROM_PTR(&robotics_MotionGroup_stalled_obj)    },
+};
+STATIC MP_DEFINE_CONST_DICT(robotics_MotionGroup_locals_dict, robotics_MotionGroup_locals_dict_table);
+
+STATIC const pb_attr_dict_entry_t robotics_MotionGroup_attr_dict[] = {
+    PB_DEFINE_CONST_ATTR_RO(MP_QSTR_motors, robotics_MotionGroup_obj_t, motors),
+};
+
+// type(pybricks.robotics.MotionGroup)
+const pb_obj_with_attr_type_t pb_type_motiongroup = {
+    .type = {
+        .base = { .type = &mp_type_type },
+        .name = MP_QSTR_MotionGroup,
+        .make_new = robotics_MotionGroup_make_new,
+        .attr = pb_attribute_handler,
+        .locals_dict = (mp_obj_dict_t *)&robotics_MotionGroup_locals_dict,
+    },
+    .attr_dict = robotics_MotionGroup_attr_dict,
+    .attr_dict_size = MP_ARRAY_SIZE(robotics_MotionGroup_attr_dict),
+};
+
+#endif // PYBRICKS_PY_ROBOTICS && PYBRICKS_PY_COMMON_MOTORS && PBIO_CONFIG_MOTION_GROUP
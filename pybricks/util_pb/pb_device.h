@@ -5,6 +5,7 @@
 #define _PBDEVICE_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <pbio/color.h>
@@ -18,15 +19,25 @@ pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t vali
 
 void pb_device_get_values(pb_device_t *pbdev, uint8_t mode, int32_t *values);
 
+bool pb_device_set_combi_mode(pb_device_t *pbdev, const uint8_t *modes, uint8_t num_modes);
+
+bool pb_device_get_values_nowait(pb_device_t *pbdev, uint8_t mode, int32_t *values, uint8_t *data_mode, uint32_t *age);
+
 void pb_device_set_values(pb_device_t *pbdev, uint8_t mode, int32_t *values, uint8_t num_values);
 
+size_t pb_device_get_history(pb_device_t *pbdev, uint8_t mode, uint8_t *buf, size_t size);
+
+uint8_t pb_device_get_num_modes(pb_device_t *pbdev);
+
+size_t pb_device_get_sample_size(pb_device_t *pbdev, uint8_t mode);
+
 void pb_device_set_power_supply(pb_device_t *pbdev, int32_t duty);
 
 pbio_iodev_type_id_t pb_device_get_id(pb_device_t *pbdev);
 
 uint8_t pb_device_get_mode(pb_device_t *pbdev);
 
-uint8_t pb_device_get_num_values(pb_device_t *pbdev);
+uint8_t pb_device_get_num_values(pb_device_t *pbdev, uint8_t mode);
 
 int8_t pb_device_get_mode_id_from_str(pb_device_t *pbdev, const char *mode_str);
 
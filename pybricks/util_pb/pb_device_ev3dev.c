@@ -235,7 +235,7 @@ uint8_t pb_device_get_mode(pb_device_t *pbdev) {
     return pbdev->mode;
 }
 
-uint8_t pb_device_get_num_values(pb_device_t *pbdev) {
+uint8_t pb_device_get_num_values(pb_device_t *pbdev, uint8_t mode) {
     return pbdev->data_len;
 }
 
@@ -7,6 +7,7 @@
 
 #include <string.h>
 
+#include <pbdrv/clock.h>
 #include <pbdrv/config.h>
 #include <pbdrv/ioport.h>
 #include <pbdrv/motor_driver.h>
@@ -59,18 +60,64 @@ static uint32_t get_mode_switch_delay(pbio_iodev_type_id_t id, uint8_t mode) {
     }
 }
 
+// State of mode switches, which complete in the background when started by
+// pb_device_get_values_nowait().
+typedef struct {
+    // Whether pbio_iodev_set_mode_end() has not succeeded yet.
+    bool pending;
+    // Time (ms) at which the latest mode switch completed.
+    uint32_t start;
+    // Most recent data that was fresh when it was read, along with its mode
+    // and the time it was received.
+    bool valid;
+    uint8_t mode;
+    uint32_t time;
+    uint8_t bin_data[PBIO_IODEV_MAX_DATA_SIZE] __attribute__((aligned(4)));
+} mode_switch_t;
+
+static mode_switch_t mode_switches[PBIO_PORT_ID_F - PBIO_PORT_ID_A + 1];
+
+static mode_switch_t *get_mode_switch(pbio_iodev_t *iodev) {
+    return &mode_switches[iodev->port - PBIO_PORT_ID_A];
+}
+
+// Waits for a mode switch that was started in the background, so that the
+// device accepts new commands.
+static void finish_mode_switch(pbio_iodev_t *iodev) {
+    mode_switch_t *sw = get_mode_switch(iodev);
+    if (sw->pending) {
+        sw->pending = false;
+        wait(pbio_iodev_set_mode_end, pbio_iodev_set_mode_cancel, iodev);
+        sw->start = pbdrv_clock_get_ms();
+    }
+}
+
+// Ports with a device that streams a mode combination that was set with
+// pb_device_set_combi_mode().
+static uint32_t combi_mode_active;
+
+static uint32_t get_port_flag(pbio_iodev_t *iodev) {
+    return 1 << (iodev->port - PBIO_PORT_ID_A);
+}
+
 static void set_mode(pbio_iodev_t *iodev, uint8_t new_mode) {
     pbio_error_t err;
 
-    if (iodev->mode == new_mode) {
+    finish_mode_switch(iodev);
+
+    // The device reports the first mode of a mode combination as its mode,
+    // so the combination must be ended even if that mode is requested.
+    if (iodev->mode == new_mode && !(combi_mode_active & get_port_flag(iodev))) {
         return;
     }
+    combi_mode_active &= ~get_port_flag(iodev);
 
     while ((err = pbio_iodev_set_mode_begin(iodev, new_mode)) == PBIO_ERROR_AGAIN) {
         MICROPY_EVENT_POLL_HOOK
     }
     pb_assert(err);
     wait(pbio_iodev_set_mode_end, pbio_iodev_set_mode_cancel, iodev);
+    get_mode_switch(iodev)->start = pbdrv_clock_get_ms();
 
     // Give some time for the mode to take effect and discard stale data
     uint32_t delay = get_mode_switch_delay(iodev->info->type_id, new_mode);
@@ -79,6 +126,19 @@ static void set_mode(pbio_iodev_t *iodev, uint8_t new_mode) {
     }
 }
 
+// Data of a mode that is streamed in a mode combination is used if it is at
+// most this old (ms).
+#define MODE_DATA_MAX_AGE (100)
+
+// Gets recent data of a mode, if the device streams it in a mode combination.
+static bool get_recent_combi_mode_data(pbio_iodev_t *iodev, uint8_t mode, uint8_t **data) {
+    uint32_t time;
+    if (!(combi_mode_active & get_port_flag(iodev)) || pbio_iodev_get_mode_data(iodev, mode, data, &time) != PBIO_SUCCESS) {
+        return false;
+    }
+    return pbdrv_clock_get_ms() - time <= MODE_DATA_MAX_AGE;
+}
+
 pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t valid_id) {
 
     // Get the iodevice
@@ -91,6 +151,14 @@ pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t vali
     }
     pb_assert(err);
 
+    combi_mode_active &= ~get_port_flag(iodev);
+
+    // Mode switches of a previous device are no longer relevant.
+    mode_switch_t *sw = get_mode_switch(iodev);
+    sw->pending = false;
+    sw->start = pbdrv_clock_get_ms();
+    sw->valid = false;
+
     // Verify the ID or always allow generic LUMP device
     if (iodev->info->type_id != valid_id && valid_id != PBIO_IODEV_TYPE_ID_LUMP_UART) {
         pb_assert(PBIO_ERROR_NO_DEV);
@@ -99,18 +167,8 @@ pb_device_t *pb_device_get_device(pbio_port_id_t port, pbio_iodev_type_id_t vali
     return (pb_device_t *)iodev;
 }
 
-void pb_device_get_values(pb_device_t *pbdev, uint8_t mode, int32_t *values) {
-
-    pbio_iodev_t *iodev = &pbdev->iodev;
-
-    uint8_t *data;
-    uint8_t len;
-    pbio_iodev_data_type_t type;
-
-    set_mode(iodev, mode);
-
-    pb_assert(pbio_iodev_get_data(iodev, &data));
-    pb_assert(pbio_iodev_get_data_format(iodev, iodev->mode, &len, &type));
+// Converts raw data to values, in the format given by the mode.
+static void get_values_from_data(const uint8_t *data, uint8_t len, pbio_iodev_data_type_t type, int32_t *values) {
 
     if (len == 0) {
         pb_assert(PBIO_ERROR_IO);
@@ -138,6 +196,177 @@ void pb_device_get_values(pb_device_t *pbdev, uint8_t mode, int32_t *values) {
     }
 }
 
+void pb_device_get_values(pb_device_t *pbdev, uint8_t mode, int32_t *values) {
+
+    pbio_iodev_t *iodev = &pbdev->iodev;
+
+    uint8_t *data;
+    uint8_t len;
+    pbio_iodev_data_type_t type;
+
+    pb_assert(pbio_iodev_get_data_format(iodev, mode, &len, &type));
+
+    // Modes that are streamed together can be read without a mode switch.
+    if (!get_recent_combi_mode_data(iodev, mode, &data)) {
+        set_mode(iodev, mode);
+        pb_assert(pbio_iodev_get_data(iodev, &data));
+    }
+
+    get_values_from_data(data, len, type, values);
+}
+
+// Streams several modes at the same time, so that pb_device_get_values() can
+// read any of them without a mode switch, until another mode is read or set.
+// Returns false if the device does not support this combination, in which
+// case the modes are read with mode switches as usual.
+bool pb_device_set_combi_mode(pb_device_t *pbdev, const uint8_t *modes, uint8_t num_modes) {
+
+    pbio_iodev_t *iodev = &pbdev->iodev;
+    pbio_error_t err;
+
+    finish_mode_switch(iodev);
+    combi_mode_active &= ~get_port_flag(iodev);
+
+    while ((err = pbio_iodev_set_combi_mode_begin(iodev, modes, num_modes)) == PBIO_ERROR_AGAIN) {
+        MICROPY_EVENT_POLL_HOOK
+    }
+    if (err == PBIO_ERROR_INVALID_ARG || err == PBIO_ERROR_NOT_SUPPORTED) {
+        return false;
+    }
+    pb_assert(err);
+    wait(pbio_iodev_set_combi_mode_end, pbio_iodev_set_combi_mode_cancel, iodev);
+    combi_mode_active |= get_port_flag(iodev);
+    get_mode_switch(iodev)->start = pbdrv_clock_get_ms();
+
+    // Not all devices accept every combination they report, so go back to
+    // a single mode if the data does not arrive.
+    uint8_t *data;
+    uint32_t start = pbdrv_clock_get_ms();
+    while (!get_recent_combi_mode_data(iodev, modes[num_modes - 1], &data)) {
+        if (pbdrv_clock_get_ms() - start > MODE_DATA_MAX_AGE) {
+            set_mode(iodev, modes[0]);
+            return false;
+        }
+        MICROPY_EVENT_POLL_HOOK
+    }
+
+    // Give some time for the modes to take effect and discard stale data
+    uint32_t delay = get_mode_switch_delay(iodev->info->type_id, modes[0]);
+    if (delay > 0) {
+        mp_hal_delay_ms(delay);
+    }
+    return true;
+}
+
+// Gets the most recent data of a mode that the device streams, along with
+// the time it was received.
+static bool get_streamed_data(pbio_iodev_t *iodev, uint8_t mode, uint8_t **data, uint32_t *time) {
+    pbio_error_t err = pbio_iodev_get_mode_data(iodev, mode, data, time);
+    if (err != PBIO_ERROR_NOT_SUPPORTED) {
+        return err == PBIO_SUCCESS;
+    }
+
+    // Without data per mode, only the data of the active mode is known.
+    if (iodev->mode != mode) {
+        return false;
+    }
+    *data = iodev->bin_data;
+    *time = iodev->time;
+    return true;
+}
+
+// Gets the most recent fresh values without waiting. If the device does not
+// stream the requested mode, the mode switch is started and completes in the
+// background, while the values of the previous mode are returned. Modes that
+// are streamed, such as those in a mode combination, are read without a mode
+// switch. Data is fresh if it arrived at least the mode switch delay after
+// the latest mode switch completed. Returns true if the values are of the
+// requested mode.
+bool pb_device_get_values_nowait(pb_device_t *pbdev, uint8_t mode, int32_t *values, uint8_t *data_mode, uint32_t *age) {
+
+    pbio_iodev_t *iodev = &pbdev->iodev;
+    mode_switch_t *sw = get_mode_switch(iodev);
+    pbio_error_t err;
+
+    uint8_t len;
+    pbio_iodev_data_type_t type;
+    pb_assert(pbio_iodev_get_data_format(iodev, mode, &len, &type));
+
+    // Make progress on a mode switch that was started earlier.
+    if (sw->pending) {
+        err = pbio_iodev_set_mode_end(iodev);
+        if (err != PBIO_ERROR_AGAIN) {
+            sw->pending = false;
+            pb_assert(err);
+            sw->start = pbdrv_clock_get_ms();
+        }
+    }
+
+    // Start switching to the requested mode if it isn't streamed. If the
+    // device is busy, this is tried again on the next call.
+    uint8_t *data;
+    uint32_t time;
+    bool streamed = !sw->pending && get_streamed_data(iodev, mode, &data, &time);
+    if (!sw->pending && !streamed && iodev->mode != mode) {
+        err = pbio_iodev_set_mode_begin(iodev, mode);
+        if (err == PBIO_SUCCESS) {
+            sw->pending = true;
+            combi_mode_active &= ~get_port_flag(iodev);
+        } else if (err != PBIO_ERROR_AGAIN) {
+            pb_assert(err);
+        }
+    }
+
+    // Data received too soon after a mode switch may be stale, so it is only
+    // used once the delay for this device has passed.
+    uint32_t delay = get_mode_switch_delay(iodev->info->type_id, mode);
+    if (streamed && (int32_t)(time - sw->start) >= (int32_t)delay) {
+        memcpy(sw->bin_data, data, sizeof(sw->bin_data));
+        sw->mode = mode;
+        sw->time = time;
+        sw->valid = true;
+    }
+
+    // Until data is fresh for the first time, use whatever the device sent.
+    if (!sw->valid) {
+        memcpy(sw->bin_data, iodev->bin_data, sizeof(sw->bin_data));
+        sw->mode = iodev->mode;
+        sw->time = iodev->time;
+        sw->valid = true;
+    }
+
+    pb_assert(pbio_iodev_get_data_format(iodev, sw->mode, &len, &type));
+    get_values_from_data(sw->bin_data, len, type, values);
+    *data_mode = sw->mode;
+    *age = pbdrv_clock_get_ms() - sw->time;
+
+    return sw->mode == mode;
+}
+
+// Gets the number of modes of the device.
+uint8_t pb_device_get_num_modes(pb_device_t *pbdev) {
+    return pbdev->iodev.info->num_modes;
+}
+
+// Gets the size of one sample of a mode in the buffer written by
+// pb_device_get_history(), including its timestamp.
+size_t pb_device_get_sample_size(pb_device_t *pbdev, uint8_t mode) {
+    uint8_t len;
+    pbio_iodev_data_type_t type;
+    pb_assert(pbio_iodev_get_data_format(&pbdev->iodev, mode, &len, &type));
+    return 4 + len * pbio_iodev_size_of(type);
+}
+
+// Reads the samples of a mode that were received since the previous call.
+// Each sample is written to buf as a little-endian 32-bit timestamp (ms)
+// followed by the raw data of the mode. Samples of other modes are kept.
+// Returns the number of bytes written.
+size_t pb_device_get_history(pb_device_t *pbdev, uint8_t mode, uint8_t *buf, size_t size) {
+    size_t written;
+    pb_assert(pbio_iodev_read_history(&pbdev->iodev, mode, buf, size, &written));
+    return written;
+}
+
 void pb_device_set_values(pb_device_t *pbdev, uint8_t mode, int32_t *values, uint8_t num_values) {
 
     pbio_iodev_t *iodev = &pbdev->iodev;
@@ -218,8 +447,8 @@ uint8_t pb_device_get_mode(pb_device_t *pbdev) {
     return pbdev->iodev.mode;
 }
 
-uint8_t pb_device_get_num_values(pb_device_t *pbdev) {
-    return pbdev->iodev.info->mode_info[pbdev->iodev.mode].num_values;
+uint8_t pb_device_get_num_values(pb_device_t *pbdev, uint8_t mode) {
+    return pbdev->iodev.info->mode_info[mode].num_values;
 }
 
 int8_t pb_device_get_mode_id_from_str(pb_device_t *pbdev, const char *mode_str) {
@@ -0,0 +1,58 @@
+from pybricks.pupdevices import Motor
+from pybricks.tools import wait, StopWatch
+from pybricks.parameters import Port
+from pybricks.experimental import control_loop_time
+from pybricks import version
+
+from umath import sin, pi
+
+try:
+    from pybricks.experimental import control_loop_profile
+except ImportError:
+    control_loop_profile = None
+
+print(version)
+
+# Initialize the motor.
+motor = Motor(Port.A)
+
+# Duration of each test in milliseconds.
+DURATION = 3000
+
+print("loop time (ms), mean error (deg), max error (deg), servo time (us)")
+
+for loop_time in (2, 5, 10, 15, 20):
+    # Loop times below 5 ms are not available on all hubs.
+    try:
+        control_loop_time(loop_time)
+    except ValueError:
+        print(loop_time, "not supported")
+        continue
+
+    # Start from a known state.
+    motor.reset_angle(0)
+    wait(100)
+    if control_loop_profile:
+        control_loop_profile(reset=True)
+
+    # Track a sine pattern and measure how far the motor lags behind.
+    error_sum = 0
+    error_max = 0
+    samples = 0
+    watch = StopWatch()
+    while watch.time() < DURATION:
+        target = sin(watch.time() / 1000 * 2 * pi) * 180
+        motor.track_target(target)
+        wait(1)
+        error = abs(target - motor.angle())
+        error_sum += error
+        error_max = max(error_max, error)
+        samples += 1
+
+    motor.stop()
+
+    # Mean servo stage execution time per loop iteration, if available.
+    servo_time = control_loop_profile()[2][1] if control_loop_profile else None
+    print(loop_time, error_sum / samples, error_max, servo_time)
+
+control_loop_time(5)
@@ -0,0 +1,59 @@
+"""
+Hardware Module: Prime Hub, Inventor Hub, or Essential Hub, with any Powered
+Up sensors or motors attached. Other hubs don't keep a sample history.
+
+Description: Measures how many data samples per second the hub receives from
+each attached device in mode 0, and the longest time between two samples.
+Devices send data at the baud rate they give in their INFO messages, so this
+shows how fresh the data is that the hub gets from each of them.
+"""
+
+from pybricks.iodevices import PUPDevice
+from pybricks.parameters import Port
+from pybricks.tools import StopWatch, wait
+
+DURATION = 2000
+
+
+# Gets the timestamps of history samples of the given size.
+def get_times(data, size):
+    return [int.from_bytes(data[i : i + 4], "little") for i in range(0, len(data), size)]
+
+
+# The Essential Hub has only ports A and B.
+ports = [getattr(Port, name, None) for name in ("A", "B", "C", "D", "E", "F")]
+
+for port in ports:
+    if port is None:
+        continue
+
+    try:
+        device = PUPDevice(port)
+    except OSError:
+        continue
+
+    # Make sure the device streams mode 0, and discard samples received
+    # before the measurement starts.
+    device.read(0)
+    device.read_history(0)
+
+    data = b""
+    watch = StopWatch()
+    while watch.time() < DURATION:
+        data += device.read_history(0)
+        wait(10)
+
+    times = get_times(data, device.info()["sample_sizes"][0])
+    if not times:
+        print(port, device.info()["id"], "no samples")
+        continue
+
+    gaps = [later - earlier for earlier, later in zip(times, times[1:])]
+    print(
+        port,
+        device.info()["id"],
+        len(times) * 1000 // DURATION,
+        "samples/s, longest gap",
+        max(gaps) if gaps else "-",
+        "ms",
+    )
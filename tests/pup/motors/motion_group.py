@@ -0,0 +1,48 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2023 The Pybricks Authors
+
+"""
+Hardware Module: Prime Hub, Inventor Hub or Technic Hub with motors on ports
+A and B.
+
+Description: Verifies that the motors of a MotionGroup start and finish
+together.
+"""
+
+from pybricks.pupdevices import Motor
+from pybricks.parameters import Port, Stop
+from pybricks.robotics import MotionGroup
+from pybricks.tools import StopWatch
+
+# Initialize the motors and the group.
+motor_a = Motor(Port.A)
+motor_b = Motor(Port.B)
+group = MotionGroup([motor_a, motor_b])
+assert group.motors == (motor_a, motor_b)
+
+# Motor B travels four times as far, so motor A is slowed down.
+motor_a.reset_angle(0)
+motor_b.reset_angle(0)
+group.run_angle(500, [90, 360], wait=False)
+
+# Halfway through, both motors should have covered about half the distance.
+watch = StopWatch()
+while not group.done():
+    if abs(motor_b.angle() - 180) < 10:
+        assert abs(motor_a.angle() - 45) < 10, "Motors are not synchronized."
+assert watch.time() < 2000
+assert abs(motor_a.angle() - 90) < 10
+assert abs(motor_b.angle() - 360) < 10
+
+# Run to absolute targets and coast when done.
+group.run_target(500, [0, 0], then=Stop.COAST)
+assert abs(motor_a.angle()) < 10
+assert abs(motor_b.angle()) < 10
+
+# Targets must be given for each motor.
+try:
+    group.run_target(500, [0])
+except ValueError:
+    pass
+else:
+    raise AssertionError("Expected ValueError.")